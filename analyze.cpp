@@ -0,0 +1,560 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "layout.h"
+#include "metrics.h"
+
+#define ANALYZE_BATCH_SIZE 4096
+#define ANALYZE_DEDUPE_SHARDS 64
+
+class LevelStats {
+    public:
+        long long boards;
+        long long duplicates;
+        long long sum_bbbv;
+        long long sum_zini;
+        int min_bbbv, max_bbbv;
+        int min_zini, max_zini;
+        std::vector<long long> bbbv_histogram;
+        std::vector<long long> zini_histogram;
+
+    public:
+        LevelStats();
+
+        void Add(const MineBoardMetrics &m);
+        void Merge(const LevelStats &other);
+};
+
+class BoardBatch {
+    public:
+        int level;
+        long long first;
+        int count;
+        std::vector<std::string> lines;
+};
+
+class CorpusAnalyzer {
+    public:
+        CorpusAnalyzer();
+        ~CorpusAnalyzer();
+
+        int ParseArguments(int argc, char **argv);
+        int Run();
+        void ShowHelp();
+
+    private:
+        void Worker();
+        bool PopBatch(BoardBatch &batch);
+        void PushBatch(BoardBatch &batch);
+        int ReadInput();
+        bool IsDuplicate(uint64_t hash, const MineBoardLayout &layout);
+        void Report(double seconds);
+
+        std::string LevelName(int width, int height, int mines);
+
+    private:
+        // options
+        std::vector<std::string> level_names;
+        long long count;
+        uint64_t seed;
+        int threads;
+        int bin;
+        bool per_board;
+        bool dump_layout;
+        bool dedupe;
+        bool with_zini;
+        std::string input;
+
+        // generated levels as (width, height, mines)
+        std::vector<int> level_size;
+
+        // work queue, generated batches are handed out by counter, file batches through the queue
+        std::atomic<long long> next_batch;
+        long long total_batches;
+        std::mutex queue_lock;
+        std::condition_variable queue_cond;
+        std::vector<BoardBatch> queue;
+        bool input_done;
+
+        // results
+        std::mutex result_lock;
+        std::map<std::string, LevelStats> stats;
+
+        // dedupe by layout, bucketed by hash
+        std::mutex dedupe_lock[ANALYZE_DEDUPE_SHARDS];
+        std::unordered_map<uint64_t, std::vector<MineBoardLayout> > dedupe_set[ANALYZE_DEDUPE_SHARDS];
+};
+
+////////////////////////////////////////////////////////////////////////////////////
+LevelStats::LevelStats()
+{
+    this->boards = 0;
+    this->duplicates = 0;
+    this->sum_bbbv = 0;
+    this->sum_zini = 0;
+    this->min_bbbv = 0;
+    this->max_bbbv = 0;
+    this->min_zini = 0;
+    this->max_zini = 0;
+}
+
+void LevelStats::Add(const MineBoardMetrics &m)
+{
+    if (this->boards == 0 || m.bbbv < this->min_bbbv) this->min_bbbv = m.bbbv;
+    if (this->boards == 0 || m.bbbv > this->max_bbbv) this->max_bbbv = m.bbbv;
+    if (this->boards == 0 || m.zini < this->min_zini) this->min_zini = m.zini;
+    if (this->boards == 0 || m.zini > this->max_zini) this->max_zini = m.zini;
+
+    if ((int)this->bbbv_histogram.size() <= m.bbbv) this->bbbv_histogram.resize(m.bbbv + 1, 0);
+    if ((int)this->zini_histogram.size() <= m.zini) this->zini_histogram.resize(m.zini + 1, 0);
+
+    this->bbbv_histogram[m.bbbv] += 1;
+    this->zini_histogram[m.zini] += 1;
+    this->sum_bbbv += m.bbbv;
+    this->sum_zini += m.zini;
+    this->boards += 1;
+}
+
+void LevelStats::Merge(const LevelStats &other)
+{
+    if (other.boards > 0) {
+        if (this->boards == 0 || other.min_bbbv < this->min_bbbv) this->min_bbbv = other.min_bbbv;
+        if (this->boards == 0 || other.max_bbbv > this->max_bbbv) this->max_bbbv = other.max_bbbv;
+        if (this->boards == 0 || other.min_zini < this->min_zini) this->min_zini = other.min_zini;
+        if (this->boards == 0 || other.max_zini > this->max_zini) this->max_zini = other.max_zini;
+    }
+
+    if (this->bbbv_histogram.size() < other.bbbv_histogram.size()) this->bbbv_histogram.resize(other.bbbv_histogram.size(), 0);
+    if (this->zini_histogram.size() < other.zini_histogram.size()) this->zini_histogram.resize(other.zini_histogram.size(), 0);
+
+    for (size_t i = 0; i < other.bbbv_histogram.size(); i++) this->bbbv_histogram[i] += other.bbbv_histogram[i];
+    for (size_t i = 0; i < other.zini_histogram.size(); i++) this->zini_histogram[i] += other.zini_histogram[i];
+
+    this->boards += other.boards;
+    this->duplicates += other.duplicates;
+    this->sum_bbbv += other.sum_bbbv;
+    this->sum_zini += other.sum_zini;
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+CorpusAnalyzer::CorpusAnalyzer()
+{
+    this->count = 100000;
+    this->seed = 1;
+    this->threads = (int)std::thread::hardware_concurrency();
+    this->bin = 5;
+    this->per_board = false;
+    this->dump_layout = false;
+    this->dedupe = true;
+    this->with_zini = true;
+    this->next_batch = 0;
+    this->total_batches = 0;
+    this->input_done = false;
+
+    if (this->threads <= 0) {
+        this->threads = 1;
+    }
+}
+
+CorpusAnalyzer::~CorpusAnalyzer()
+{
+
+}
+
+int CorpusAnalyzer::ParseArguments(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = (i + 1 < argc);
+
+        if (arg == "--level" && has_value) {
+            this->level_names.push_back(argv[++i]);
+        } else if (arg == "--count" && has_value) {
+            this->count = std::atoll(argv[++i]);
+        } else if (arg == "--seed" && has_value) {
+            this->seed = std::strtoull(argv[++i], NULL, 10);
+        } else if (arg == "--threads" && has_value) {
+            this->threads = std::atoi(argv[++i]);
+        } else if (arg == "--bin" && has_value) {
+            this->bin = std::atoi(argv[++i]);
+        } else if (arg == "--input" && has_value) {
+            this->input = argv[++i];
+        } else if (arg == "--per-board") {
+            this->per_board = true;
+        } else if (arg == "--layout") {
+            this->dump_layout = true;
+        } else if (arg == "--no-dedupe") {
+            this->dedupe = false;
+        } else if (arg == "--no-zini") {
+            this->with_zini = false;
+        } else {
+            return -1;
+        }
+    }
+
+    if (this->level_names.empty()) {
+        this->level_names.push_back("beginner");
+        this->level_names.push_back("intermediate");
+        this->level_names.push_back("expert");
+    }
+
+    for (size_t i = 0; i < this->level_names.size(); i++) {
+        const std::string &name = this->level_names[i];
+        int w, h, m;
+
+        if (name == "beginner") {
+            w = 9; h = 9; m = 10;
+        } else if (name == "intermediate") {
+            w = 16; h = 16; m = 40;
+        } else if (name == "expert") {
+            w = 30; h = 16; m = 99;
+        } else if (std::sscanf(name.c_str(), "%dx%dx%d", &w, &h, &m) != 3 || w <= 0 || h <= 0 || m < 0 || m >= w * h) {
+            std::cerr << "unknown level " << name << std::endl;
+            return -1;
+        }
+
+        this->level_size.push_back(w);
+        this->level_size.push_back(h);
+        this->level_size.push_back(m);
+    }
+
+    this->threads = (this->threads <= 0) ? 1 : this->threads;
+    this->bin = (this->bin <= 0) ? 1 : this->bin;
+
+    return 0;
+}
+
+int CorpusAnalyzer::Run()
+{
+    std::vector<std::thread> workers;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int ret = 0;
+
+    if (this->input.empty()) {
+        long long per_level = (this->count + ANALYZE_BATCH_SIZE - 1) / ANALYZE_BATCH_SIZE;
+        this->total_batches = per_level * (long long)this->level_names.size();
+    }
+
+    for (int i = 0; i < this->threads; i++) {
+        workers.push_back(std::thread(&CorpusAnalyzer::Worker, this));
+    }
+
+    if (!this->input.empty()) {
+        ret = this->ReadInput();
+    }
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+
+    if (ret != 0) {
+        return 1;
+    }
+
+    std::chrono::duration<double> elapse = std::chrono::steady_clock::now() - start;
+    this->Report(elapse.count());
+
+    return 0;
+}
+
+int CorpusAnalyzer::ReadInput()
+{
+    std::istream *in = &std::cin;
+    std::ifstream file;
+    BoardBatch batch;
+    std::string line;
+    long long index = 0;
+
+    if (this->input != "-") {
+        file.open(this->input.c_str());
+        if (!file) {
+            std::cerr << "failed to open " << this->input << std::endl;
+
+            // still release the workers waiting on the queue
+            std::unique_lock<std::mutex> lock(this->queue_lock);
+            this->input_done = true;
+            this->queue_cond.notify_all();
+
+            return -1;
+        }
+
+        in = &file;
+    }
+
+    batch.level = -1;
+    batch.first = 0;
+    batch.count = 0;
+
+    while (std::getline(*in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        batch.lines.push_back(line);
+        batch.count += 1;
+
+        if (batch.count == ANALYZE_BATCH_SIZE) {
+            this->PushBatch(batch);
+            index += batch.count;
+            batch.lines.clear();
+            batch.first = index;
+            batch.count = 0;
+        }
+    }
+
+    if (batch.count > 0) {
+        this->PushBatch(batch);
+    }
+
+    std::unique_lock<std::mutex> lock(this->queue_lock);
+    this->input_done = true;
+    this->queue_cond.notify_all();
+
+    return 0;
+}
+
+void CorpusAnalyzer::PushBatch(BoardBatch &batch)
+{
+    std::unique_lock<std::mutex> lock(this->queue_lock);
+
+    // bounded, the reader waits for the workers instead of loading the whole file
+    while (this->queue.size() >= (size_t)this->threads * 2) {
+        this->queue_cond.wait(lock);
+    }
+
+    this->queue.push_back(batch);
+    this->queue_cond.notify_all();
+}
+
+bool CorpusAnalyzer::PopBatch(BoardBatch &batch)
+{
+    // generated boards: the batch number decides level and board indices
+    if (this->input.empty()) {
+        long long n = this->next_batch++;
+        long long per_level = this->total_batches / (long long)this->level_names.size();
+
+        if (n >= this->total_batches) {
+            return false;
+        }
+
+        batch.level = (int)(n / per_level);
+        batch.first = (n % per_level) * ANALYZE_BATCH_SIZE;
+        batch.count = (int)std::min((long long)ANALYZE_BATCH_SIZE, this->count - batch.first);
+
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock(this->queue_lock);
+
+    while (this->queue.empty() && !this->input_done) {
+        this->queue_cond.wait(lock);
+    }
+
+    if (this->queue.empty()) {
+        return false;
+    }
+
+    batch.lines.swap(this->queue.back().lines);
+    batch.level = this->queue.back().level;
+    batch.first = this->queue.back().first;
+    batch.count = this->queue.back().count;
+    this->queue.pop_back();
+    this->queue_cond.notify_all();
+
+    return true;
+}
+
+bool CorpusAnalyzer::IsDuplicate(uint64_t hash, const MineBoardLayout &layout)
+{
+    int shard = (int)(hash >> 58) % ANALYZE_DEDUPE_SHARDS;
+    std::unique_lock<std::mutex> lock(this->dedupe_lock[shard]);
+    std::vector<MineBoardLayout> &seen = this->dedupe_set[shard][hash];
+
+    // equal hashes are only a hint, the layouts decide
+    for (size_t i = 0; i < seen.size(); i++) {
+        if (seen[i].IsSame(layout)) {
+            return true;
+        }
+    }
+
+    seen.push_back(layout);
+
+    return false;
+}
+
+std::string CorpusAnalyzer::LevelName(int width, int height, int mines)
+{
+    char name[64];
+
+    for (size_t i = 0; i < this->level_names.size(); i++) {
+        if (this->level_size[i * 3] == width && this->level_size[i * 3 + 1] == height && this->level_size[i * 3 + 2] == mines) {
+            return this->level_names[i];
+        }
+    }
+
+    std::snprintf(name, sizeof(name), "%dx%dx%d", width, height, mines);
+    return name;
+}
+
+void CorpusAnalyzer::Worker()
+{
+    MineBoardAnalyzer analyzer;
+    MineBoardLayout layout;
+    MineBoardMetrics metrics;
+    MineRandom random;
+    std::map<std::string, LevelStats> local;
+    std::string output;
+    BoardBatch batch;
+
+    while (this->PopBatch(batch)) {
+        for (int i = 0; i < batch.count; i++) {
+            std::string level;
+
+            if (this->input.empty()) {
+                // every board has its own seed, so results do not depend on the thread count
+                random.Seed(this->seed ^ ((uint64_t)batch.level << 48) ^ (uint64_t)(batch.first + i) * 0x9E3779B97F4A7C15ULL);
+                layout.Generate(this->level_size[batch.level * 3], this->level_size[batch.level * 3 + 1], this->level_size[batch.level * 3 + 2], random);
+                level = this->level_names[batch.level];
+            } else {
+                if (!layout.FromString(batch.lines[i].c_str())) {
+                    std::cerr << "skip malformed board " << (batch.first + i) << std::endl;
+                    continue;
+                }
+
+                level = this->LevelName(layout.GetWidth(), layout.GetHeight(), layout.GetMineCount());
+            }
+
+            uint64_t hash = layout.GetHash();
+            LevelStats &s = local[level];
+
+            if (this->dedupe && this->IsDuplicate(hash, layout)) {
+                s.duplicates += 1;
+                continue;
+            }
+
+            analyzer.Analyze(layout, metrics, this->with_zini);
+            s.Add(metrics);
+
+            if (this->per_board) {
+                char line[160];
+
+                std::snprintf(line, sizeof(line), "%s %lld %016llx %d %d %d %d", level.c_str(), batch.first + i, (unsigned long long)hash,
+                              metrics.bbbv, metrics.zini, metrics.openings, metrics.islands);
+                output += line;
+
+                if (this->dump_layout) {
+                    output += ' ';
+                    output += layout.ToString();
+                }
+
+                output += '\n';
+            }
+        }
+
+        if (!output.empty()) {
+            std::unique_lock<std::mutex> lock(this->result_lock);
+
+            std::fwrite(output.data(), 1, output.size(), stdout);
+            output.clear();
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(this->result_lock);
+
+    for (std::map<std::string, LevelStats>::iterator it = local.begin(); it != local.end(); ++it) {
+        this->stats[it->first].Merge(it->second);
+    }
+}
+
+void CorpusAnalyzer::Report(double seconds)
+{
+    long long total = 0;
+
+    std::fflush(stdout);
+
+    for (std::map<std::string, LevelStats>::iterator it = this->stats.begin(); it != this->stats.end(); ++it) {
+        const LevelStats &s = it->second;
+        double boards = (s.boards > 0) ? (double)s.boards : 1.0;
+
+        total += s.boards + s.duplicates;
+
+        std::printf("# level %s boards %lld duplicates %lld\n", it->first.c_str(), s.boards, s.duplicates);
+        std::printf("# 3bv min %d max %d mean %.2f\n", s.min_bbbv, s.max_bbbv, s.sum_bbbv / boards);
+
+        if (this->with_zini) {
+            std::printf("# zini min %d max %d mean %.2f\n", s.min_zini, s.max_zini, s.sum_zini / boards);
+        }
+
+        for (int pass = 0; pass < (this->with_zini ? 2 : 1); pass++) {
+            const std::vector<long long> &h = (pass == 0) ? s.bbbv_histogram : s.zini_histogram;
+
+            for (size_t v = 0; v < h.size(); v += this->bin) {
+                long long n = 0;
+
+                for (size_t k = v; k < v + this->bin && k < h.size(); k++) {
+                    n += h[k];
+                }
+
+                if (n > 0) {
+                    std::printf("# %s %s %zu-%zu %lld\n", (pass == 0) ? "3bv" : "zini", it->first.c_str(), v, v + this->bin - 1, n);
+                }
+            }
+        }
+    }
+
+    std::printf("# %lld boards in %.3fs on %d threads, %.0f boards/s\n", total, seconds, this->threads, total / (seconds > 0 ? seconds : 1));
+}
+
+void CorpusAnalyzer::ShowHelp()
+{
+    std::cout << "Minesweeper board corpus analyzer" << std::endl;
+    std::cout << std::endl;
+    std::cout << "mine-analyze [options]" << std::endl;
+    std::cout << std::endl;
+    std::cout << "--level <name>           beginner, intermediate, expert or <w>x<h>x<m>, can be repeated (default: all three)" << std::endl;
+    std::cout << "--count <n>              Boards to generate per level (default: 100000)." << std::endl;
+    std::cout << "--seed <n>               Seed of the generated boards (default: 1)." << std::endl;
+    std::cout << "--input <file>           Analyze stored boards instead, one \"<w> <h> <m> <hex>\" per line, - for stdin." << std::endl;
+    std::cout << "--threads <n>            Worker threads (default: all cores)." << std::endl;
+    std::cout << "--bin <n>                Histogram bin width (default: 5)." << std::endl;
+    std::cout << "--per-board              Print \"<level> <index> <hash> <3bv> <zini> <openings> <islands>\" per board." << std::endl;
+    std::cout << "--layout                 Append the board in input format to per board lines." << std::endl;
+    std::cout << "--no-dedupe              Keep boards with the same layout." << std::endl;
+    std::cout << "--no-zini                Skip the greedy ZiNi search." << std::endl;
+    std::cout << std::endl;
+    std::cout << "Summary and histogram lines start with #." << std::endl;
+}
+
+//////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+    CorpusAnalyzer *analyzer;
+    int ret;
+
+    analyzer = new CorpusAnalyzer();
+
+    if (analyzer->ParseArguments(argc, argv) != 0) {
+        analyzer->ShowHelp();
+        delete analyzer;
+        return 1;
+    }
+
+    ret = analyzer->Run();
+
+    delete analyzer;
+
+    return ret;
+}
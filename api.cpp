@@ -0,0 +1,196 @@
+#include <new>
+#include <vector>
+#include "mine_api.h"
+#include "game.h"
+
+// NOTE: the handle owns the game and the buffers used to translate between C and C++ types,
+// no exception leaves this file
+struct mine_game {
+    MineGame game;
+    std::vector<MineGameGrid> delta;
+};
+
+static int mine_apply_one(mine_game_t *game, int op, int x, int y)
+{
+    MineGameMove move;
+
+    move.op = (MineGameMove::Op)op;
+    move.x = x;
+    move.y = y;
+
+    return (int)game->game.ApplyMove(move);
+}
+
+static bool mine_valid_size(int width, int height, int mine_count)
+{
+    return width > 0 && height > 0 && mine_count >= 0 && (long long)mine_count < (long long)width * height;
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+
+int mine_api_version(void)
+{
+    return MINE_API_VERSION;
+}
+
+mine_game_t *mine_create(int width, int height, int mine_count)
+{
+    if (!mine_valid_size(width, height, mine_count)) {
+        return NULL;
+    }
+
+    mine_game_t *game = new (std::nothrow) mine_game_t;
+
+    if (game == NULL) {
+        return NULL;
+    }
+
+    try {
+        game->game.SetVerbose(false);
+        game->game.SetCustom(width, height, mine_count);
+        game->delta.reserve(game->game.GetWidth() * game->game.GetHeight());
+    } catch (...) {
+        delete game;
+        return NULL;
+    }
+
+    return game;
+}
+
+void mine_destroy(mine_game_t *game)
+{
+    delete game;
+}
+
+void mine_seed(mine_game_t *game, uint64_t seed)
+{
+    game->game.SetSeed(seed);
+}
+
+void mine_reset(mine_game_t *game)
+{
+    game->game.Reset();
+}
+
+int mine_set_size(mine_game_t *game, int width, int height, int mine_count)
+{
+    if (!mine_valid_size(width, height, mine_count)) {
+        return -1;
+    }
+
+    try {
+        game->game.SetCustom(width, height, mine_count);
+        game->delta.reserve(game->game.GetWidth() * game->game.GetHeight());
+    } catch (...) {
+        // SetCustom frees the old maps first, so fall back to the beginner board instead of half allocated ones
+        try {
+            game->game.SetCustom(9, 9, 10);
+        } catch (...) {
+            // nothing smaller to fall back to
+        }
+
+        return -1;
+    }
+
+    return 0;
+}
+
+int mine_open(mine_game_t *game, int x, int y)
+{
+    return mine_apply_one(game, MINE_MOVE_OPEN, x, y);
+}
+
+int mine_flag(mine_game_t *game, int x, int y)
+{
+    return mine_apply_one(game, MINE_MOVE_FLAG, x, y);
+}
+
+int mine_chord(mine_game_t *game, int x, int y)
+{
+    return mine_apply_one(game, MINE_MOVE_CHORD, x, y);
+}
+
+int mine_apply(mine_game_t *game, const mine_move_t *moves, int count, int32_t *outcomes)
+{
+    int applied = 0;
+
+    for (int i = 0; i < count; i++) {
+        outcomes[i] = mine_apply_one(game, moves[i].op, moves[i].x, moves[i].y);
+
+        if (outcomes[i] != MINE_OUTCOME_SKIPPED) {
+            applied += 1;
+        }
+    }
+
+    return applied;
+}
+
+int mine_fetch_delta(mine_game_t *game, mine_cell_t *cells, int capacity)
+{
+    int n = 0;
+
+    game->delta.clear();
+    game->game.GetDirtyGrids(game->delta);
+
+    if ((int)game->delta.size() > capacity) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < game->delta.size(); i++, n++) {
+        cells[n].x = game->delta[i].x;
+        cells[n].y = game->delta[i].y;
+        cells[n].state = game->delta[i].state;
+    }
+
+    game->game.ClearDirtyGrids();
+
+    return n;
+}
+
+const uint8_t *mine_state(const mine_game_t *game, int *stride)
+{
+    const uint8_t *state = game->game.GetStateBuffer();
+    int s = game->game.GetStride();
+
+    // no buffer after a failed allocation
+    if (state == NULL) {
+        return NULL;
+    }
+
+    if (stride != NULL) {
+        *stride = s;
+    }
+
+    // skip the sentinel row and column, so (0, 0) is the first byte
+    return state + s + 1;
+}
+
+int mine_width(const mine_game_t *game)
+{
+    return game->game.GetWidth();
+}
+
+int mine_height(const mine_game_t *game)
+{
+    return game->game.GetHeight();
+}
+
+int mine_mine_count(const mine_game_t *game)
+{
+    return game->game.GetMineCount();
+}
+
+int mine_flag_count(const mine_game_t *game)
+{
+    return game->game.GetFlagCount();
+}
+
+int mine_remaining_count(const mine_game_t *game)
+{
+    return game->game.GetRemainingCount();
+}
+
+int mine_game_state(const mine_game_t *game)
+{
+    return (int)game->game.GetGameState();
+}
@@ -0,0 +1,664 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include "layout.h"
+#include "game.h"
+#include "supply.h"
+#include "env.h"
+#include "mine_api.h"
+#include "share.h"
+
+class MineBench {
+    public:
+        MineBench();
+        ~MineBench();
+
+        int ParseArguments(int argc, char **argv);
+        int Run();
+        void ShowHelp();
+
+    private:
+        int FirstClick(const std::string &name, int width, int height, int mine_count);
+        int ApplyMoves(const std::string &name, int width, int height, int mine_count);
+        int VectorEnv(const std::string &name, int width, int height, int mine_count);
+        int CApi(const std::string &name, int width, int height, int mine_count);
+        int CmdStream(const std::string &name, int width, int height, int mine_count);
+        int SharedBoard(const std::string &name, int width, int height, int mine_count);
+        void SharedBoardHost(MineSharedBoard *share, MineGame *game, std::atomic<bool> *running);
+        void Report(const char *test, const std::string &name, const char *mode, std::vector<double> &samples);
+
+    private:
+        // options
+        std::string test;
+        std::vector<std::string> level_names;
+        int count;
+        uint64_t seed;
+        int min_bbbv;
+        int max_bbbv;
+        int batch;
+        int threads;
+        int steps;
+        bool onehot;
+        bool verbose;
+        std::string cmd_path;
+
+        // levels as (width, height, mines)
+        std::vector<int> level_size;
+};
+
+////////////////////////////////////////////////////////////////////////////////////
+MineBench::MineBench()
+{
+    this->count = 1000;
+    this->seed = 1;
+    this->min_bbbv = 0;
+    this->max_bbbv = -1;
+    this->batch = 16;
+    this->threads = 0;
+    this->steps = 1000;
+    this->onehot = false;
+    this->verbose = false;
+}
+
+MineBench::~MineBench()
+{
+
+}
+
+int MineBench::ParseArguments(int argc, char **argv)
+{
+    if (argc < 2) {
+        return -1;
+    }
+
+    this->test = argv[1];
+
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = (i + 1 < argc);
+
+        if (arg == "--level" && has_value) {
+            this->level_names.push_back(argv[++i]);
+        } else if (arg == "--count" && has_value) {
+            this->count = std::atoi(argv[++i]);
+        } else if (arg == "--seed" && has_value) {
+            this->seed = std::strtoull(argv[++i], NULL, 10);
+        } else if (arg == "--range" && has_value) {
+            if (std::sscanf(argv[++i], "%d-%d", &this->min_bbbv, &this->max_bbbv) != 2 || this->min_bbbv < 0 || this->max_bbbv < this->min_bbbv) {
+                std::cerr << "bad range " << argv[i] << std::endl;
+                return -1;
+            }
+        } else if (arg == "--batch" && has_value) {
+            this->batch = std::atoi(argv[++i]);
+        } else if (arg == "--threads" && has_value) {
+            this->threads = std::atoi(argv[++i]);
+        } else if (arg == "--steps" && has_value) {
+            this->steps = std::atoi(argv[++i]);
+        } else if (arg == "--onehot") {
+            this->onehot = true;
+        } else if (arg == "--verbose") {
+            this->verbose = true;
+        } else if (arg == "--cmd" && has_value) {
+            this->cmd_path = argv[++i];
+        } else {
+            return -1;
+        }
+    }
+
+    if (this->test != "first-click" && this->test != "apply-moves" && this->test != "vector-env" && this->test != "c-api" && this->test != "shared-board") {
+        std::cerr << "unknown test " << this->test << std::endl;
+        return -1;
+    }
+
+    if (this->level_names.empty()) {
+        this->level_names.push_back("beginner");
+        this->level_names.push_back("intermediate");
+        this->level_names.push_back("expert");
+    }
+
+    for (size_t i = 0; i < this->level_names.size(); i++) {
+        const std::string &name = this->level_names[i];
+        int w, h, m;
+
+        if (name == "beginner") {
+            w = 9; h = 9; m = 10;
+        } else if (name == "intermediate") {
+            w = 16; h = 16; m = 40;
+        } else if (name == "expert") {
+            w = 30; h = 16; m = 99;
+        } else if (std::sscanf(name.c_str(), "%dx%dx%d", &w, &h, &m) != 3 || w <= 0 || h <= 0 || m < 0 || m >= w * h) {
+            std::cerr << "unknown level " << name << std::endl;
+            return -1;
+        }
+
+        this->level_size.push_back(w);
+        this->level_size.push_back(h);
+        this->level_size.push_back(m);
+    }
+
+    this->count = (this->count <= 0) ? 1 : this->count;
+    this->batch = (this->batch <= 0) ? 1 : this->batch;
+
+    return 0;
+}
+
+int MineBench::Run()
+{
+    for (size_t i = 0; i < this->level_names.size(); i++) {
+        int *size = &this->level_size[i * 3];
+
+        int ret;
+
+        if (this->test == "first-click") {
+            ret = this->FirstClick(this->level_names[i], size[0], size[1], size[2]);
+        } else if (this->test == "apply-moves") {
+            ret = this->ApplyMoves(this->level_names[i], size[0], size[1], size[2]);
+        } else if (this->test == "vector-env") {
+            ret = this->VectorEnv(this->level_names[i], size[0], size[1], size[2]);
+        } else if (this->test == "shared-board") {
+            ret = this->SharedBoard(this->level_names[i], size[0], size[1], size[2]);
+        } else {
+            ret = this->CApi(this->level_names[i], size[0], size[1], size[2]);
+
+            if (ret == 0 && !this->cmd_path.empty()) {
+                ret = this->CmdStream(this->level_names[i], size[0], size[1], size[2]);
+            }
+        }
+
+        if (ret != 0) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int MineBench::FirstClick(const std::string &name, int width, int height, int mine_count)
+{
+    int depth = 4;
+
+    // pass 0 generates the board inside Open (the supply is never started), pass 1 takes it from a supply that had time to refill
+    for (int pass = 0; pass < 2; pass++) {
+        MineGame game;
+        MineBoardSupply supply;
+        MineRandom random(this->seed);
+        std::vector<double> samples;
+
+        game.SetVerbose(this->verbose);
+        game.SetSeed(this->seed);
+        game.SetCustom(width, height, mine_count);
+        game.SetBoardSupply(&supply);
+
+        supply.AddLevel(game.GetWidth(), game.GetHeight(), game.GetMineCount(), this->min_bbbv, this->max_bbbv, depth);
+
+        if (pass == 1) {
+            supply.Start(this->seed);
+        }
+
+        for (int i = 0; i < this->count; i++) {
+            int x = (int)random.NextBelow((uint32_t)game.GetWidth());
+            int y = (int)random.NextBelow((uint32_t)game.GetHeight());
+
+            game.Reset();
+
+            // a human does not click faster than the producer refills, wait for a full queue like they would
+            while (pass == 1 && supply.GetReadyCount(game.GetWidth(), game.GetHeight(), game.GetMineCount()) < depth) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            game.Open(x, y);
+            std::chrono::duration<double, std::micro> elapse = std::chrono::steady_clock::now() - start;
+
+            if (game.GetGameState() == MineGame::State::GAME_LOST) {
+                std::cerr << "first click at (" << x << ", " << y << ") hit a mine" << std::endl;
+                return -1;
+            }
+
+            samples.push_back(elapse.count());
+        }
+
+        this->Report("first-click", name, (pass == 0) ? "inline" : "supply", samples);
+
+        if (pass == 1 && supply.GetMissCount() > 0) {
+            std::printf("# first-click %s supply ran dry %lld times\n", name.c_str(), supply.GetMissCount());
+        }
+    }
+
+    return 0;
+}
+
+int MineBench::ApplyMoves(const std::string &name, int width, int height, int mine_count)
+{
+    // a bot that knows the board: after the first click it opens every safe grid and flags every mine in random order
+    // pass 0 makes one call per move and fetches the delta after each, pass 1 sends batches to ApplyMoves
+    for (int pass = 0; pass < 2; pass++) {
+        MineGame game;
+        MineBoardLayout layout;
+        MineRandom random(this->seed);
+        std::vector<MineGameMove> moves;
+        std::vector<MineGameMove::Outcome> outcomes;
+        std::vector<MineGameGrid> delta;
+        long long total = 0, won = 0;
+        double seconds = 0;
+
+        game.SetVerbose(this->verbose);
+        game.SetCustom(width, height, mine_count);
+
+        for (int i = 0; i < this->count; i++) {
+            game.SetSeed(this->seed + i);
+            game.Reset();
+            game.Open(game.GetWidth() / 2, game.GetHeight() / 2);
+            game.ClearDirtyGrids();
+            game.GetMineLayout(layout);
+
+            moves.clear();
+
+            for (int y = 0; y < game.GetHeight(); y++) {
+                for (int x = 0; x < game.GetWidth(); x++) {
+                    MineGameMove move;
+
+                    move.op = layout.HasMine(x, y) ? MineGameMove::Op::MOVE_FLAG : MineGameMove::Op::MOVE_OPEN;
+                    move.x = x;
+                    move.y = y;
+                    moves.push_back(move);
+                }
+            }
+
+            for (size_t k = moves.size() - 1; k > 0; k--) {
+                std::swap(moves[k], moves[random.NextBelow((uint32_t)(k + 1))]);
+            }
+
+            outcomes.resize(moves.size());
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+            if (pass == 0) {
+                for (size_t k = 0; k < moves.size(); k++) {
+                    if (moves[k].op == MineGameMove::Op::MOVE_FLAG) {
+                        game.TouchFlag(moves[k].x, moves[k].y);
+                    } else {
+                        game.Open(moves[k].x, moves[k].y);
+                    }
+
+                    delta.clear();
+                    game.GetDirtyGrids(delta);
+                    game.ClearDirtyGrids();
+                }
+            } else {
+                for (size_t k = 0; k < moves.size(); k += this->batch) {
+                    int n = (int)std::min(moves.size() - k, (size_t)this->batch);
+
+                    game.ApplyMoves(&moves[k], n, &outcomes[k], delta);
+                }
+            }
+
+            std::chrono::duration<double> elapse = std::chrono::steady_clock::now() - start;
+
+            seconds += elapse.count();
+            total += (long long)moves.size();
+            won += (game.GetGameState() == MineGame::State::GAME_WON) ? 1 : 0;
+        }
+
+        std::fflush(stdout);
+        std::printf("# apply-moves %s %s moves %lld games won %lld/%d %.3fs %.0f moves/s\n", name.c_str(), (pass == 0) ? "per-move" : "batch",
+                    total, won, this->count, seconds, total / (seconds > 0 ? seconds : 1));
+    }
+
+    return 0;
+}
+
+int MineBench::VectorEnv(const std::string &name, int width, int height, int mine_count)
+{
+    MineVectorEnv env;
+    MineRandom random(this->seed);
+    long long episodes = 0, wins = 0;
+    double seconds = 0;
+
+    // --count boards stepped --steps times with random open actions
+    if (env.Create(this->count, width, height, mine_count, this->threads) != 0) {
+        return -1;
+    }
+
+    env.Seed(this->seed);
+    env.SetObservation(this->onehot ? MineVectorEnv::Observation::OBS_ONEHOT : MineVectorEnv::Observation::OBS_COUNT);
+
+    std::vector<float> observations((size_t)env.GetBoardCount() * env.GetObservationSize());
+    std::vector<float> rewards(env.GetBoardCount());
+    std::vector<unsigned char> dones(env.GetBoardCount());
+    std::vector<int> actions(env.GetBoardCount());
+
+    env.Reset(&observations[0]);
+
+    for (int i = 0; i < this->steps; i++) {
+        for (int b = 0; b < env.GetBoardCount(); b++) {
+            actions[b] = (int)random.NextBelow((uint32_t)(width * height));
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        env.Step(&actions[0], &observations[0], &rewards[0], &dones[0]);
+        std::chrono::duration<double> elapse = std::chrono::steady_clock::now() - start;
+
+        seconds += elapse.count();
+
+        for (int b = 0; b < env.GetBoardCount(); b++) {
+            episodes += dones[b];
+            wins += (dones[b] && rewards[b] > 0) ? 1 : 0;
+        }
+    }
+
+    long long total = (long long)this->steps * env.GetBoardCount();
+
+    std::fflush(stdout);
+    std::printf("# vector-env %s boards %d threads %d %s steps %lld episodes %lld wins %lld %.3fs %.0f steps/s %.0f calls/s\n", name.c_str(),
+                env.GetBoardCount(), this->threads, this->onehot ? "onehot" : "count", total, episodes, wins, seconds,
+                total / (seconds > 0 ? seconds : 1), this->steps / (seconds > 0 ? seconds : 1));
+
+    return 0;
+}
+
+int MineBench::CApi(const std::string &name, int width, int height, int mine_count)
+{
+    mine_game_t *game = mine_create(width, height, mine_count);
+    MineRandom random(this->seed);
+    std::vector<mine_cell_t> cells(width * height);
+    long long calls = 0, cells_read = 0, games = 0;
+
+    if (game == NULL) {
+        std::cerr << "mine_create(" << width << ", " << height << ", " << mine_count << ") failed" << std::endl;
+        return -1;
+    }
+
+    // --count * --steps random opens and flags through the C interface, each followed by a delta fetch
+    mine_seed(game, this->seed);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (long long i = 0; i < (long long)this->count * this->steps; i++) {
+        int x = (int)random.NextBelow((uint32_t)width);
+        int y = (int)random.NextBelow((uint32_t)height);
+        int outcome = (random.NextBelow(8) == 0) ? mine_flag(game, x, y) : mine_open(game, x, y);
+
+        cells_read += mine_fetch_delta(game, &cells[0], (int)cells.size());
+        calls += 2;
+
+        if (outcome == MINE_OUTCOME_LOST || outcome == MINE_OUTCOME_WON) {
+            mine_reset(game);
+            games += 1;
+        }
+    }
+
+    std::chrono::duration<double> elapse = std::chrono::steady_clock::now() - start;
+    double seconds = elapse.count();
+    long long moves = (long long)this->count * this->steps;
+
+    mine_destroy(game);
+
+    std::fflush(stdout);
+    std::printf("# c-api %s moves %lld games %lld cells %lld %.3fs %.0f moves/s %.0f calls/s\n", name.c_str(), moves, games, cells_read, seconds,
+                moves / (seconds > 0 ? seconds : 1), calls / (seconds > 0 ? seconds : 1));
+
+    return 0;
+}
+
+int MineBench::CmdStream(const std::string &name, int width, int height, int mine_count)
+{
+    long long moves = (long long)this->count * this->steps;
+
+    // the same number of moves piped to mine-cmd, pass 0 in the interactive mode which redraws after every move,
+    // pass 1 in --batch mode which replies one line per move
+    // NOTE: this is one way, mine-cmd never waits for a reader, so it is a lower bound of a request/response loop
+    for (int pass = 0; pass < 2; pass++) {
+        MineRandom random(this->seed);
+        std::string command = "\"" + this->cmd_path + "\"" + ((pass == 0) ? "" : " --batch");
+
+#ifdef _WIN32
+        command += " > NUL";
+#else
+        command += " > /dev/null";
+#endif
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        FILE *pipe = popen(command.c_str(), "w");
+
+        if (pipe == NULL) {
+            std::cerr << "cannot run " << this->cmd_path << std::endl;
+            return -1;
+        }
+
+        std::fprintf(pipe, "set-game %d %d %d\n", width, height, mine_count);
+
+        for (long long i = 0; i < moves; i++) {
+            int x = (int)random.NextBelow((uint32_t)width);
+            int y = (int)random.NextBelow((uint32_t)height);
+
+            std::fprintf(pipe, "%s %d %d\n", (random.NextBelow(8) == 0) ? "f" : "o", x, y);
+
+            // the interactive mode has no outcome to look at, reset every few moves instead
+            if (i % 16 == 15) {
+                std::fprintf(pipe, "reset\n");
+            }
+        }
+
+        std::fprintf(pipe, "quit\n");
+
+        if (pclose(pipe) != 0) {
+            std::cerr << this->cmd_path << " failed" << std::endl;
+            return -1;
+        }
+
+        std::chrono::duration<double> elapse = std::chrono::steady_clock::now() - start;
+        double seconds = elapse.count();
+
+        std::fflush(stdout);
+        std::printf("# c-api %s mine-cmd%s moves %lld %.3fs %.0f moves/s\n", name.c_str(), (pass == 0) ? "" : " --batch", moves, seconds,
+                    moves / (seconds > 0 ? seconds : 1));
+    }
+
+    return 0;
+}
+
+int MineBench::SharedBoard(const std::string &name, int width, int height, int mine_count)
+{
+    MineSharedBoard host, client;
+    MineShareSnapshot snapshot;
+    MineGame game;
+    MineRandom random(this->seed);
+    std::atomic<bool> running(true);
+    std::vector<double> samples;
+    std::vector<unsigned char> grids;
+    long long reads = 0;
+
+    game.SetVerbose(this->verbose);
+    game.SetSeed(this->seed);
+    game.SetCustom(width, height, mine_count);
+
+    // host and client are in one process here, they only talk through the segment as separate processes would
+    if (host.Create("mine-bench", game.GetWidth(), game.GetHeight(), 64) != 0 || client.Attach("mine-bench") != 0) {
+        return -1;
+    }
+
+    host.Publish(&game);
+    grids.resize(client.GetMaxWidth() * client.GetMaxHeight());
+
+    std::thread thread(&MineBench::SharedBoardHost, this, &host, &game, &running);
+
+    // round trips: a flag toggled on a covered grid always changes the board, time it until it is published
+    while ((int)samples.size() < this->count) {
+        client.Read(snapshot, &grids[0]);
+
+        MineShareCommand command;
+        uint64_t before = snapshot.change_count;
+
+        if (snapshot.game_state != MineGame::State::GAME_RUNNING) {
+            command.op = (snapshot.game_state == MineGame::State::GAME_READY) ? (int)MineGameMove::Op::MOVE_OPEN : MINE_SHARE_RESET;
+            command.x = snapshot.width / 2;
+            command.y = snapshot.height / 2;
+        } else {
+            int z;
+
+            do {
+                z = (int)random.NextBelow((uint32_t)(snapshot.width * snapshot.height));
+            } while (grids[z] != MineGameGrid::State::STATE_COVERED && grids[z] != MineGameGrid::State::STATE_FLAGGED);
+
+            command.op = (random.NextBelow(4) == 0) ? (int)MineGameMove::Op::MOVE_OPEN : (int)MineGameMove::Op::MOVE_FLAG;
+            command.x = z % snapshot.width;
+            command.y = z / snapshot.width;
+
+            // an open on a flag does nothing and would never be published
+            command.op = (grids[z] == MineGameGrid::State::STATE_FLAGGED) ? (int)MineGameMove::Op::MOVE_FLAG : command.op;
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        while (!client.Send(command)) {
+            std::this_thread::yield();
+        }
+
+        // NOTE: yield while waiting, with fewer cores than threads a pure spin starves the host for a whole time slice
+        while (true) {
+            client.Read(snapshot, NULL);
+            reads += 1;
+
+            if (snapshot.change_count != before) {
+                break;
+            }
+
+            std::this_thread::yield();
+        }
+
+        std::chrono::duration<double, std::micro> elapse = std::chrono::steady_clock::now() - start;
+
+        // only moves on a running board, a reset or first click includes generation
+        if (command.op != MINE_SHARE_RESET && command.op != (int)MineGameMove::Op::MOVE_OPEN) {
+            samples.push_back(elapse.count());
+        }
+    }
+
+    running = false;
+    thread.join();
+
+    this->Report("shared-board", name, "round-trip", samples);
+
+    // full reads of counters and grids with the host idle
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < this->count * this->steps; i++) {
+        client.Read(snapshot, &grids[0]);
+    }
+
+    std::chrono::duration<double> elapse = std::chrono::steady_clock::now() - start;
+    double seconds = elapse.count();
+
+    std::fflush(stdout);
+    std::printf("# shared-board %s reads %d %.3fs %.0f reads/s, %lld counter reads while waiting\n", name.c_str(), this->count * this->steps,
+                seconds, this->count * this->steps / (seconds > 0 ? seconds : 1), reads);
+
+    return 0;
+}
+
+void MineBench::SharedBoardHost(MineSharedBoard *share, MineGame *game, std::atomic<bool> *running)
+{
+    MineShareCommand command;
+
+    // what a front end does between its own events
+    while (*running) {
+        bool busy = false;
+
+        while (share->TakeCommand(command)) {
+            if (command.op == MINE_SHARE_RESET) {
+                game->Reset();
+            } else {
+                MineGameMove move;
+
+                move.op = (MineGameMove::Op)command.op;
+                move.x = command.x;
+                move.y = command.y;
+
+                game->ApplyMove(move);
+            }
+
+            busy = true;
+        }
+
+        if (busy) {
+            game->ClearDirtyGrids();
+            share->Publish(game);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void MineBench::Report(const char *test, const std::string &name, const char *mode, std::vector<double> &samples)
+{
+    double sum = 0;
+
+    std::sort(samples.begin(), samples.end());
+
+    for (size_t i = 0; i < samples.size(); i++) {
+        sum += samples[i];
+    }
+
+    std::fflush(stdout);
+    std::printf("# %s %s %s n %zu min %.1fus p50 %.1fus p99 %.1fus max %.1fus mean %.1fus\n", test, name.c_str(), mode, samples.size(),
+                samples.front(), samples[samples.size() / 2], samples[samples.size() * 99 / 100], samples.back(), sum / samples.size());
+}
+
+void MineBench::ShowHelp()
+{
+    std::cout << "Minesweeper engine benchmarks" << std::endl;
+    std::cout << std::endl;
+    std::cout << "mine-bench <test> [options]" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Tests:" << std::endl;
+    std::cout << std::endl;
+    std::cout << "first-click              Latency of the first Open, boards made inline and taken from a board supply." << std::endl;
+    std::cout << "apply-moves              Moves/s of a bot clearing boards, one call per move and batches to ApplyMoves." << std::endl;
+    std::cout << "vector-env               Steps/s of the vectorized environment, --count boards with random actions." << std::endl;
+    std::cout << "c-api                    Moves/s through the C interface (mine_api.h), --count * --steps random moves." << std::endl;
+    std::cout << "shared-board             Move to publication round trips and reads/s of a shared board (share.h)." << std::endl;
+    std::cout << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << std::endl;
+    std::cout << "--level <name>           beginner, intermediate, expert or <w>x<h>x<m>, can be repeated (default: all three)" << std::endl;
+    std::cout << "--count <n>              Samples per level and mode (default: 1000)." << std::endl;
+    std::cout << "--seed <n>               Seed of boards and clicks (default: 1)." << std::endl;
+    std::cout << "--range <min>-<max>      Only use boards with 3BV in this range (default: any)." << std::endl;
+    std::cout << "--batch <n>              Moves per ApplyMoves call (default: 16)." << std::endl;
+    std::cout << "--threads <n>            vector-env threads (default: all cores)." << std::endl;
+    std::cout << "--steps <n>              vector-env steps, c-api moves per --count (default: 1000)." << std::endl;
+    std::cout << "--onehot                 vector-env one-hot observations instead of counts." << std::endl;
+    std::cout << "--cmd <path>             c-api also pipes the same moves to this mine-cmd to compare." << std::endl;
+    std::cout << "--verbose                Keep the game's logging on stdout, as the SDL and command line front ends do." << std::endl;
+    std::cout << std::endl;
+    std::cout << "Report lines start with #." << std::endl;
+}
+
+//////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+    MineBench *bench;
+    int ret;
+
+    bench = new MineBench();
+
+    if (bench->ParseArguments(argc, argv) != 0) {
+        bench->ShowHelp();
+        delete bench;
+        return 1;
+    }
+
+    ret = bench->Run();
+
+    delete bench;
+
+    return ret;
+}
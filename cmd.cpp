@@ -2,48 +2,75 @@
 #include <sstream>
 #include <string>
 #include <vector>
+#include <cstdio>
+#include <climits>
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
 #include "game.h"
 
+// input is read in blocks of this size, replies are written once this much piled up or before waiting for input
+#define CMD_BATCH_BUFFER_SIZE 65536
+
 class CmdUI {
     private:
         MineGame *game;
-        int** game_grid;
-        int height;
+
+        // batch mode
+        std::string replies;
+        std::vector<MineGameGrid> delta;
+
+        // terminal renderer: what is on the screen now, and the grids that may differ from it
+        bool ansi;
+        bool frame_valid;
+        std::vector<char> frame;
+        std::vector<int> changed;
+        std::string output;
 
     public:
         CmdUI(MineGame *game);
         ~CmdUI();
 
+        // false redraws the whole board as plain text after every command, even on a terminal
+        void SetAnsi(bool ansi);
+        bool GetAnsi() const { return this->ansi; }
         void ProcessCommands();
+        // machine readable protocol on a file descriptor, see ShowBatchHelp
+        void ProcessBatch(int fd);
+        static void ShowBatchHelp();
 
     private:
+        bool ProcessBatchLine(const char *p);
+        void ProcessBatchMove(const char *p, MineGameMove::Op op);
+        void ReplyInt(int value, char separator);
+        void FlushReplies();
+
         void GetTokens(std::string tokens[4]);
-        void Resize();
-        void ClearGrid();
+        void UpdateAllGrids();
         void UpdateGrid();
-        char GetGridState(int x, int y);
+        char GetGridState(const MineGameView &view, int x, int y);
         void Redraw();
+        void RedrawAnsi();
+        void MoveCursor(int row, int col);
         void ShowHelp();
 };
 
 CmdUI::CmdUI(MineGame *game)
 {
     this->game = game;
-    this->game_grid = NULL;
-    this->height = 0;
+    this->ansi = false;
+    this->frame_valid = false;
 }
 
 CmdUI::~CmdUI()
 {
-    if (this->game_grid != NULL) {
-        for (int i = 0; i < this->height; i++) {
-            delete [] this->game_grid[i];
-        }
 
-        delete [] this->game_grid;
-        this->game_grid = NULL;
-        this->height = 0;
-    }
 }
 
 void CmdUI::GetTokens(std::string tokens[4])
@@ -62,10 +89,31 @@ void CmdUI::GetTokens(std::string tokens[4])
     }
 }
 
+void CmdUI::SetAnsi(bool ansi)
+{
+    this->ansi = false;
+    this->frame_valid = false;
+
+    if (!ansi || !isatty(1)) {
+        return;
+    }
+
+#ifdef _WIN32
+    // the Windows console understands escape sequences only when asked to
+    HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD mode = 0;
+
+    if (!GetConsoleMode(console, &mode) || !SetConsoleMode(console, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING)) {
+        return;
+    }
+#endif
+
+    this->ansi = true;
+}
+
 void CmdUI::ProcessCommands()
 {
-    this->Resize();
-    this->ClearGrid();
+    this->UpdateAllGrids();
     this->Redraw();
 
     while (1) {
@@ -80,7 +128,7 @@ void CmdUI::ProcessCommands()
         // reset
         if (command == "reset") {
             this->game->Reset();
-            this->ClearGrid();
+            this->UpdateAllGrids();
             this->Redraw();
         }
         // set-game
@@ -90,8 +138,7 @@ void CmdUI::ProcessCommands()
             int mine = std::atoi(tokens[3].c_str());
 
             this->game->SetCustom(width, height, mine);
-            this->Resize();
-            this->ClearGrid();
+            this->UpdateAllGrids();
             this->Redraw();
         }
         // flag
@@ -117,67 +164,329 @@ void CmdUI::ProcessCommands()
             this->Redraw();
         } else {
             this->ShowHelp();
+            this->frame_valid = false;
         }
     }
 }
 
-void CmdUI::Resize()
+// hand written instead of stringstream and atoi, the batch loop should not allocate or touch locales
+static const char *SkipSpaces(const char *p)
+{
+    while (*p == ' ' || *p == '\t' || *p == '\r') {
+        p++;
+    }
+
+    return p;
+}
+
+static bool ParseInt(const char *&p, int &value)
 {
-    // delete old
-    if (this->game_grid != NULL) {
-        for (int i = 0; i < this->height; i++) {
-            delete [] this->game_grid[i];
+    bool negative = false;
+    int n = 0;
+
+    p = SkipSpaces(p);
+
+    if (*p == '-') {
+        negative = true;
+        p++;
+    }
+
+    if (*p < '0' || *p > '9') {
+        return false;
+    }
+
+    while (*p >= '0' && *p <= '9') {
+        // NOTE: anything past INT_MAX rejects the line instead of wrapping
+        if (n > (INT_MAX - (*p - '0')) / 10) {
+            return false;
+        }
+
+        n = n * 10 + (*p - '0');
+        p++;
+    }
+
+    value = negative ? -n : n;
+
+    return true;
+}
+
+// seeds use the full 64 bit range of SetSeed
+static bool ParseUInt64(const char *&p, uint64_t &value)
+{
+    uint64_t n = 0;
+
+    p = SkipSpaces(p);
+
+    if (*p < '0' || *p > '9') {
+        return false;
+    }
+
+    while (*p >= '0' && *p <= '9') {
+        if (n > (UINT64_MAX - (uint64_t)(*p - '0')) / 10) {
+            return false;
         }
 
-        delete [] this->game_grid;
-        this->game_grid = NULL;
-        this->height = 0;
+        n = n * 10 + (uint64_t)(*p - '0');
+        p++;
+    }
+
+    value = n;
+
+    return true;
+}
+
+// moves p behind the command word when it is name or alias
+static bool MatchCommand(const char *&p, const char *name, const char *alias)
+{
+    size_t n = 0;
+
+    while (p[n] != '\0' && p[n] != ' ' && p[n] != '\t' && p[n] != '\r') {
+        n++;
     }
 
-    // new
-    this->game_grid = new int* [this->game->GetHeight()];
-    for (int i = 0; i < this->game->GetHeight(); i++) {
-        this->game_grid[i] = new int [this->game->GetWidth()];
+    if ((std::strlen(name) == n && std::strncmp(p, name, n) == 0) || (alias != NULL && std::strlen(alias) == n && std::strncmp(p, alias, n) == 0)) {
+        p += n;
+        return true;
     }
 
-    this->height = this->game->GetHeight();
+    return false;
 }
 
-void CmdUI::ClearGrid()
+void CmdUI::ProcessBatch(int fd)
 {
-    for (int y = 0; y < this->game->GetHeight(); y++) {
-        for (int x = 0; x < this->game->GetWidth(); x++) {
-            this->game_grid[y][x] = MineGameGrid::State::STATE_COVERED;
+    std::vector<char> input(CMD_BATCH_BUFFER_SIZE + 1);
+    size_t begin = 0, end = 0;
+    bool discard = false;
+
+    // logging would be mixed into the replies
+    this->game->SetVerbose(false);
+    this->game->ClearDirtyGrids();
+    this->replies.reserve(CMD_BATCH_BUFFER_SIZE * 2);
+
+    while (true) {
+        char *line = &input[begin];
+        char *newline = (char*)std::memchr(line, '\n', end - begin);
+
+        if (newline == NULL) {
+            // keep the partial line at the front
+            std::memmove(&input[0], line, end - begin);
+            end -= begin;
+            begin = 0;
+
+            if (end == CMD_BATCH_BUFFER_SIZE) {
+                if (!discard) {
+                    this->replies += "error line too long\n";
+                }
+
+                discard = true;
+                end = 0;
+            }
+
+            // a bot waits for its replies before it sends more
+            this->FlushReplies();
+
+            int n = read(fd, &input[end], CMD_BATCH_BUFFER_SIZE - end);
+
+            if (n > 0) {
+                end += n;
+                continue;
+            }
+
+            // the last line may have no newline
+            if (end == 0) {
+                break;
+            }
+
+            input[end] = '\n';
+            end += 1;
+            continue;
+        }
+
+        *newline = '\0';
+        begin = newline + 1 - &input[0];
+
+        if (discard) {
+            discard = false;
+        } else if (!this->ProcessBatchLine(line)) {
+            break;
+        }
+
+        if (this->replies.size() >= CMD_BATCH_BUFFER_SIZE) {
+            this->FlushReplies();
         }
     }
+
+    this->FlushReplies();
 }
 
-void CmdUI::UpdateGrid()
+bool CmdUI::ProcessBatchLine(const char *p)
 {
-    std::vector<MineGameGrid> grids;
+    int x, y, z;
+
+    p = SkipSpaces(p);
+
+    // blank lines get no reply
+    if (*p == '\0') {
+        return true;
+    }
+
+    if (MatchCommand(p, "open", "o")) {
+        this->ProcessBatchMove(p, MineGameMove::Op::MOVE_OPEN);
+    } else if (MatchCommand(p, "flag", "f")) {
+        this->ProcessBatchMove(p, MineGameMove::Op::MOVE_FLAG);
+    } else if (MatchCommand(p, "chord", "c")) {
+        this->ProcessBatchMove(p, MineGameMove::Op::MOVE_CHORD);
+    } else if (MatchCommand(p, "reset", NULL)) {
+        this->game->Reset();
+        this->game->ClearDirtyGrids();
+        this->replies += "ok\n";
+    } else if (MatchCommand(p, "set-game", NULL)) {
+        // same limits as a script level, the game is left alone on error
+        if (!ParseInt(p, x) || !ParseInt(p, y) || !ParseInt(p, z) || x <= 0 || y <= 0 || z < 0 || (long long)z >= (long long)x * y) {
+            this->replies += "error expected <w> <h> <m>\n";
+            return true;
+        }
+
+        this->game->SetCustom(x, y, z);
+        this->game->ClearDirtyGrids();
+        this->replies += "ok\n";
+    } else if (MatchCommand(p, "seed", NULL)) {
+        uint64_t seed;
+
+        if (!ParseUInt64(p, seed)) {
+            this->replies += "error expected <n>\n";
+            return true;
+        }
+
+        this->game->SetSeed(seed);
+        this->replies += "ok\n";
+    } else if (MatchCommand(p, "show", "s")) {
+        const char map[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '_', 'F', 'F', 'X', 'M'};
+
+        this->ReplyInt(this->game->GetWidth(), ' ');
+        this->ReplyInt(this->game->GetHeight(), ' ');
+        this->ReplyInt(this->game->GetMineCount(), ' ');
+        this->ReplyInt(this->game->GetFlagCount(), ' ');
+        this->ReplyInt(this->game->GetGameState(), ' ');
+
+        MineGameView view = this->game->GetView();
+
+        // rows one after another, no separator
+        for (int row = 0; row < view.GetHeight(); row++) {
+            const unsigned char *grids = view.GetRow(row);
+
+            for (int col = 0; col < view.GetWidth(); col++) {
+                this->replies += map[grids[col]];
+            }
+        }
+
+        this->replies += '\n';
+    } else if (MatchCommand(p, "quit", "q") || MatchCommand(p, "exit", NULL)) {
+        return false;
+    } else {
+        this->replies += "error unknown command\n";
+    }
+
+    return true;
+}
 
-    this->game->GetDirtyGrids(grids);
+void CmdUI::ProcessBatchMove(const char *p, MineGameMove::Op op)
+{
+    MineGameMove move;
+
+    if (!ParseInt(p, move.x) || !ParseInt(p, move.y)) {
+        this->replies += "error expected <x> <y>\n";
+        return;
+    }
+
+    move.op = op;
+
+    MineGameMove::Outcome outcome = this->game->ApplyMove(move);
+
+    // <outcome> <count> then x y state of every changed grid
+    this->delta.clear();
+    this->game->GetDirtyGrids(this->delta);
     this->game->ClearDirtyGrids();
 
-    for (int i = 0; i < grids.size(); i++) {
-        int x = grids[i].x;
-        int y = grids[i].y;
+    this->ReplyInt(outcome, ' ');
+    this->ReplyInt((int)this->delta.size(), this->delta.empty() ? '\n' : ' ');
 
-        this->game_grid[y][x] = grids[i].state;
+    for (size_t i = 0; i < this->delta.size(); i++) {
+        this->ReplyInt(this->delta[i].x, ' ');
+        this->ReplyInt(this->delta[i].y, ' ');
+        this->ReplyInt(this->delta[i].state, (i + 1 == this->delta.size()) ? '\n' : ' ');
     }
 }
 
-char CmdUI::GetGridState(int x, int y)
+void CmdUI::ReplyInt(int value, char separator)
+{
+    char digits[16];
+    int n = 0;
+    unsigned int v = (value < 0) ? (0u - (unsigned int)value) : (unsigned int)value;
+
+    do {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+
+    if (value < 0) {
+        this->replies += '-';
+    }
+
+    while (n > 0) {
+        this->replies += digits[--n];
+    }
+
+    this->replies += separator;
+}
+
+void CmdUI::FlushReplies()
+{
+    if (!this->replies.empty()) {
+        std::fwrite(this->replies.data(), 1, this->replies.size(), stdout);
+        std::fflush(stdout);
+        this->replies.clear();
+    }
+}
+
+void CmdUI::UpdateAllGrids()
+{
+    // reset and set-game change every grid without reporting them dirty
+    this->game->ClearDirtyGrids();
+    this->changed.clear();
+
+    for (int z = 0; z < this->game->GetWidth() * this->game->GetHeight(); z++) {
+        this->changed.push_back(z);
+    }
+}
+
+void CmdUI::UpdateGrid()
+{
+    // the board itself is read from the game's view when drawing, only remember which grids to look at
+    this->delta.clear();
+    this->game->GetDirtyGrids(this->delta);
+    this->game->ClearDirtyGrids();
+
+    for (size_t i = 0; i < this->delta.size(); i++) {
+        this->changed.push_back(this->delta[i].y * this->game->GetWidth() + this->delta[i].x);
+    }
+}
+
+char CmdUI::GetGridState(const MineGameView &view, int x, int y)
 {
     // NOTE: MineGameGrid::State is carefully designed so that we can convert it quick
     char map[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '_', 'F', 'F', 'X', 'M'};
-    int index = this->game_grid[y][x];
 
-    return map[index];
+    return map[view.GetGridState(x, y)];
 }
 
 void CmdUI::Redraw()
 {
+    if (this->ansi) {
+        this->RedrawAnsi();
+        return;
+    }
+
     // =================================
     int width = this->game->GetWidth() * 2;
     for (int i = 0; i < width; i++) {
@@ -187,9 +496,11 @@ void CmdUI::Redraw()
     std::cout << std::endl;
 
     // grid
-    for (int y = 0; y < this->game->GetHeight(); y++) {
-        for (int x = 0; x < this->game->GetWidth(); x++) {
-            char c = this->GetGridState(x, y);
+    MineGameView view = this->game->GetView();
+
+    for (int y = 0; y < view.GetHeight(); y++) {
+        for (int x = 0; x < view.GetWidth(); x++) {
+            char c = this->GetGridState(view, x, y);
 
             std::cout << c << " ";
         }
@@ -216,6 +527,101 @@ void CmdUI::Redraw()
     }
 }
 
+void CmdUI::RedrawAnsi()
+{
+    MineGameView view = this->game->GetView();
+    int width = view.GetWidth();
+    int height = view.GetHeight();
+
+    // same layout as Redraw: a ruler on row 1, grid (x, y) at row y + 2 and column 2x + 1,
+    // a ruler, the counters, the end of game message, then the prompt
+    this->output.clear();
+
+    if (!this->frame_valid || (int)this->frame.size() != width * height) {
+        this->frame.assign(width * height, ' ');
+        this->changed.clear();
+        this->output += "\x1b[2J\x1b[H";
+        this->output.append(width * 2, '=');
+        this->output += '\n';
+
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                this->frame[y * width + x] = this->GetGridState(view, x, y);
+                this->output += this->frame[y * width + x];
+                this->output += ' ';
+            }
+
+            this->output += '\n';
+        }
+
+        this->output.append(width * 2, '=');
+        this->frame_valid = true;
+    } else {
+        int row = -1, col = -1;
+
+        // in screen order, so neighbours on a row are written without moving the cursor
+        std::sort(this->changed.begin(), this->changed.end());
+
+        for (size_t i = 0; i < this->changed.size(); i++) {
+            int z = this->changed[i];
+            char c = this->GetGridState(view, z % width, z / width);
+
+            if (c == this->frame[z]) {
+                continue;
+            }
+
+            this->frame[z] = c;
+
+            if (row != z / width + 2 || col != (z % width) * 2 + 1) {
+                row = z / width + 2;
+                col = (z % width) * 2 + 1;
+                this->MoveCursor(row, col);
+            }
+
+            this->output += c;
+            this->output += ' ';
+            col += 2;
+        }
+    }
+
+    this->changed.clear();
+
+    // counters and the message are short, rewrite them and clear what the last frame left behind
+    int flag_count = this->game->GetFlagCount();
+    int game_state = this->game->GetGameState();
+    std::ostringstream status;
+
+    status << "Flags: " << flag_count << ", Remaining mines: " << (this->game->GetMineCount() - flag_count);
+
+    this->MoveCursor(height + 3, 1);
+    this->output += status.str();
+    this->output += "\x1b[K";
+    this->MoveCursor(height + 4, 1);
+
+    if (game_state == MineGame::State::GAME_WON) {
+        this->output += "Congratulations! You win!";
+    } else if (game_state == MineGame::State::GAME_LOST) {
+        this->output += "You loose, try it again.";
+    }
+
+    // the prompt goes below, the echo of the last command is cleared
+    this->output += "\x1b[K";
+    this->MoveCursor(height + 5, 1);
+    this->output += "\x1b[J";
+
+    // one write per frame
+    std::cout.write(this->output.data(), this->output.size());
+    std::cout.flush();
+}
+
+void CmdUI::MoveCursor(int row, int col)
+{
+    char buffer[32];
+
+    std::snprintf(buffer, sizeof(buffer), "\x1b[%d;%dH", row, col);
+    this->output += buffer;
+}
+
 void CmdUI::ShowHelp()
 {
     std::cout << "Command line Minesweeper available commands" << std::endl;
@@ -241,22 +647,83 @@ void CmdUI::ShowHelp()
     std::cout << "The difficulty will be the same as the beginner level." << std::endl;
 }
 
+void CmdUI::ShowBatchHelp()
+{
+    std::cout << "mine-cmd [--plain] [--batch|--protocol] [--input <file>]" << std::endl;
+    std::cout << std::endl;
+    std::cout << "--plain                  Print the whole board after every command, also on a terminal." << std::endl;
+    std::cout << "                         Without it a terminal gets the board drawn in place, only changed grids are rewritten." << std::endl;
+    std::cout << "--batch|--protocol       Read commands from stdin (or --input) without drawing the board," << std::endl;
+    std::cout << "                         one reply line per command, for bots." << std::endl;
+    std::cout << "--input <file>           Read batch commands from a file instead of stdin, implies --batch." << std::endl;
+    std::cout << std::endl;
+    std::cout << "Batch commands and replies:" << std::endl;
+    std::cout << std::endl;
+    std::cout << "open|o, flag|f, chord|c <x> <y>" << std::endl;
+    std::cout << "                         <outcome> <n> followed by x y state of the n changed grids" << std::endl;
+    std::cout << "                         outcome: 0 changed, 1 unchanged, 2 invalid, 3 lost, 4 won, 5 game over already" << std::endl;
+    std::cout << "                         state: 0-8 open, 9 covered, 10 flag, 11 wrong flag, 12 exploded, 13 mine" << std::endl;
+    std::cout << "reset, set-game <w> <h> <m>, seed <n>" << std::endl;
+    std::cout << "                         ok" << std::endl;
+    std::cout << "show|s                   <w> <h> <mines> <flags> <game state> <w*h grid characters, row by row>" << std::endl;
+    std::cout << "quit|exit|q              Stop reading, no reply." << std::endl;
+    std::cout << std::endl;
+    std::cout << "Malformed commands reply error <message>, blank lines get no reply." << std::endl;
+}
+
 //////////////////////////////////////////////////////////////////
 
-int main()
+int main(int argc, char **argv)
 {
     CmdUI *ui;
     MineGame *game;
+    bool batch = false;
+    bool plain = false;
+    int fd = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--batch" || arg == "--protocol") {
+            batch = true;
+        } else if (arg == "--plain") {
+            plain = true;
+        } else if (arg == "--input" && i + 1 < argc) {
+            batch = true;
+            fd = open(argv[++i], O_RDONLY);
+
+            if (fd < 0) {
+                std::cerr << "cannot open " << argv[i] << std::endl;
+                return 1;
+            }
+        } else {
+            CmdUI::ShowBatchHelp();
+            return 1;
+        }
+    }
 
     game = new MineGame();
-    game->SetBeginner();
 
     // create a command line UI, interact with game through UI
     ui = new CmdUI(game);
-    ui->ProcessCommands();
+    ui->SetAnsi(!plain && !batch);
+
+    // logging would scroll the board drawn in place, and would be mixed into batch replies
+    game->SetVerbose(!batch && !ui->GetAnsi());
+    game->SetBeginner();
+
+    if (batch) {
+        ui->ProcessBatch(fd);
+    } else {
+        ui->ProcessCommands();
+    }
 
     delete ui;
     delete game;
 
+    if (fd != 0) {
+        close(fd);
+    }
+
     return 0;
 }
\ No newline at end of file
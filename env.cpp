@@ -0,0 +1,437 @@
+#include <iostream>
+#include <algorithm>
+#include "env.h"
+
+#define ENV_PLANES 11
+
+MineVectorEnv::MineVectorEnv()
+{
+    this->count = 0;
+    this->width = 0;
+    this->height = 0;
+    this->mine_count = 0;
+    this->stride = 0;
+    this->padded_size = 0;
+    this->observation = MineVectorEnv::Observation::OBS_COUNT;
+    this->threads = 0;
+    this->generation = 0;
+    this->pending = 0;
+    this->quit = false;
+    this->actions = NULL;
+    this->observations = NULL;
+    this->rewards = NULL;
+    this->dones = NULL;
+
+    for (int k = 0; k < 8; k++) {
+        this->offsets[k] = 0;
+    }
+}
+
+MineVectorEnv::~MineVectorEnv()
+{
+    this->Destroy();
+}
+
+int MineVectorEnv::Create(int count, int width, int height, int mine_count, int threads)
+{
+    if (count <= 0 || width <= 0 || height <= 0 || mine_count < 0) {
+        std::cerr << "MineVectorEnv::Create(count=" << count << ", width=" << width << ", height=" << height << "): invalid size" << std::endl;
+        return -1;
+    }
+
+    this->Destroy();
+
+    this->count = count;
+    this->width = width;
+    this->height = height;
+    this->mine_count = (mine_count >= width * height) ? (width * height - 1) : mine_count;
+    this->stride = width + 2;
+    this->padded_size = (width + 2) * (height + 2);
+
+    int s = this->stride;
+    int offsets[8] = {-s - 1, -s, -s + 1, -1, 1, s - 1, s, s + 1};
+
+    for (int k = 0; k < 8; k++) {
+        this->offsets[k] = offsets[k];
+    }
+
+    // the sentinel ring is written once here and never touched again
+    this->numbers.assign((size_t)count * this->padded_size, -2);
+    this->states.assign((size_t)count * this->padded_size, MineGameGrid::State::STATE_BORDER);
+    this->game_states.assign(count, MineGame::State::GAME_READY);
+    this->remaining.assign(count, 0);
+    this->random.assign(count, MineRandom());
+
+    // slices
+    if (threads <= 0) {
+        threads = (int)std::thread::hardware_concurrency();
+    }
+
+    this->threads = std::max(1, std::min(threads, count));
+    this->slice_start.clear();
+
+    for (int t = 0; t <= this->threads; t++) {
+        this->slice_start.push_back((int)((long long)count * t / this->threads));
+    }
+
+    // flood fill stacks, a grid is pushed at most once per fill
+    this->stacks.assign(this->threads, std::vector<int>());
+
+    for (int t = 0; t < this->threads; t++) {
+        this->stacks[t].reserve(width * height);
+    }
+
+    this->quit = false;
+    this->generation = 0;
+
+    for (int t = 1; t < this->threads; t++) {
+        this->workers.push_back(std::thread(&MineVectorEnv::Worker, this, t));
+    }
+
+    this->Seed(0);
+
+    for (int b = 0; b < count; b++) {
+        this->ResetBoard(b);
+    }
+
+    return 0;
+}
+
+void MineVectorEnv::Destroy()
+{
+    {
+        std::unique_lock<std::mutex> guard(this->lock);
+
+        this->quit = true;
+    }
+
+    this->start_cond.notify_all();
+
+    for (size_t i = 0; i < this->workers.size(); i++) {
+        this->workers[i].join();
+    }
+
+    this->workers.clear();
+    this->count = 0;
+}
+
+void MineVectorEnv::Seed(uint64_t seed)
+{
+    for (int b = 0; b < this->count; b++) {
+        this->random[b].Seed(seed ^ ((uint64_t)b * 0x9E3779B97F4A7C15ULL));
+    }
+}
+
+void MineVectorEnv::SetObservation(MineVectorEnv::Observation observation)
+{
+    this->observation = observation;
+}
+
+int MineVectorEnv::GetObservationSize() const
+{
+    int cells = this->width * this->height;
+
+    return (this->observation == MineVectorEnv::Observation::OBS_ONEHOT) ? (cells * ENV_PLANES) : cells;
+}
+
+void MineVectorEnv::Reset(float *observations)
+{
+    this->actions = NULL;
+    this->observations = observations;
+    this->rewards = NULL;
+    this->dones = NULL;
+
+    this->RunAll();
+}
+
+void MineVectorEnv::Step(const int *actions, float *observations, float *rewards, unsigned char *dones)
+{
+    this->actions = actions;
+    this->observations = observations;
+    this->rewards = rewards;
+    this->dones = dones;
+
+    this->RunAll();
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+
+void MineVectorEnv::RunAll()
+{
+    {
+        std::unique_lock<std::mutex> guard(this->lock);
+
+        this->pending = this->threads - 1;
+        this->generation += 1;
+    }
+
+    this->start_cond.notify_all();
+
+    this->RunSlice(0);
+
+    std::unique_lock<std::mutex> guard(this->lock);
+
+    while (this->pending > 0) {
+        this->done_cond.wait(guard);
+    }
+}
+
+void MineVectorEnv::Worker(int slice)
+{
+    long long seen = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(this->lock);
+
+            while (!this->quit && this->generation == seen) {
+                this->start_cond.wait(guard);
+            }
+
+            if (this->quit) {
+                return;
+            }
+
+            seen = this->generation;
+        }
+
+        this->RunSlice(slice);
+
+        std::unique_lock<std::mutex> guard(this->lock);
+
+        if (--this->pending == 0) {
+            this->done_cond.notify_one();
+        }
+    }
+}
+
+void MineVectorEnv::RunSlice(int slice)
+{
+    std::vector<int> &stack = this->stacks[slice];
+    int size = this->GetObservationSize();
+
+    for (int b = this->slice_start[slice]; b < this->slice_start[slice + 1]; b++) {
+        if (this->actions == NULL) {
+            this->ResetBoard(b);
+        } else {
+            bool done = false;
+
+            this->rewards[b] = this->StepBoard(b, this->actions[b], stack, done);
+            this->dones[b] = done ? 1 : 0;
+
+            if (done) {
+                this->ResetBoard(b);
+            }
+        }
+
+        this->WriteObservation(b, this->observations + (size_t)b * size);
+    }
+}
+
+void MineVectorEnv::ResetBoard(int b)
+{
+    uint8_t *state = &this->states[(size_t)b * this->padded_size];
+
+    for (int y = 0; y < this->height; y++) {
+        uint8_t *row = state + (y + 1) * this->stride + 1;
+
+        std::fill(row, row + this->width, (uint8_t)MineGameGrid::State::STATE_COVERED);
+    }
+
+    this->game_states[b] = MineGame::State::GAME_READY;
+    this->remaining[b] = this->width * this->height - this->mine_count;
+}
+
+void MineVectorEnv::PlaceMines(int b, int skip)
+{
+    int8_t *number = &this->numbers[(size_t)b * this->padded_size];
+    MineRandom &random = this->random[b];
+    int cells_left = this->width * this->height - 1;
+    int mines_left = this->mine_count;
+
+    // selection sampling over every grid but the first click
+    for (int z = 0; z < this->width * this->height; z++) {
+        int index = (z / this->width + 1) * this->stride + (z % this->width + 1);
+
+        if (z == skip) {
+            number[index] = 0;
+            continue;
+        }
+
+        bool mine = (int)random.NextBelow((uint32_t)cells_left) < mines_left;
+
+        number[index] = mine ? -1 : 0;
+        mines_left -= mine ? 1 : 0;
+        cells_left -= 1;
+    }
+
+    for (int y = 0; y < this->height; y++) {
+        for (int x = 0; x < this->width; x++) {
+            int index = (y + 1) * this->stride + (x + 1);
+            int n = 0;
+
+            if (number[index] == -1) {
+                continue;
+            }
+
+            for (int k = 0; k < 8; k++) {
+                n += (number[index + this->offsets[k]] == -1);
+            }
+
+            number[index] = (int8_t)n;
+        }
+    }
+}
+
+float MineVectorEnv::StepBoard(int b, int action, std::vector<int> &stack, bool &done)
+{
+    int8_t *number = &this->numbers[(size_t)b * this->padded_size];
+    uint8_t *state = &this->states[(size_t)b * this->padded_size];
+    int cells = this->width * this->height;
+    int op = (action >= 0) ? action / cells : -1;
+    int z = (action >= 0) ? action % cells : 0;
+    int index = (z / this->width + 1) * this->stride + (z % this->width + 1);
+    int opened = 0;
+
+    if (op < MineGameMove::Op::MOVE_OPEN || op > MineGameMove::Op::MOVE_CHORD) {
+        return 0;
+    }
+
+    if (op == MineGameMove::Op::MOVE_FLAG) {
+        if (state[index] == MineGameGrid::State::STATE_COVERED) {
+            state[index] = MineGameGrid::State::STATE_FLAGGED;
+        } else if (state[index] == MineGameGrid::State::STATE_FLAGGED) {
+            state[index] = MineGameGrid::State::STATE_COVERED;
+        }
+
+        return 0;
+    }
+
+    if (this->game_states[b] == MineGame::State::GAME_READY) {
+        if (op != MineGameMove::Op::MOVE_OPEN) {
+            return 0;
+        }
+
+        this->PlaceMines(b, z);
+        this->game_states[b] = MineGame::State::GAME_RUNNING;
+    }
+
+    if (op == MineGameMove::Op::MOVE_OPEN) {
+        if (state[index] != MineGameGrid::State::STATE_COVERED) {
+            return 0;
+        }
+
+        if (number[index] == -1) {
+            done = true;
+            return -1;
+        }
+
+        opened = this->OpenArea(b, index, stack);
+    } else {
+        int flags = 0;
+
+        // chord: only on an open number with as many flags around
+        if (state[index] < MineGameGrid::State::STATE_MINE_1 || state[index] > MineGameGrid::State::STATE_MINE_8) {
+            return 0;
+        }
+
+        for (int k = 0; k < 8; k++) {
+            flags += (state[index + this->offsets[k]] == MineGameGrid::State::STATE_FLAGGED);
+        }
+
+        if (flags != state[index]) {
+            return 0;
+        }
+
+        for (int k = 0; k < 8; k++) {
+            int n = index + this->offsets[k];
+
+            if (state[n] == MineGameGrid::State::STATE_COVERED && number[n] == -1) {
+                done = true;
+                return -1;
+            }
+        }
+
+        for (int k = 0; k < 8; k++) {
+            int n = index + this->offsets[k];
+
+            if (state[n] == MineGameGrid::State::STATE_COVERED) {
+                opened += this->OpenArea(b, n, stack);
+            }
+        }
+    }
+
+    this->remaining[b] -= opened;
+
+    float reward = (float)opened / (float)(cells - this->mine_count);
+
+    if (this->remaining[b] == 0) {
+        done = true;
+        reward += 1;
+    }
+
+    return reward;
+}
+
+int MineVectorEnv::OpenArea(int b, int index, std::vector<int> &stack)
+{
+    int8_t *number = &this->numbers[(size_t)b * this->padded_size];
+    uint8_t *state = &this->states[(size_t)b * this->padded_size];
+    int opened = 0;
+
+    // flood fill with an explicit stack, grids are marked open when pushed so each is pushed once
+    // NOTE: like MineGame, flags inside an opening are opened too
+    stack.clear();
+    stack.push_back(index);
+    state[index] = (uint8_t)number[index];
+
+    while (!stack.empty()) {
+        int i = stack.back();
+
+        stack.pop_back();
+        opened += 1;
+
+        if (number[i] != 0) {
+            continue;
+        }
+
+        for (int k = 0; k < 8; k++) {
+            int n = i + this->offsets[k];
+
+            if (state[n] == MineGameGrid::State::STATE_COVERED || state[n] == MineGameGrid::State::STATE_FLAGGED) {
+                state[n] = (uint8_t)number[n];
+                stack.push_back(n);
+            }
+        }
+    }
+
+    return opened;
+}
+
+void MineVectorEnv::WriteObservation(int b, float *observation)
+{
+    const uint8_t *state = &this->states[(size_t)b * this->padded_size];
+    int cells = this->width * this->height;
+
+    if (this->observation == MineVectorEnv::Observation::OBS_ONEHOT) {
+        std::fill(observation, observation + cells * ENV_PLANES, 0.0f);
+    }
+
+    for (int y = 0; y < this->height; y++) {
+        const uint8_t *row = state + (y + 1) * this->stride + 1;
+        float *out = observation + y * this->width;
+
+        if (this->observation == MineVectorEnv::Observation::OBS_COUNT) {
+            for (int x = 0; x < this->width; x++) {
+                int s = row[x];
+
+                out[x] = (s <= MineGameGrid::State::STATE_MINE_8) ? (float)s : ((s == MineGameGrid::State::STATE_FLAGGED) ? -2.0f : -1.0f);
+            }
+        } else {
+            // planes 0 to 8 are the numbers, then covered and flagged, which are the states 9 and 10
+            for (int x = 0; x < this->width; x++) {
+                out[row[x] * cells + x] = 1.0f;
+            }
+        }
+    }
+}
@@ -0,0 +1,103 @@
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+#include "layout.h"
+#include "game.h"
+
+#ifndef __MINE_ENV_H__
+#define __MINE_ENV_H__
+
+// many boards of one size stepped in lockstep, for training agents
+// every field is one array across boards (numbers and states of board b start at b * padded_size),
+// boards are split in contiguous slices, one per thread
+class MineVectorEnv {
+    public:
+        enum Observation {
+            // one value per grid: 0 to 8 for open numbers, -1 covered, -2 flagged
+            OBS_COUNT = 0,
+            // 11 planes of height x width per board: numbers 0 to 8, covered, flagged
+            OBS_ONEHOT = 1
+        };
+
+    public:
+        MineVectorEnv();
+        ~MineVectorEnv();
+
+        // threads <= 0 uses all cores, returns -1 on bad sizes
+        int Create(int count, int width, int height, int mine_count, int threads);
+        void Destroy();
+
+        // board b is seeded with seed ^ (b * golden ratio), so results do not depend on the thread count
+        void Seed(uint64_t seed);
+        void SetObservation(Observation observation);
+
+        int GetBoardCount() const { return this->count; }
+        int GetWidth() const { return this->width; }
+        int GetHeight() const { return this->height; }
+        int GetMineCount() const { return this->mine_count; }
+        // actions are op * width * height + y * width + x, op is a MineGameMove::Op
+        int GetActionCount() const { return 3 * this->width * this->height; }
+        // floats written per board
+        int GetObservationSize() const;
+
+        // resets every board and writes count * GetObservationSize() floats
+        void Reset(float *observations);
+
+        // one action per board, writes observations, rewards and dones of every board
+        // reward: opened grids / safe grids, +1 more on a win, -1 on a loss
+        // a finished board is reset right away, so its observation is the new board and dones[b] is 1
+        void Step(const int *actions, float *observations, float *rewards, unsigned char *dones);
+
+    private:
+        void Worker(int slice);
+        void RunSlice(int slice);
+        void RunAll();
+
+        void ResetBoard(int b);
+        void PlaceMines(int b, int skip);
+        float StepBoard(int b, int action, std::vector<int> &stack, bool &done);
+        int OpenArea(int b, int index, std::vector<int> &stack);
+        void WriteObservation(int b, float *observation);
+
+    private:
+        int count;
+        int width;
+        int height;
+        int mine_count;
+        int stride;
+        int padded_size;
+        int offsets[8];
+        Observation observation;
+
+        // per grid, count * padded_size, sentinel ring included
+        // numbers: -2 sentinel, -1 mine, 0 to 8; states: MineGameGrid::State
+        std::vector<int8_t> numbers;
+        std::vector<uint8_t> states;
+
+        // per board
+        std::vector<uint8_t> game_states;
+        std::vector<int> remaining;
+        std::vector<MineRandom> random;
+
+        // slices and a persistent pool, slice 0 runs on the calling thread
+        int threads;
+        std::vector<int> slice_start;
+        std::vector<std::vector<int> > stacks;
+        std::vector<std::thread> workers;
+        std::mutex lock;
+        std::condition_variable start_cond;
+        std::condition_variable done_cond;
+        long long generation;
+        int pending;
+        bool quit;
+
+        // arguments of the current call, read by the workers
+        const int *actions;
+        float *observations;
+        float *rewards;
+        unsigned char *dones;
+};
+
+#endif
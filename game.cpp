@@ -1,9 +1,9 @@
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
-#include <ctime>
-#include <cstdlib>
+#include <chrono>
 #include "game.h"
+#include "supply.h"
 
 struct Point {
     int x;
@@ -14,15 +14,27 @@ MineGame::MineGame()
 {
     this->width = 0;
     this->height = 0;
+    this->stride = 0;
+    this->padded_size = 0;
     this->mine_map = NULL;
     this->grid_state_map = NULL;
     this->grid_dirty_map = NULL;
+    this->adjacency_start = NULL;
+    this->adjacency = NULL;
+    this->opening_label = NULL;
+    this->opening_parent = NULL;
     this->mine_count = 0;
     this->flag_count = 0;
     this->remaining_count = 0;
     this->game_state = MineGame::State::GAME_READY;
+    this->change_count = 0;
+    this->supply = NULL;
 
+    // NOTE: the default board is set quietly, so embedding the game does not print
+    this->verbose = false;
+    this->SetSeed((uint64_t)std::chrono::high_resolution_clock::now().time_since_epoch().count());
     this->SetBeginner();
+    this->verbose = true;
 }
 
 MineGame::~MineGame()
@@ -47,11 +59,13 @@ void MineGame::SetExpert()
 
 void MineGame::SetCustom(int width, int height, int mine_count)
 {
-    std::cout << "SetCustom(width=" << width << ", height=" << height << ", mine_count= " << mine_count << ")" << std::endl;
+    if (this->verbose) {
+        std::cout << "SetCustom(width=" << width << ", height=" << height << ", mine_count= " << mine_count << ")" << std::endl;
+    }
 
     // make sure the inputs are correct
-    width = (width > 50) ? 50 : width;
-    height = (height > 50) ? 50 : height;
+    width = (width > MINE_GAME_MAX_WIDTH) ? MINE_GAME_MAX_WIDTH : width;
+    height = (height > MINE_GAME_MAX_HEIGHT) ? MINE_GAME_MAX_HEIGHT : height;
     mine_count = (mine_count >= width * height) ? (width * height - 1) : mine_count;
 
     this->FreeMap();
@@ -65,14 +79,7 @@ void MineGame::SetCustom(int width, int height, int mine_count)
     this->remaining_count = this->width * this->height - this->mine_count;
     this->game_state = MineGame::State::GAME_READY;
 
-    // clean up map
-    for (int i = 0; i < this->height; i++) {
-        for (int j = 0; j < this->width; j++) {
-            this->mine_map[i][j] = 0;
-            this->grid_state_map[i][j] = MineGameGrid::State::STATE_COVERED;
-            this->grid_dirty_map[i][j] = 0;
-        }
-    }
+    this->ClearMap();
 }
 
 void MineGame::Reset()
@@ -81,182 +88,371 @@ void MineGame::Reset()
     this->remaining_count = this->width * this->height - this->mine_count;
     this->game_state = MineGame::State::GAME_READY;
 
-    // clean up map
-    for (int i = 0; i < this->height; i++) {
-        for (int j = 0; j < this->width; j++) {
-            this->mine_map[i][j] = 0;
-            this->grid_state_map[i][j] = MineGameGrid::State::STATE_COVERED;
-            this->grid_dirty_map[i][j] = 0;
-        }
-    }
+    this->ClearMap();
+}
+
+void MineGame::SetBoardSupply(MineBoardSupply *supply)
+{
+    this->supply = supply;
+}
+
+void MineGame::SetSeed(uint64_t seed)
+{
+    this->random.Seed(seed);
+}
+
+void MineGame::SetVerbose(bool verbose)
+{
+    this->verbose = verbose;
+}
+
+const unsigned char *MineGame::GetStateBuffer() const
+{
+    return this->grid_state_map;
+}
+
+MineGameView MineGame::GetView() const
+{
+    return MineGameView(this->grid_state_map, this->width, this->height, this->stride);
 }
 
-MineGame::State MineGame::GetGameState()
+MineGame::State MineGame::GetGameState() const
 {
     return this->game_state;
 }
 
 MineGameGrid::State MineGame::GetGridState(int x, int y)
 {
-    return this->grid_state_map[y][x];
+    return (MineGameGrid::State)this->grid_state_map[this->GridIndex(x, y)];
 }
 
 void MineGame::GetDirtyGrids(std::vector<MineGameGrid> &grids)
 {
-    for (int y = 0; y < this->height; y++) {
-        for (int x = 0; x < this->width; x++) {
-            if (this->IsDirtyGrid(x, y)) {
-                MineGameGrid g;
+    // NOTE: dirty_list holds every changed grid exactly once, so this is O(changed grids)
+    grids.reserve(grids.size() + this->dirty_list.size());
 
-                g.state = this->GetGridState(x, y);
-                g.x = x;
-                g.y = y;
-                grids.push_back(g);
-            }
-        }
+    for (size_t i = 0; i < this->dirty_list.size(); i++) {
+        int index = this->dirty_list[i];
+        MineGameGrid g;
+
+        g.state = (MineGameGrid::State)this->grid_state_map[index];
+        g.x = index % this->stride - 1;
+        g.y = index / this->stride - 1;
+        grids.push_back(g);
     }
 }
 
 void MineGame::ClearDirtyGrids()
 {
-    for (int y = 0; y < this->height; y++) {
-        for (int x = 0; x < this->width; x++) {
-            grid_dirty_map[y][x] = 0;
-        }
+    for (size_t i = 0; i < this->dirty_list.size(); i++) {
+        this->grid_dirty_map[this->dirty_list[i]] = 0;
     }
+
+    this->dirty_list.clear();
 }
 
-void MineGame::TouchFlag(int x, int y)
+int MineGame::GetOpeningCount()
 {
-    MineGameGrid e;
+    return (int)this->opening_start.size() - 1;
+}
 
-    std::cout << "MineGame::TouchFlag(x=" << x << ", y=" << y << ")" << std::endl;
+int MineGame::GetOpeningLabel(int x, int y)
+{
+    if (!this->IsValidPoint(x, y)) {
+        return -1;
+    }
+
+    return this->opening_label[this->GridIndex(x, y)];
+}
+
+void MineGame::GetOpeningGrids(int label, std::vector<MineGameGrid> &grids)
+{
+    if (label < 0 || label >= this->GetOpeningCount()) {
+        return;
+    }
+
+    for (int k = this->opening_start[label]; k < this->opening_start[label + 1]; k++) {
+        int index = this->opening_grids[k];
+        MineGameGrid g;
+
+        g.state = (MineGameGrid::State)this->mine_map[index];
+        g.x = index % this->stride - 1;
+        g.y = index / this->stride - 1;
+        grids.push_back(g);
+    }
+}
+
+void MineGame::GetMineLayout(MineBoardLayout &layout)
+{
+    layout.Resize(this->width, this->height);
+
+    for (size_t i = 0; i < this->mine_list.size(); i++) {
+        int index = this->mine_list[i];
+
+        layout.SetMine(index % this->stride - 1, index / this->stride - 1, true);
+    }
+}
+
+void MineGame::TouchFlag(int x, int y)
+{
+    if (this->verbose) {
+        std::cout << "MineGame::TouchFlag(x=" << x << ", y=" << y << ")" << std::endl;
+    }
 
     if (!this->IsValidPoint(x, y)) {
         std::cerr << "MineGame::TouchFlag(x=" << x << ", y=" << y << "): run time error due to invalid input" << std::endl;
         return;
     }
 
-    if (this->game_state == MineGame::State::GAME_RUNNING || this->game_state == MineGame::State::GAME_READY) {
-        if (this->GetGridState(x, y) == MineGameGrid::State::STATE_COVERED) {
-            this->SetGridState(x, y, MineGameGrid::State::STATE_FLAGGED);
-            this->flag_count += 1;
-        } else if (this->GetGridState(x, y) == MineGameGrid::State::STATE_FLAGGED) {
-            this->SetGridState(x, y, MineGameGrid::State::STATE_COVERED);
-            this->flag_count -= 1;
-        }
-    }
+    MineGame::State previous = this->game_state;
+
+    this->ApplyFlag(this->GridIndex(x, y));
+    this->LogGameEnd(previous);
 }
 
 void MineGame::Open(int x, int y)
 {
-    std::cout << "MineGame::Open(x=" << x << ", y=" << y << ")" << std::endl;
+    if (this->verbose) {
+        std::cout << "MineGame::Open(x=" << x << ", y=" << y << ")" << std::endl;
+    }
 
     if (!this->IsValidPoint(x, y)) {
         std::cerr << "MineGame::Open(x=" << x << ", y=" << y << "): run time error due to invalid input" << std::endl;
         return;
     }
 
+    int index = this->GridIndex(x, y);
+    MineGame::State previous = this->game_state;
+
     // lazy init
     if (this->game_state == MineGame::State::GAME_READY) {
+        if (this->verbose) {
+            std::cout << "InitMines(skip_x=" << x << ", skip_y=" << y << ")" << std::endl;
+        }
+
         this->InitMines(x, y);
 
         // this is for debugging
-        for (int y = 0; y < this->height; y++) {
+        for (int y = 0; y < this->height && this->verbose; y++) {
             for (int x = 0; x < this->width; x++) {
-                std::cout << std::setw(4) << this->mine_map[y][x];
+                std::cout << std::setw(4) << this->mine_map[this->GridIndex(x, y)];
             }
 
             std::cout << std::endl;
         }
     }
 
-    if (this->game_state == MineGame::State::GAME_RUNNING) {
-        if (this->GetGridState(x, y) == MineGameGrid::State::STATE_COVERED) {
-            std::cout << "debug: x=" << x << ", y=" << y << ", has_mine = " << this->HasMine(x, y) << ", mine_map = " << this->mine_map[y][x] << std::endl;
+    if (this->verbose && this->game_state == MineGame::State::GAME_RUNNING && this->grid_state_map[index] == MineGameGrid::State::STATE_COVERED) {
+        std::cout << "debug: x=" << x << ", y=" << y << ", has_mine = " << this->HasMine(index) << ", mine_map = " << this->mine_map[index] << std::endl;
+    }
 
-            if (this->HasMine(x, y)) {
-                this->EndGame(x, y);
-            } else {
-                this->OpenRecursive(x, y);
+    this->ApplyOpen(index);
+    this->LogGameEnd(previous);
+}
 
-                if (this->remaining_count == 0) {
-                    this->WinGame();
-                }
-            }
-        }
+void MineGame::OpenFast(int x, int y)
+{
+    if (this->verbose) {
+        std::cout << "MineGame::OpenFast(x=" << x << ", y=" << y << ")" << std::endl;
+    }
+
+    if (!this->IsValidPoint(x, y)) {
+        std::cerr << "MineGame::OpenFast(x=" << x << ", y=" << y << "): run time error due to invalid input" << std::endl;
+        return;
+    }
+
+    MineGame::State previous = this->game_state;
+
+    this->ApplyChord(this->GridIndex(x, y));
+    this->LogGameEnd(previous);
+}
+
+void MineGame::LogGameEnd(MineGame::State previous)
+{
+    if (!this->verbose || this->game_state == previous) {
+        return;
+    }
+
+    if (this->game_state == MineGame::State::GAME_LOST) {
+        std::cout << "You've lost" << std::endl;
+    } else if (this->game_state == MineGame::State::GAME_WON) {
+        std::cout << "You won!!!" << std::endl;
     }
 }
 
-void MineGame::OpenFast(int x, int y)
+MineGameMove::Outcome MineGame::ApplyMove(const MineGameMove &move)
+{
+    if (this->game_state == MineGame::State::GAME_WON || this->game_state == MineGame::State::GAME_LOST) {
+        return MineGameMove::Outcome::OUTCOME_SKIPPED;
+    } else if (!this->IsValidPoint(move.x, move.y)) {
+        return MineGameMove::Outcome::OUTCOME_INVALID;
+    } else if (move.op == MineGameMove::Op::MOVE_OPEN) {
+        return this->ApplyOpen(this->GridIndex(move.x, move.y));
+    } else if (move.op == MineGameMove::Op::MOVE_FLAG) {
+        return this->ApplyFlag(this->GridIndex(move.x, move.y));
+    } else if (move.op == MineGameMove::Op::MOVE_CHORD) {
+        return this->ApplyChord(this->GridIndex(move.x, move.y));
+    }
+
+    return MineGameMove::Outcome::OUTCOME_INVALID;
+}
+
+int MineGame::ApplyMoves(const MineGameMove *moves, int count, MineGameMove::Outcome *outcomes, std::vector<MineGameGrid> &delta)
 {
+    int applied = 0;
+
+    // NOTE: nothing in this loop logs or allocates, maps and lists are sized by AllocateMap
+    for (int i = 0; i < count; i++) {
+        outcomes[i] = this->ApplyMove(moves[i]);
+
+        if (outcomes[i] != MineGameMove::Outcome::OUTCOME_SKIPPED) {
+            applied += 1;
+        }
+    }
+
+    // one delta for the whole batch, dirty_list already holds every grid once
+    delta.clear();
+    this->GetDirtyGrids(delta);
+    this->ClearDirtyGrids();
+
+    return applied;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////
 
 void MineGame::InitMines(int skip_x, int skip_y)
 {
-    std::cout << "InitMines(skip_x=" << skip_x << ", skip_y=" << skip_y << ")" << std::endl;
+    // a board from the supply, or a new uniform one when the supply does not know this size
+    if (this->supply == NULL || !this->supply->Take(this->width, this->height, this->mine_count, this->layout)) {
+        this->layout.Generate(this->width, this->height, this->mine_count, this->random);
+    }
+
+    this->MakeSafe(skip_x, skip_y);
+    this->ApplyLayout();
+}
+
+void MineGame::MakeSafe(int skip_x, int skip_y)
+{
+    int w = this->width, h = this->height;
+    int count = (w == h) ? 8 : 4;
+    int first = (int)this->random.NextBelow((uint32_t)count);
+    int dx = 0, dy = 0;
+
+    // try the symmetries of the board in a random order, they keep 3BV of targeted boards
+    // bit 0 mirrors x, bit 1 mirrors y, bit 2 transposes (square boards only)
+    for (int i = 0; i < count; i++) {
+        int t = (first + i) % count;
+        int sx = (t & 4) ? skip_y : skip_x;
+        int sy = (t & 4) ? skip_x : skip_y;
+
+        sx = (t & 1) ? (w - 1 - sx) : sx;
+        sy = (t & 2) ? (h - 1 - sy) : sy;
+
+        if (this->layout.HasMine(sx, sy)) {
+            continue;
+        }
+
+        if (t == 0) {
+            return;
+        }
 
-    std::srand (unsigned(std::time(0)));
+        this->remap.Resize(w, h);
 
-    // place mines randomly with random_shuffle
-    int map_size = this->width * this->height - 1;
-    int map[map_size];
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                int ux = (t & 4) ? y : x;
+                int uy = (t & 4) ? x : y;
 
-    for (int i = 0; i < this->mine_count; i++) {
-        // -1: mine
-        map[i] = -1;
+                ux = (t & 1) ? (w - 1 - ux) : ux;
+                uy = (t & 2) ? (h - 1 - uy) : uy;
+
+                if (this->layout.HasMine(ux, uy)) {
+                    this->remap.SetMine(x, y, true);
+                }
+            }
+        }
+
+        this->layout = this->remap;
+        return;
     }
 
-    for (int i = this->mine_count; i < map_size; i++) {
-        // -2: unknown
-        map[i] = -2;
+    // the clicked grid is a mine in every symmetry, wrap the board around so a random free grid lands under it
+    while (true) {
+        int z = (int)this->random.NextBelow((uint32_t)(w * h));
+
+        if (!this->layout.HasMine(z % w, z / w)) {
+            dx = z % w - skip_x + w;
+            dy = z / w - skip_y + h;
+            break;
+        }
     }
 
-    std::random_shuffle(map, map + map_size);
+    this->remap.Resize(w, h);
 
-    // place mines to the correct location on map
-    int skip = skip_y * this->width + skip_x;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            if (this->layout.HasMine((x + dx) % w, (y + dy) % h)) {
+                this->remap.SetMine(x, y, true);
+            }
+        }
+    }
+
+    this->layout = this->remap;
+}
+
+void MineGame::ApplyLayout()
+{
+    this->mine_list.clear();
 
     for (int y = 0; y < this->height; y++) {
         for (int x = 0; x < this->width; x++) {
-            int z = y * this->width + x;
+            int index = this->GridIndex(x, y);
 
-            if (z < skip) {
-                this->mine_map[y][x] = map[z];
-            } else if (z > skip) {
-                this->mine_map[y][x] = map[z - 1];
-            } else {
-                this->mine_map[y][x] = -2;
+            // -1: mine, -2: unknown
+            this->mine_map[index] = this->layout.HasMine(x, y) ? -1 : -2;
+
+            if (this->mine_map[index] == -1) {
+                this->mine_list.push_back(index);
             }
         }
     }
 
     // calculate neighbors and complete both maps
+    // NOTE: sentinel grids are never mines, so no bounds checks are needed
     for (int y = 0; y < this->height; y++) {
         for (int x = 0; x < this->width; x++) {
-            if (this->mine_map[y][x] != -1) {
-                int up = y - 1, down = y + 1, left = x - 1, right = x + 1;
+            int index = this->GridIndex(x, y);
+
+            this->opening_parent[index] = index;
+
+            if (this->mine_map[index] != -1) {
                 int count = 0;
 
-                if (this->HasMine(left, up)) count++;
-                if (this->HasMine(left, y)) count++;
-                if (this->HasMine(left, down)) count++;
-                if (this->HasMine(x, up)) count++;
-                if (this->HasMine(x, down)) count++;
-                if (this->HasMine(right, up)) count++;
-                if (this->HasMine(right, y)) count++;
-                if (this->HasMine(right, down)) count++;
+                for (int k = this->adjacency_start[index]; k < this->adjacency_start[index + 1]; k++) {
+                    count += (this->mine_map[this->adjacency[k]] == -1);
+                }
+
+                this->mine_map[index] = count;
 
-                this->mine_map[y][x] = count;
+                // union with 0 neighbors that are already counted, grids are visited in index order
+                if (count == 0) {
+                    for (int k = this->adjacency_start[index]; k < this->adjacency_start[index + 1]; k++) {
+                        int n = this->adjacency[k];
+
+                        if (n < index && this->mine_map[n] == 0) {
+                            this->opening_parent[this->FindOpeningRoot(n)] = this->FindOpeningRoot(index);
+                        }
+                    }
+                }
             }
 
             // NOTE: InitMines does not change grid_state_map, because flags can be placed prior to init 
-            // this->grid_state_map[y][x] = MineGameGrid::State::STATE_COVERED;
+            // this->grid_state_map[index] = MineGameGrid::State::STATE_COVERED;
         }
     }
 
+    this->BuildOpenings();
+
     // NOTE: InitMines does not change flag_count, because flags can be placed prior to init 
     //this->flag_count = 0;
     this->remaining_count = this->width * this->height - this->mine_count;
@@ -266,19 +462,41 @@ void MineGame::InitMines(int skip_x, int skip_y)
 int MineGame::AllocateMap(int width, int height)
 {
     if (width > 0 && height > 0) {
-        // allocate mine map and flag map
-        this->mine_map = new int* [height];
-        this->grid_state_map = new MineGameGrid::State* [height];
-        this->grid_dirty_map = new int* [height];
-
-        for (int i = 0; i < height; i++) {
-            this->mine_map[i] = new int [width];
-            this->grid_state_map[i] = new MineGameGrid::State [width];
-            this->grid_dirty_map[i] = new int [width];
-        }
+        this->stride = width + 2;
+        this->padded_size = (width + 2) * (height + 2);
+
+        // allocate mine map and flag map, including the sentinel ring
+        this->mine_map = new int [this->padded_size];
+        this->grid_state_map = new unsigned char [this->padded_size];
+        this->grid_dirty_map = new int [this->padded_size];
+
+        // allocate neighbor table, every grid has at most 8 neighbors
+        this->adjacency_start = new int [this->padded_size + 1];
+        this->adjacency = new int [width * height * 8];
+
+        // allocate opening index
+        this->opening_label = new int [this->padded_size];
+        this->opening_parent = new int [this->padded_size];
 
         this->width = width;
         this->height = height;
+
+        // every grid is dirty at most once, so the list never grows after this
+        this->dirty_list.clear();
+        this->dirty_list.reserve(width * height);
+        this->mine_list.clear();
+        this->mine_list.reserve(width * height);
+
+        // a number touches at most 4 different openings, so opening_grids holds less than 4 entries per grid
+        this->opening_start.reserve(width * height + 1);
+        this->opening_grids.reserve(width * height * 4);
+        this->opening_zeros.reserve(width * height);
+        this->opening_fill.reserve(width * height);
+
+        this->layout.Resize(width, height);
+        this->remap.Resize(width, height);
+
+        this->BuildAdjacency();
     }
 
     return 0;
@@ -288,90 +506,347 @@ void MineGame::FreeMap()
 {
     // free mine map
     if (this->mine_map != NULL) {
-        for (int i = 0; i < this->height; i++) {
-            delete [] this->mine_map[i];
-        }
-
         delete [] this->mine_map;
         this->mine_map = NULL;
     }
 
     // free flag map
     if (this->grid_state_map != NULL) {
-        for (int i = 0; i < this->height; i++) {
-            delete [] this->grid_state_map[i];
-        }
-
         delete [] this->grid_state_map;
         this->grid_state_map = NULL;
     }
 
     // free dirty map
     if (this->grid_dirty_map != NULL) {
-        for (int i = 0; i < this->height; i++) {
-            delete [] this->grid_dirty_map[i];
-        }
-
         delete [] this->grid_dirty_map;
         this->grid_dirty_map = NULL;
     }
 
+    // free neighbor table
+    if (this->adjacency_start != NULL) {
+        delete [] this->adjacency_start;
+        this->adjacency_start = NULL;
+    }
+
+    if (this->adjacency != NULL) {
+        delete [] this->adjacency;
+        this->adjacency = NULL;
+    }
+
+    // free opening index
+    if (this->opening_label != NULL) {
+        delete [] this->opening_label;
+        this->opening_label = NULL;
+    }
+
+    if (this->opening_parent != NULL) {
+        delete [] this->opening_parent;
+        this->opening_parent = NULL;
+    }
+
     this->width = 0;
     this->height = 0;
+    this->stride = 0;
+    this->padded_size = 0;
 }
 
-void MineGame::EndGame(int explode_x, int explode_y)
+void MineGame::ClearMap()
 {
-    this->SetGridState(explode_x, explode_y, MineGameGrid::State::STATE_MINE_EXPLODE);
+    // sentinel ring first, then the board itself
+    for (int i = 0; i < this->padded_size; i++) {
+        this->mine_map[i] = -3;
+        this->grid_state_map[i] = MineGameGrid::State::STATE_BORDER;
+        this->grid_dirty_map[i] = 0;
+        this->opening_label[i] = -1;
+    }
+
+    // every grid may have changed, views and shared boards look at the counter to notice
+    this->change_count += 1;
+    this->dirty_list.clear();
+    this->mine_list.clear();
+    this->opening_start.assign(1, 0);
+    this->opening_grids.clear();
 
-    // uncovered all mines
     for (int y = 0; y < this->height; y++) {
         for (int x = 0; x < this->width; x++) {
-            if (this->HasMine(x, y) && this->GetGridState(x, y) == MineGameGrid::State::STATE_COVERED) {
-                this->SetGridState(x, y, MineGameGrid::State::STATE_MINE_OPEN);
+            int index = this->GridIndex(x, y);
+
+            this->mine_map[index] = 0;
+            this->grid_state_map[index] = MineGameGrid::State::STATE_COVERED;
+        }
+    }
+}
+
+void MineGame::BuildAdjacency()
+{
+    int s = this->stride;
+    int offsets[8] = {-s - 1, -s, -s + 1, -1, 1, s - 1, s, s + 1};
+    int n = 0;
+
+    for (int k = 0; k < 8; k++) {
+        this->neighbor_offsets[k] = offsets[k];
+    }
+
+    // sentinel grids have no neighbors, board grids have all 8 (some of them are sentinels)
+    for (int i = 0; i < this->padded_size; i++) {
+        int x = i % s - 1;
+        int y = i / s - 1;
+
+        this->adjacency_start[i] = n;
+
+        if (this->IsValidPoint(x, y)) {
+            for (int k = 0; k < 8; k++) {
+                this->adjacency[n++] = i + this->neighbor_offsets[k];
             }
         }
     }
 
-    this->game_state = MineGame::State::GAME_LOST;
-    std::cout << "You've lost" << std::endl;
+    this->adjacency_start[this->padded_size] = n;
 }
 
-void MineGame::WinGame()
+int MineGame::FindOpeningRoot(int index)
 {
-    // show all uncovered flags
+    // path halving
+    while (this->opening_parent[index] != index) {
+        this->opening_parent[index] = this->opening_parent[this->opening_parent[index]];
+        index = this->opening_parent[index];
+    }
+
+    return index;
+}
+
+void MineGame::BuildOpenings()
+{
+    int count = 0;
+
+    // give every union-find root a compact label, opening_parent[root] is reused to hold it
     for (int y = 0; y < this->height; y++) {
         for (int x = 0; x < this->width; x++) {
-            if (this->HasMine(x, y) && this->GetGridState(x, y) == MineGameGrid::State::STATE_COVERED) {
-                this->SetGridState(x, y, MineGameGrid::State::STATE_FLAGGED);
+            int index = this->GridIndex(x, y);
+
+            this->opening_label[index] = -1;
+
+            if (this->mine_map[index] == 0 && this->FindOpeningRoot(index) == index) {
+                this->opening_label[index] = count++;
+            }
+        }
+    }
+
+    // bucket 0 grids by label with a counting sort
+    this->opening_start.assign(count + 1, 0);
+
+    for (int y = 0; y < this->height; y++) {
+        for (int x = 0; x < this->width; x++) {
+            int index = this->GridIndex(x, y);
+
+            if (this->mine_map[index] == 0) {
+                this->opening_label[index] = this->opening_label[this->FindOpeningRoot(index)];
+                this->opening_start[this->opening_label[index] + 1] += 1;
             }
         }
     }
 
+    for (int l = 0; l < count; l++) {
+        this->opening_start[l + 1] += this->opening_start[l];
+    }
+
+    std::vector<int> &zeros = this->opening_zeros;
+    std::vector<int> &next = this->opening_fill;
+
+    zeros.assign(this->opening_start[count], 0);
+    next.assign(this->opening_start.begin(), this->opening_start.end() - 1);
+
+    for (int y = 0; y < this->height; y++) {
+        for (int x = 0; x < this->width; x++) {
+            int index = this->GridIndex(x, y);
+
+            if (this->mine_map[index] == 0) {
+                zeros[next[this->opening_label[index]]++] = index;
+            }
+        }
+    }
+
+    // append the numbers around each opening, opening_parent marks the last opening a number was added to
+    for (int i = 0; i < this->padded_size; i++) {
+        this->opening_parent[i] = -1;
+    }
+
+    this->opening_grids.clear();
+
+    for (int l = 0; l < count; l++) {
+        int begin = this->opening_start[l];
+        int end = this->opening_start[l + 1];
+
+        this->opening_start[l] = (int)this->opening_grids.size();
+        this->opening_grids.insert(this->opening_grids.end(), zeros.begin() + begin, zeros.begin() + end);
+
+        for (int i = begin; i < end; i++) {
+            for (int k = this->adjacency_start[zeros[i]]; k < this->adjacency_start[zeros[i] + 1]; k++) {
+                int n = this->adjacency[k];
+
+                if (this->mine_map[n] > 0 && this->opening_parent[n] != l) {
+                    this->opening_parent[n] = l;
+                    this->opening_grids.push_back(n);
+
+                    if (this->opening_label[n] == -1) {
+                        this->opening_label[n] = l;
+                    }
+                }
+            }
+        }
+    }
+
+    this->opening_start[count] = (int)this->opening_grids.size();
+}
+
+MineGameMove::Outcome MineGame::ApplyOpen(int index)
+{
+    // lazy init
+    if (this->game_state == MineGame::State::GAME_READY) {
+        this->InitMines(index % this->stride - 1, index / this->stride - 1);
+    }
+
+    if (this->game_state != MineGame::State::GAME_RUNNING || this->grid_state_map[index] != MineGameGrid::State::STATE_COVERED) {
+        return MineGameMove::Outcome::OUTCOME_UNCHANGED;
+    }
+
+    if (this->HasMine(index)) {
+        this->EndGame(index);
+        return MineGameMove::Outcome::OUTCOME_LOST;
+    }
+
+    this->OpenArea(index);
+
+    if (this->remaining_count == 0) {
+        this->WinGame();
+        return MineGameMove::Outcome::OUTCOME_WON;
+    }
+
+    return MineGameMove::Outcome::OUTCOME_CHANGED;
+}
+
+MineGameMove::Outcome MineGame::ApplyFlag(int index)
+{
+    if (this->game_state == MineGame::State::GAME_RUNNING || this->game_state == MineGame::State::GAME_READY) {
+        if (this->grid_state_map[index] == MineGameGrid::State::STATE_COVERED) {
+            this->SetGridState(index, MineGameGrid::State::STATE_FLAGGED);
+            this->flag_count += 1;
+            return MineGameMove::Outcome::OUTCOME_CHANGED;
+        } else if (this->grid_state_map[index] == MineGameGrid::State::STATE_FLAGGED) {
+            this->SetGridState(index, MineGameGrid::State::STATE_COVERED);
+            this->flag_count -= 1;
+            return MineGameMove::Outcome::OUTCOME_CHANGED;
+        }
+    }
+
+    return MineGameMove::Outcome::OUTCOME_UNCHANGED;
+}
+
+MineGameMove::Outcome MineGame::ApplyChord(int index)
+{
+    MineGameGrid::State state = (MineGameGrid::State)this->grid_state_map[index];
+    long long before = this->change_count;
+    int flags = 0, explode = -1;
+
+    if (this->game_state != MineGame::State::GAME_RUNNING || state < MineGameGrid::State::STATE_MINE_1 || state > MineGameGrid::State::STATE_MINE_8) {
+        return MineGameMove::Outcome::OUTCOME_UNCHANGED;
+    }
+
+    for (int k = this->adjacency_start[index]; k < this->adjacency_start[index + 1]; k++) {
+        flags += (this->grid_state_map[this->adjacency[k]] == MineGameGrid::State::STATE_FLAGGED);
+    }
+
+    // NOTE: the number is also the state, see MineGameGrid::State
+    if (flags != (int)state) {
+        return MineGameMove::Outcome::OUTCOME_UNCHANGED;
+    }
+
+    // a wrong flag means a covered mine here, the first one explodes
+    for (int k = this->adjacency_start[index]; k < this->adjacency_start[index + 1]; k++) {
+        int n = this->adjacency[k];
+
+        if (this->grid_state_map[n] == MineGameGrid::State::STATE_COVERED) {
+            if (this->HasMine(n)) {
+                explode = (explode < 0) ? n : explode;
+            } else {
+                this->OpenArea(n);
+            }
+        }
+    }
+
+    if (explode >= 0) {
+        this->EndGame(explode);
+        return MineGameMove::Outcome::OUTCOME_LOST;
+    }
+
+    if (this->remaining_count == 0) {
+        this->WinGame();
+        return MineGameMove::Outcome::OUTCOME_WON;
+    }
+
+    return (this->change_count != before) ? MineGameMove::Outcome::OUTCOME_CHANGED : MineGameMove::Outcome::OUTCOME_UNCHANGED;
+}
+
+void MineGame::EndGame(int explode)
+{
+    this->SetGridState(explode, MineGameGrid::State::STATE_MINE_EXPLODE);
+
+    // uncovered all mines
+    for (size_t i = 0; i < this->mine_list.size(); i++) {
+        int index = this->mine_list[i];
+
+        if (this->grid_state_map[index] == MineGameGrid::State::STATE_COVERED) {
+            this->SetGridState(index, MineGameGrid::State::STATE_MINE_OPEN);
+        }
+    }
+
+    this->game_state = MineGame::State::GAME_LOST;
+}
+
+void MineGame::WinGame()
+{
+    // show all uncovered flags
+    for (size_t i = 0; i < this->mine_list.size(); i++) {
+        int index = this->mine_list[i];
+
+        if (this->grid_state_map[index] == MineGameGrid::State::STATE_COVERED) {
+            this->SetGridState(index, MineGameGrid::State::STATE_FLAGGED);
+        }
+    }
+
     this->flag_count = this->mine_count;
 
     this->game_state = MineGame::State::GAME_WON;
-    std::cout << "You won!!!" << std::endl;
 }
 
-void MineGame::OpenRecursive(int x, int y)
+void MineGame::OpenArea(int index)
 {
-    if (!this->IsValidPoint(x, y)) {
-        return;
+    // a 0 grid opens its whole opening, which InitMines already collected
+    if (this->mine_map[index] == 0) {
+        int label = this->opening_label[index];
+
+        for (int k = this->opening_start[label]; k < this->opening_start[label + 1]; k++) {
+            this->OpenGrid(this->opening_grids[k]);
+        }
+    } else {
+        this->OpenGrid(index);
     }
+}
 
-    if (this->grid_state_map[y][x] != MineGameGrid::State::STATE_COVERED && this->grid_state_map[y][x] != MineGameGrid::State::STATE_FLAGGED) {
+void MineGame::OpenGrid(int index)
+{
+    if (this->grid_state_map[index] != MineGameGrid::State::STATE_COVERED && this->grid_state_map[index] != MineGameGrid::State::STATE_FLAGGED) {
         return;
     }
 
-    // NOTE: should not reach to any mine in OpenRecursive
-    if (this->mine_map[y][x] < 0) {
-        std::cerr << "MineGame::OpenRecursive(x=" << x << ", y=" << y << "): run time error" << std::endl;
+    // NOTE: should not reach to any mine in OpenGrid
+    if (this->mine_map[index] < 0) {
+        std::cerr << "MineGame::OpenGrid(index=" << index << "): run time error" << std::endl;
         return;
     }
 
     // adjust flag_count and remaining count
-    if (this->GetGridState(x, y) == MineGameGrid::State::STATE_FLAGGED) {
+    if (this->grid_state_map[index] == MineGameGrid::State::STATE_FLAGGED) {
         this->flag_count -= 1;
     }
 
@@ -379,21 +854,7 @@ void MineGame::OpenRecursive(int x, int y)
 
     // NOTE: update grid based on mine count
     // we use this conversion trick because MineGame::State declaration is carefully arranged
-    this->SetGridState(x, y, (MineGameGrid::State)this->mine_map[y][x]);
-
-    // expand if we click on a 0
-    if (this->mine_map[y][x] == 0) {
-        int up = y - 1, down = y + 1, left = x - 1, right = x + 1;
-
-        this->OpenRecursive(left, up);
-        this->OpenRecursive(left, y);
-        this->OpenRecursive(left, down);
-        this->OpenRecursive(x, up);
-        this->OpenRecursive(x, down);
-        this->OpenRecursive(right, up);
-        this->OpenRecursive(right, y);
-        this->OpenRecursive(right, down);
-    }
+    this->SetGridState(index, (MineGameGrid::State)this->mine_map[index]);
 }
 
 
@@ -406,33 +867,26 @@ bool MineGame::IsValidPoint(int x, int y)
     }
 }
 
-bool MineGame::HasMine(int x, int y)
+bool MineGame::HasMine(int index)
 {
-    if (this->IsValidPoint(x, y)) {
-        if (this->mine_map[y][x] == -1) {
-            return true;
-        }
-    }
-
-    return false;
+    return this->mine_map[index] == -1;
 }
 
-bool MineGame::IsDirtyGrid(int x, int y) 
+bool MineGame::IsDirtyGrid(int index)
 {
-    if (this->IsValidPoint(x, y)) {
-        if (this->grid_dirty_map[y][x] == 1) {
-            return true;
-        }
-    }
-
-    return false;
+    return this->grid_dirty_map[index] == 1;
 }
 
-void MineGame::SetGridState(int x, int y, MineGameGrid::State state)
+void MineGame::SetGridState(int index, MineGameGrid::State state)
 {
-    if (this->grid_state_map[y][x] != state) {
-        this->grid_state_map[y][x] = state;
-        this->grid_dirty_map[y][x] = 1;
+    if (this->grid_state_map[index] != state) {
+        this->grid_state_map[index] = state;
+        this->change_count += 1;
+
+        if (!this->IsDirtyGrid(index)) {
+            this->grid_dirty_map[index] = 1;
+            this->dirty_list.push_back(index);
+        }
     }
 }
 
@@ -448,3 +902,30 @@ MineGameGrid::~MineGameGrid()
 {
 
 }
+
+////////////////////////////////////////////////////////////////////////////////////
+MineGameMove::MineGameMove()
+{
+    this->op = MineGameMove::Op::MOVE_OPEN;
+    this->x = 0;
+    this->y = 0;
+}
+
+MineGameMove::~MineGameMove()
+{
+
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+MineGameView::MineGameView(const unsigned char *state, int width, int height, int stride)
+{
+    this->state = state;
+    this->width = width;
+    this->height = height;
+    this->stride = stride;
+}
+
+MineGameView::~MineGameView()
+{
+
+}
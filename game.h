@@ -1,9 +1,17 @@
 #include <iostream>
 #include <vector>
+#include <stdint.h>
+#include "layout.h"
 
 #ifndef __MINE_GAME_H__
 #define __MINE_GAME_H__
 
+class MineBoardSupply;
+
+// largest board SetCustom accepts, larger sizes are clamped to it
+#define MINE_GAME_MAX_WIDTH 1000
+#define MINE_GAME_MAX_HEIGHT 1000
+
 class MineGameGrid {
     public:
         enum State {
@@ -20,7 +28,9 @@ class MineGameGrid {
             STATE_FLAGGED = 10,
             STATE_FLAGGED_WRONG = 11, 
             STATE_MINE_EXPLODE = 12, 
-            STATE_MINE_OPEN = 13
+            STATE_MINE_OPEN = 13,
+            // sentinel ring around the board, never reported to UI
+            STATE_BORDER = 14
         };
 
     public:
@@ -33,6 +43,61 @@ class MineGameGrid {
         ~MineGameGrid();
 };
 
+// one move of a batch for MineGame::ApplyMoves
+class MineGameMove {
+    public:
+        enum Op {
+            MOVE_OPEN = 0,
+            MOVE_FLAG = 1,
+            // open the covered neighbors of an open number once enough flags are around it
+            MOVE_CHORD = 2
+        };
+
+        enum Outcome {
+            // some grids changed
+            OUTCOME_CHANGED = 0,
+            // valid, but nothing to do (already open, flag on an open grid, ...)
+            OUTCOME_UNCHANGED = 1,
+            // out of the board or unknown op
+            OUTCOME_INVALID = 2,
+            // this move ended the game
+            OUTCOME_LOST = 3,
+            OUTCOME_WON = 4,
+            // not applied, the game was already over
+            OUTCOME_SKIPPED = 5
+        };
+
+    public:
+        Op op;
+        int x;
+        int y;
+
+    public:
+        MineGameMove();
+        ~MineGameMove();
+};
+
+// read only view of the visible grids, straight into the game's state buffer, nothing is copied
+// valid until the board size changes; rows are contiguous, one MineGameGrid::State byte per grid
+class MineGameView {
+    public:
+        MineGameView(const unsigned char *state, int width, int height, int stride);
+        ~MineGameView();
+
+        int GetWidth() const { return this->width; }
+        int GetHeight() const { return this->height; }
+
+        MineGameGrid::State GetGridState(int x, int y) const { return (MineGameGrid::State)this->GetRow(y)[x]; }
+        // grids (0, y) to (width - 1, y)
+        const unsigned char *GetRow(int y) const { return this->state + (y + 1) * this->stride + 1; }
+
+    private:
+        const unsigned char *state;
+        int width;
+        int height;
+        int stride;
+};
+
 class MineGame {
     public:
         enum State {
@@ -50,6 +115,8 @@ class MineGame {
         int GetHeight() const { return this->height; }
         int GetMineCount() const { return this->mine_count; }
         int GetFlagCount() const { return this->flag_count; }
+        // covered grids without a mine
+        int GetRemainingCount() const { return this->remaining_count; }
 
         void SetBeginner();
         void SetIntermediate();
@@ -57,30 +124,80 @@ class MineGame {
         void SetCustom(int width, int height, int mine_count);
         void Reset();
 
-        State GetGameState();
+        // boards are taken from supply when it has one of the current size, NULL generates them on the first Open
+        void SetBoardSupply(MineBoardSupply *supply);
+        void SetSeed(uint64_t seed);
+        // log moves and dump the mine map to stdout (default: on)
+        void SetVerbose(bool verbose);
+
+        State GetGameState() const;
         MineGameGrid::State GetGridState(int x, int y);
+
+        // visible state of every grid, one MineGameGrid::State byte each, sentinel ring included
+        // grid (x, y) is at (y + 1) * GetStride() + (x + 1); the buffer moves when the size changes
+        const unsigned char *GetStateBuffer() const;
+        int GetStride() const { return this->stride; }
+        MineGameView GetView() const;
+        // bumped on every visible grid change, to tell whether anything changed since a given point
+        long long GetChangeCount() const { return this->change_count; }
+
         void GetDirtyGrids(std::vector<MineGameGrid> &grids);
         void ClearDirtyGrids();
 
+        // openings (connected areas of 0 grids plus the numbers around them), available once mines are placed
+        // label is -1 for mines and for numbers not touching any opening,
+        // a number touching several openings reports one of them
+        int GetOpeningCount();
+        int GetOpeningLabel(int x, int y);
+        void GetOpeningGrids(int label, std::vector<MineGameGrid> &grids);
+
+        // mine layout of the current board, empty until mines are placed by the first Open
+        void GetMineLayout(MineBoardLayout &layout);
+
         void TouchFlag(int x, int y);
         void Open(int x, int y);
+        // chord: open every covered, unflagged neighbor of an open number that has as many flags around it
         void OpenFast(int x, int y);
 
+        // one move without logging, grids it changes stay dirty until ClearDirtyGrids
+        MineGameMove::Outcome ApplyMove(const MineGameMove &move);
+
+        // applies count moves in order and writes one outcome per move, without logging or allocating
+        // the move that loses or wins is the last one applied, the rest are OUTCOME_SKIPPED
+        // delta gets every grid changed since the last ClearDirtyGrids once, and dirty grids are cleared
+        // returns the number of moves applied
+        int ApplyMoves(const MineGameMove *moves, int count, MineGameMove::Outcome *outcomes, std::vector<MineGameGrid> &delta);
+
     private:
         void InitMines(int skip_x, int skip_y);
+        void MakeSafe(int skip_x, int skip_y);
+        void ApplyLayout();
 
         int AllocateMap(int width, int height);
         void FreeMap();
 
-        void EndGame(int explode_x, int explode_y);
+        void ClearMap();
+        void BuildAdjacency();
+        int FindOpeningRoot(int index);
+        void BuildOpenings();
+
+        MineGameMove::Outcome ApplyOpen(int index);
+        MineGameMove::Outcome ApplyFlag(int index);
+        MineGameMove::Outcome ApplyChord(int index);
+
+        void EndGame(int explode);
         void WinGame();
-        void OpenRecursive(int x, int y);
+        // the public moves print the end of the game, ApplyMove stays quiet
+        void LogGameEnd(MineGame::State previous);
+        void OpenArea(int index);
+        void OpenGrid(int index);
 
         bool IsValidPoint(int x, int y);
-        bool HasMine(int x, int y);
+        int GridIndex(int x, int y) const { return (y + 1) * this->stride + (x + 1); }
+        bool HasMine(int index);
 
-        bool IsDirtyGrid(int x, int y);
-        void SetGridState(int x, int y, MineGameGrid::State state);
+        bool IsDirtyGrid(int index);
+        void SetGridState(int index, MineGameGrid::State state);
 
     private:
         int width;
@@ -88,14 +205,53 @@ class MineGame {
         int mine_count;
         int flag_count;
         int remaining_count;
-        // -2: unknown, -1: mine, 0: no mines, 1: 1 mine, 2: 2 mines, etc...
-        int **mine_map;
 
-        // represent user interface state
-        MineGameGrid::State **grid_state_map;
-        int **grid_dirty_map;
+        // all maps are (width + 2) * (height + 2) and surrounded by a one grid sentinel ring,
+        // so grid (x, y) is stored at (y + 1) * stride + (x + 1) and neighbors never go out of range
+        int stride;
+        int padded_size;
+
+        // -3: sentinel, -2: unknown, -1: mine, 0: no mines, 1: 1 mine, 2: 2 mines, etc...
+        int *mine_map;
+
+        // represent user interface state, one byte per grid holding a MineGameGrid::State
+        unsigned char *grid_state_map;
+        int *grid_dirty_map;
+
+        // grids changed since the last ClearDirtyGrids, in the order they changed
+        std::vector<int> dirty_list;
+
+        // grid index of every mine, filled by InitMines
+        std::vector<int> mine_list;
+
+        // bumped by every grid state change, tells a move that did something from one that did not
+        long long change_count;
+
+        // opening index, filled by InitMines
+        // grids of opening l are opening_grids[opening_start[l]] to opening_grids[opening_start[l + 1] - 1], 0 grids first
+        int *opening_label;
+        int *opening_parent;
+        std::vector<int> opening_start;
+        std::vector<int> opening_grids;
+
+        // BuildOpenings scratch, reserved by AllocateMap so the first Open does not allocate
+        std::vector<int> opening_zeros;
+        std::vector<int> opening_fill;
+
+        // neighbors in CSR form: neighbors of grid i are adjacency[adjacency_start[i]] to adjacency[adjacency_start[i + 1] - 1]
+        // BuildAdjacency fills it from neighbor_offsets, other topologies only need to fill a different table
+        int neighbor_offsets[8];
+        int *adjacency_start;
+        int *adjacency;
 
         State game_state;
+
+        // mine placement: layout of the current board and a buffer to remap it into
+        MineBoardSupply *supply;
+        MineRandom random;
+        MineBoardLayout layout;
+        MineBoardLayout remap;
+        bool verbose;
 };
 
 
@@ -0,0 +1,221 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include "layout.h"
+#include "metrics.h"
+#include "generator.h"
+
+class GeneratorCommand {
+    public:
+        GeneratorCommand();
+        ~GeneratorCommand();
+
+        int ParseArguments(int argc, char **argv);
+        int Run();
+        void ShowHelp();
+
+    private:
+        // options
+        int width, height, mine_count;
+        std::string level_name;
+        std::vector<int> ranges;
+        int count;
+        uint64_t seed;
+        int threads;
+        long long max_candidates;
+        bool dump_layout;
+        bool check;
+};
+
+////////////////////////////////////////////////////////////////////////////////////
+GeneratorCommand::GeneratorCommand()
+{
+    this->width = 30;
+    this->height = 16;
+    this->mine_count = 99;
+    this->level_name = "expert";
+    this->count = 1000;
+    this->seed = 1;
+    this->threads = (int)std::thread::hardware_concurrency();
+    this->max_candidates = 100000000LL;
+    this->dump_layout = false;
+    this->check = false;
+
+    if (this->threads <= 0) {
+        this->threads = 1;
+    }
+}
+
+GeneratorCommand::~GeneratorCommand()
+{
+
+}
+
+int GeneratorCommand::ParseArguments(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = (i + 1 < argc);
+
+        if (arg == "--level" && has_value) {
+            this->level_name = argv[++i];
+        } else if (arg == "--range" && has_value) {
+            int lo, hi;
+
+            if (std::sscanf(argv[++i], "%d-%d", &lo, &hi) != 2 || lo < 0 || hi < lo) {
+                std::cerr << "bad range " << argv[i] << std::endl;
+                return -1;
+            }
+
+            this->ranges.push_back(lo);
+            this->ranges.push_back(hi);
+        } else if (arg == "--count" && has_value) {
+            this->count = std::atoi(argv[++i]);
+        } else if (arg == "--seed" && has_value) {
+            this->seed = std::strtoull(argv[++i], NULL, 10);
+        } else if (arg == "--threads" && has_value) {
+            this->threads = std::atoi(argv[++i]);
+        } else if (arg == "--max-candidates" && has_value) {
+            this->max_candidates = std::atoll(argv[++i]);
+        } else if (arg == "--layout") {
+            this->dump_layout = true;
+        } else if (arg == "--check") {
+            this->check = true;
+        } else {
+            return -1;
+        }
+    }
+
+    const std::string &name = this->level_name;
+    int w, h, m;
+
+    if (name == "beginner") {
+        w = 9; h = 9; m = 10;
+    } else if (name == "intermediate") {
+        w = 16; h = 16; m = 40;
+    } else if (name == "expert") {
+        w = 30; h = 16; m = 99;
+    } else if (std::sscanf(name.c_str(), "%dx%dx%d", &w, &h, &m) != 3 || w <= 0 || h <= 0 || m < 0 || m >= w * h) {
+        std::cerr << "unknown level " << name << std::endl;
+        return -1;
+    }
+
+    this->width = w;
+    this->height = h;
+    this->mine_count = m;
+
+    if (this->ranges.empty()) {
+        this->ranges.push_back(0);
+        this->ranges.push_back(w * h);
+    }
+
+    this->threads = (this->threads <= 0) ? 1 : this->threads;
+    this->count = (this->count < 0) ? 0 : this->count;
+
+    return 0;
+}
+
+int GeneratorCommand::Run()
+{
+    MineBoardGenerator generator;
+    MineBoardAnalyzer analyzer;
+    MineBoardMetrics metrics;
+    int ret = 0;
+
+    generator.SetThreads(this->threads);
+    generator.SetMaxCandidates(this->max_candidates);
+
+    for (size_t r = 0; r < this->ranges.size(); r += 2) {
+        std::vector<MineBoardLayout> boards;
+        std::vector<int> bbbvs;
+        int lo = this->ranges[r], hi = this->ranges[r + 1];
+        int made, mismatch = 0;
+
+        generator.SetTarget(this->width, this->height, this->mine_count, lo, hi);
+        made = generator.Generate(this->count, this->seed, boards, bbbvs);
+
+        // NOTE: --check recomputes 3BV with the full analyzer, the sweep must agree on every board, not only on the range
+        for (size_t i = 0; i < boards.size(); i++) {
+            if (this->check || this->dump_layout) {
+                analyzer.Analyze(boards[i], metrics, false);
+            }
+
+            if (this->check && (metrics.bbbv != bbbvs[i] || metrics.bbbv < lo || metrics.bbbv > hi)) {
+                mismatch += 1;
+            }
+
+            if (this->dump_layout) {
+                std::printf("%d-%d %zu %d %s\n", lo, hi, i, metrics.bbbv, boards[i].ToString().c_str());
+            }
+        }
+
+        long long candidates = generator.GetCandidates();
+        double seconds = (generator.GetSeconds() > 0) ? generator.GetSeconds() : 1e-9;
+        double tried = (candidates > 0) ? (double)candidates : 1.0;
+
+        std::fflush(stdout);
+        std::printf("# range %d-%d level %s boards %d candidates %lld aborted %lld rows %.2f accept %.4f%%\n",
+                    lo, hi, this->level_name.c_str(), made, candidates, generator.GetAborted(),
+                    generator.GetRowsPlaced() / tried, 100.0 * (candidates - generator.GetAborted()) / tried);
+        std::printf("# range %d-%d %.3fs on %d threads, %.0f boards/s, %.0f candidates/s\n",
+                    lo, hi, generator.GetSeconds(), this->threads, made / seconds, candidates / seconds);
+
+        if (this->check) {
+            std::printf("# range %d-%d check %s, %d boards differ from the analyzer\n", lo, hi, (mismatch == 0) ? "ok" : "failed", mismatch);
+        }
+
+        if (made < this->count) {
+            std::cerr << "range " << lo << "-" << hi << ": only " << made << " boards in " << candidates << " candidates" << std::endl;
+            ret = 1;
+        }
+
+        if (mismatch > 0) {
+            ret = 1;
+        }
+    }
+
+    return ret;
+}
+
+void GeneratorCommand::ShowHelp()
+{
+    std::cout << "Minesweeper board generator with a target 3BV" << std::endl;
+    std::cout << std::endl;
+    std::cout << "mine-gen [options]" << std::endl;
+    std::cout << std::endl;
+    std::cout << "--level <name>           beginner, intermediate, expert or <w>x<h>x<m> (default: expert)" << std::endl;
+    std::cout << "--range <min>-<max>      3BV range of the boards, can be repeated, one report per range (default: any)" << std::endl;
+    std::cout << "--count <n>              Boards to generate per range (default: 1000)." << std::endl;
+    std::cout << "--seed <n>               Seed of the candidates (default: 1)." << std::endl;
+    std::cout << "--threads <n>            Worker threads (default: all cores)." << std::endl;
+    std::cout << "--max-candidates <n>     Give up on a range after n candidates (default: 100000000)." << std::endl;
+    std::cout << "--layout                 Print \"<range> <index> <3bv> <w> <h> <m> <hex>\" per board." << std::endl;
+    std::cout << "--check                  Recompute 3BV with the full analyzer, it must equal the sweep's on every board." << std::endl;
+    std::cout << std::endl;
+    std::cout << "Report lines start with #." << std::endl;
+}
+
+//////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+    GeneratorCommand *command;
+    int ret;
+
+    command = new GeneratorCommand();
+
+    if (command->ParseArguments(argc, argv) != 0) {
+        command->ShowHelp();
+        delete command;
+        return 1;
+    }
+
+    ret = command->Run();
+
+    delete command;
+
+    return ret;
+}
@@ -0,0 +1,367 @@
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include "generator.h"
+
+#define GENERATOR_CHUNK_SIZE 256
+
+MineBoardSweep::MineBoardSweep()
+{
+    this->width = 0;
+    this->height = 0;
+    this->stride = 0;
+    this->cells_left = 0;
+    this->mines_left = 0;
+    this->rows_placed = 0;
+    this->islands = 0;
+    this->openings = 0;
+    this->row_numbers = 0;
+    this->stamp_id = 0;
+
+    for (int k = 0; k < 8; k++) {
+        this->offsets[k] = 0;
+    }
+}
+
+MineBoardSweep::~MineBoardSweep()
+{
+
+}
+
+int MineBoardSweep::Run(int width, int height, int mine_count, int min_bbbv, int max_bbbv, MineRandom &random, MineBoardLayout &layout)
+{
+    if (this->width != width || this->height != height) {
+        this->Resize(width, height);
+    }
+
+    if (layout.GetWidth() != width || layout.GetHeight() != height) {
+        layout.Resize(width, height);
+    } else {
+        layout.Clear();
+    }
+
+    this->cells_left = width * height;
+    this->mines_left = mine_count;
+    this->rows_placed = 0;
+    this->islands = 0;
+    this->openings = 0;
+    this->row_numbers = 0;
+
+    // step t places row t, counts row t - 1 and decides which numbers of row t - 2 are islands
+    for (int t = 0; t <= height; t++) {
+        int row_free = 0;
+        int lower, upper;
+
+        if (t < height) {
+            int before = this->mines_left;
+
+            this->PlaceRow(t, random, layout);
+            row_free = width - (before - this->mines_left);
+        }
+
+        if (t >= 1) {
+            this->ProcessRow(t - 1);
+        }
+
+        if (t >= 2) {
+            this->FinalizeRow(t - 2);
+        }
+
+        if (t == height) {
+            this->FinalizeRow(height - 1);
+            lower = upper = this->islands + this->openings;
+        } else {
+            // openings that touch the last counted row may still merge, but not below one
+            int active = (t >= 1) ? this->CountActive(t - 1) : 0;
+            int closed = this->openings - active;
+
+            lower = this->islands + closed + ((active > 0) ? 1 : 0);
+
+            // every grid that is not decided yet adds at most one click
+            upper = this->islands + this->openings + ((t >= 1) ? this->row_numbers : 0) + row_free + (this->cells_left - this->mines_left);
+        }
+
+        if (lower > max_bbbv || upper < min_bbbv) {
+            return -1;
+        }
+    }
+
+    return this->islands + this->openings;
+}
+
+void MineBoardSweep::Resize(int width, int height)
+{
+    int s = width + 2;
+    int padded_size = (width + 2) * (height + 2);
+
+    this->width = width;
+    this->height = height;
+    this->stride = s;
+
+    int offsets[8] = {-s - 1, -s, -s + 1, -1, 1, s - 1, s, s + 1};
+
+    for (int k = 0; k < 8; k++) {
+        this->offsets[k] = offsets[k];
+    }
+
+    // the ring is never written, so it stays "no mine, not a 0"
+    this->mine.assign(padded_size, 0);
+    this->zero.assign(padded_size, 0);
+    this->number.assign(padded_size, 0);
+    this->parent.assign(padded_size, 0);
+    this->stamp.assign(padded_size, 0);
+    this->stamp_id = 0;
+}
+
+void MineBoardSweep::PlaceRow(int y, MineRandom &random, MineBoardLayout &layout)
+{
+    uint8_t *row = &this->mine[(y + 1) * this->stride + 1];
+
+    // selection sampling: every grid is a mine with probability mines_left / cells_left,
+    // which gives uniform layouts without knowing the rows below
+    for (int x = 0; x < this->width; x++) {
+        bool m = (int)random.NextBelow((uint32_t)this->cells_left) < this->mines_left;
+
+        row[x] = m ? 1 : 0;
+        this->cells_left -= 1;
+
+        if (m) {
+            this->mines_left -= 1;
+            layout.SetMine(x, y, true);
+        }
+    }
+
+    this->rows_placed += 1;
+}
+
+void MineBoardSweep::ProcessRow(int y)
+{
+    this->row_numbers = 0;
+
+    for (int x = 0; x < this->width; x++) {
+        int index = (y + 1) * this->stride + (x + 1);
+        int count = 0;
+
+        if (this->mine[index]) {
+            this->number[index] = -1;
+            this->zero[index] = 0;
+            continue;
+        }
+
+        for (int k = 0; k < 8; k++) {
+            count += this->mine[index + this->offsets[k]];
+        }
+
+        this->number[index] = (int8_t)count;
+        this->zero[index] = (count == 0) ? 1 : 0;
+
+        if (count > 0) {
+            this->row_numbers += 1;
+            continue;
+        }
+
+        // new opening, merged with 0 grids already counted (up-left, up, up-right, left)
+        this->parent[index] = index;
+        this->openings += 1;
+
+        for (int k = 0; k < 4; k++) {
+            int n = index + this->offsets[k];
+
+            if (this->zero[n]) {
+                int a = this->FindRoot(n);
+                int b = this->FindRoot(index);
+
+                if (a != b) {
+                    this->parent[a] = b;
+                    this->openings -= 1;
+                }
+            }
+        }
+    }
+}
+
+void MineBoardSweep::FinalizeRow(int y)
+{
+    for (int x = 0; x < this->width; x++) {
+        int index = (y + 1) * this->stride + (x + 1);
+        int near = 0;
+
+        if (this->number[index] <= 0) {
+            continue;
+        }
+
+        for (int k = 0; k < 8; k++) {
+            near |= this->zero[index + this->offsets[k]];
+        }
+
+        this->islands += near ? 0 : 1;
+    }
+}
+
+int MineBoardSweep::CountActive(int y)
+{
+    int active = 0;
+
+    this->stamp_id += 1;
+
+    for (int x = 0; x < this->width; x++) {
+        int index = (y + 1) * this->stride + (x + 1);
+
+        if (this->zero[index]) {
+            int r = this->FindRoot(index);
+
+            if (this->stamp[r] != this->stamp_id) {
+                this->stamp[r] = this->stamp_id;
+                active += 1;
+            }
+        }
+    }
+
+    return active;
+}
+
+int MineBoardSweep::FindRoot(int index)
+{
+    // path halving
+    while (this->parent[index] != index) {
+        this->parent[index] = this->parent[this->parent[index]];
+        index = this->parent[index];
+    }
+
+    return index;
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+MineBoardGenerator::MineBoardGenerator()
+{
+    this->width = 9;
+    this->height = 9;
+    this->mine_count = 10;
+    this->min_bbbv = 0;
+    this->max_bbbv = 9 * 9;
+    this->threads = (int)std::thread::hardware_concurrency();
+    this->max_candidates = 100000000LL;
+
+    this->candidates = 0;
+    this->aborted = 0;
+    this->rows_placed = 0;
+    this->seconds = 0;
+    this->next_chunk = 0;
+
+    if (this->threads <= 0) {
+        this->threads = 1;
+    }
+}
+
+MineBoardGenerator::~MineBoardGenerator()
+{
+
+}
+
+void MineBoardGenerator::SetTarget(int width, int height, int mine_count, int min_bbbv, int max_bbbv)
+{
+    this->width = width;
+    this->height = height;
+    this->mine_count = (mine_count >= width * height) ? (width * height - 1) : mine_count;
+    this->min_bbbv = min_bbbv;
+    this->max_bbbv = max_bbbv;
+}
+
+void MineBoardGenerator::SetThreads(int threads)
+{
+    this->threads = (threads <= 0) ? 1 : threads;
+}
+
+void MineBoardGenerator::SetMaxCandidates(long long max_candidates)
+{
+    this->max_candidates = max_candidates;
+}
+
+int MineBoardGenerator::Generate(int count, uint64_t seed, std::vector<MineBoardLayout> &boards, std::vector<int> &bbbvs)
+{
+    std::vector<std::thread> workers;
+    std::vector<size_t> order;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    this->candidates = 0;
+    this->aborted = 0;
+    this->rows_placed = 0;
+    this->next_chunk = 0;
+    this->accepted_index.clear();
+    this->accepted.clear();
+    this->accepted_bbbv.clear();
+
+    for (int i = 0; i < this->threads; i++) {
+        workers.push_back(std::thread(&MineBoardGenerator::Worker, this, count, seed));
+    }
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+
+    // candidates are processed in chunks, keep the first count boards by candidate index
+    for (size_t i = 0; i < this->accepted.size(); i++) {
+        order.push_back(i);
+    }
+
+    std::sort(order.begin(), order.end(), [this](size_t a, size_t b) { return this->accepted_index[a] < this->accepted_index[b]; });
+
+    for (size_t i = 0; i < order.size() && (int)i < count; i++) {
+        boards.push_back(this->accepted[order[i]]);
+        bbbvs.push_back(this->accepted_bbbv[order[i]]);
+    }
+
+    std::chrono::duration<double> elapse = std::chrono::steady_clock::now() - start;
+    this->seconds = elapse.count();
+
+    return (int)std::min(order.size(), (size_t)count);
+}
+
+int MineBoardGenerator::CountAccepted()
+{
+    std::unique_lock<std::mutex> guard(this->lock);
+
+    return (int)this->accepted.size();
+}
+
+void MineBoardGenerator::Worker(int count, uint64_t seed)
+{
+    MineBoardSweep sweep;
+    MineBoardLayout layout;
+    MineRandom random;
+    long long candidates = 0, aborted = 0, rows = 0;
+
+    while (this->CountAccepted() < count) {
+        long long first = (this->next_chunk++) * GENERATOR_CHUNK_SIZE;
+
+        if (first >= this->max_candidates) {
+            break;
+        }
+
+        for (long long i = first; i < first + GENERATOR_CHUNK_SIZE && i < this->max_candidates; i++) {
+            // every candidate has its own seed, so the result does not depend on which thread ran it
+            random.Seed(seed ^ ((uint64_t)i * 0x9E3779B97F4A7C15ULL));
+
+            int bbbv = sweep.Run(this->width, this->height, this->mine_count, this->min_bbbv, this->max_bbbv, random, layout);
+
+            candidates += 1;
+            rows += sweep.GetRowsPlaced();
+
+            if (bbbv < 0) {
+                aborted += 1;
+            } else {
+                std::unique_lock<std::mutex> guard(this->lock);
+
+                this->accepted_index.push_back(i);
+                this->accepted.push_back(layout);
+                this->accepted_bbbv.push_back(bbbv);
+            }
+        }
+    }
+
+    std::unique_lock<std::mutex> guard(this->lock);
+
+    this->candidates += candidates;
+    this->aborted += aborted;
+    this->rows_placed += rows;
+}
@@ -0,0 +1,102 @@
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include "layout.h"
+
+#ifndef __MINE_GENERATOR_H__
+#define __MINE_GENERATOR_H__
+
+// places mines row by row and evaluates 3BV while it goes,
+// so a candidate is dropped as soon as its 3BV can no longer land in [min_bbbv, max_bbbv]
+class MineBoardSweep {
+    public:
+        MineBoardSweep();
+        ~MineBoardSweep();
+
+        // returns the 3BV of the candidate, or -1 when it was aborted
+        int Run(int width, int height, int mine_count, int min_bbbv, int max_bbbv, MineRandom &random, MineBoardLayout &layout);
+
+        // rows placed for the last candidate
+        int GetRowsPlaced() const { return this->rows_placed; }
+
+    private:
+        void Resize(int width, int height);
+        void PlaceRow(int y, MineRandom &random, MineBoardLayout &layout);
+        void ProcessRow(int y);
+        void FinalizeRow(int y);
+        int CountActive(int y);
+        int FindRoot(int index);
+
+    private:
+        int width;
+        int height;
+        int stride;
+        int offsets[8];
+
+        // selection sampling state, grids and mines not placed yet
+        int cells_left;
+        int mines_left;
+        int rows_placed;
+
+        // running 3BV parts
+        int islands;
+        int openings;
+        int row_numbers;
+
+        // padded by a ring of zeros: mine flags, 0 grid flags, numbers, union-find parents
+        std::vector<uint8_t> mine;
+        std::vector<uint8_t> zero;
+        std::vector<int8_t> number;
+        std::vector<int> parent;
+        std::vector<int> stamp;
+        int stamp_id;
+};
+
+class MineBoardGenerator {
+    public:
+        MineBoardGenerator();
+        ~MineBoardGenerator();
+
+        void SetTarget(int width, int height, int mine_count, int min_bbbv, int max_bbbv);
+        void SetThreads(int threads);
+        void SetMaxCandidates(long long max_candidates);
+
+        // generates count boards in the target range, the same seed gives the same boards for any thread count
+        // returns the number of boards generated, less than count when max_candidates ran out
+        // bbbvs gets the 3BV the sweep computed for each board
+        int Generate(int count, uint64_t seed, std::vector<MineBoardLayout> &boards, std::vector<int> &bbbvs);
+
+        // report of the last Generate
+        long long GetCandidates() const { return this->candidates; }
+        long long GetAborted() const { return this->aborted; }
+        long long GetRowsPlaced() const { return this->rows_placed; }
+        double GetSeconds() const { return this->seconds; }
+
+    private:
+        void Worker(int count, uint64_t seed);
+        int CountAccepted();
+
+    private:
+        int width;
+        int height;
+        int mine_count;
+        int min_bbbv;
+        int max_bbbv;
+        int threads;
+        long long max_candidates;
+
+        long long candidates;
+        long long aborted;
+        long long rows_placed;
+        double seconds;
+
+        // shared between workers during Generate, candidates are handed out in chunks by index
+        std::atomic<long long> next_chunk;
+        std::mutex lock;
+        std::vector<long long> accepted_index;
+        std::vector<MineBoardLayout> accepted;
+        std::vector<int> accepted_bbbv;
+};
+
+#endif
@@ -0,0 +1,21 @@
+#include <stdint.h>
+
+#ifndef __MINE_IMAGES_H__
+#define __MINE_IMAGES_H__
+
+// an image decoded at build time, width * height SDL_PIXELFORMAT_ARGB8888 pixels row by row
+struct MineImage {
+    const char *path;
+    int width;
+    int height;
+    const uint32_t *pixels;
+};
+
+// images baked into the binary, images.cpp is generated by mine-pack (see pack.cpp and the Makefiles)
+extern const MineImage mine_images[];
+extern const int mine_image_count;
+
+// the image baked from path, the path as given to mine-pack ("./images/png/type0.png"), NULL when there is none
+const MineImage *MineFindImage(const char *path);
+
+#endif
@@ -0,0 +1,199 @@
+#include <cstdio>
+#include <cstdlib>
+#include "layout.h"
+
+MineRandom::MineRandom(uint64_t seed)
+{
+    this->Seed(seed);
+}
+
+void MineRandom::Seed(uint64_t seed)
+{
+    // scramble once, so nearby seeds do not give shifted copies of the same sequence
+    this->state = seed;
+    this->state = this->Next();
+}
+
+uint64_t MineRandom::Next()
+{
+    uint64_t z = (this->state += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+uint32_t MineRandom::NextBelow(uint32_t n)
+{
+    // multiply-shift instead of modulo, no division and no visible bias for board sizes
+    return (uint32_t)(((this->Next() >> 32) * n) >> 32);
+}
+
+// splitmix64 finalizer, spreads every input bit over the whole word
+static uint64_t MixWord(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+MineBoardLayout::MineBoardLayout()
+{
+    this->width = 0;
+    this->height = 0;
+    this->mine_count = 0;
+}
+
+MineBoardLayout::~MineBoardLayout()
+{
+
+}
+
+void MineBoardLayout::Resize(int width, int height)
+{
+    this->width = width;
+    this->height = height;
+    this->bits.assign((width * height + 63) / 64, 0);
+    this->mine_count = 0;
+}
+
+void MineBoardLayout::Clear()
+{
+    for (size_t i = 0; i < this->bits.size(); i++) {
+        this->bits[i] = 0;
+    }
+
+    this->mine_count = 0;
+}
+
+bool MineBoardLayout::IsSame(const MineBoardLayout &other) const
+{
+    return this->width == other.width && this->height == other.height && this->mine_count == other.mine_count && this->bits == other.bits;
+}
+
+bool MineBoardLayout::HasMine(int x, int y) const
+{
+    int z = y * this->width + x;
+
+    return (this->bits[z >> 6] >> (z & 63)) & 1;
+}
+
+void MineBoardLayout::SetMine(int x, int y, bool mine)
+{
+    int z = y * this->width + x;
+    uint64_t mask = (uint64_t)1 << (z & 63);
+
+    if (this->HasMine(x, y) != mine) {
+        this->bits[z >> 6] ^= mask;
+        this->mine_count += mine ? 1 : -1;
+    }
+}
+
+void MineBoardLayout::Generate(int width, int height, int mine_count, MineRandom &random)
+{
+    int size = width * height;
+    bool fill = (mine_count * 2 > size);
+    int todo = fill ? (size - mine_count) : mine_count;
+
+    if (this->width != width || this->height != height) {
+        this->Resize(width, height);
+    }
+
+    // NOTE: on dense boards we start full and pick the free grids instead, so rejection stays cheap
+    for (size_t i = 0; i < this->bits.size(); i++) {
+        this->bits[i] = fill ? ~(uint64_t)0 : 0;
+    }
+
+    if (fill && (size & 63) != 0) {
+        this->bits.back() &= ((uint64_t)1 << (size & 63)) - 1;
+    }
+
+    this->mine_count = fill ? size : 0;
+
+    while (todo > 0) {
+        int z = (int)random.NextBelow((uint32_t)size);
+
+        if (this->HasMine(z % width, z / width) == fill) {
+            this->SetMine(z % width, z / width, !fill);
+            todo--;
+        }
+    }
+}
+
+uint64_t MineBoardLayout::GetHash() const
+{
+    uint64_t h = 0xCBF29CE484222325ULL;
+    uint64_t words[2];
+
+    words[0] = ((uint64_t)this->width << 32) | (uint32_t)this->height;
+    words[1] = (uint64_t)this->mine_count;
+
+    for (int i = 0; i < 2; i++) {
+        h = (h ^ MixWord(words[i])) * 0x100000001B3ULL;
+    }
+
+    // NOTE: the multiply only carries upward, so each word is mixed first or high mine bits never reach the low bits
+    for (size_t i = 0; i < this->bits.size(); i++) {
+        h = (h ^ MixWord(this->bits[i] + i)) * 0x100000001B3ULL;
+    }
+
+    return h;
+}
+
+std::string MineBoardLayout::ToString() const
+{
+    static const char hex[] = "0123456789abcdef";
+    char head[64];
+    int size = this->width * this->height;
+    std::string s;
+
+    std::snprintf(head, sizeof(head), "%d %d %d ", this->width, this->height, this->mine_count);
+    s = head;
+
+    for (int z = 0; z < size; z += 4) {
+        int digit = (int)((this->bits[z >> 6] >> (z & 63)) & 0xF);
+
+        s += hex[digit];
+    }
+
+    return s;
+}
+
+bool MineBoardLayout::FromString(const char *text)
+{
+    int width, height, mine_count, n = 0;
+
+    if (std::sscanf(text, "%d %d %d %n", &width, &height, &mine_count, &n) != 3 || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    this->Resize(width, height);
+
+    const char *p = text + n;
+    int size = width * height;
+
+    for (int z = 0; z < size; z += 4, p++) {
+        int digit;
+
+        if ('0' <= *p && *p <= '9') {
+            digit = *p - '0';
+        } else if ('a' <= *p && *p <= 'f') {
+            digit = *p - 'a' + 10;
+        } else if ('A' <= *p && *p <= 'F') {
+            digit = *p - 'A' + 10;
+        } else {
+            return false;
+        }
+
+        for (int b = 0; b < 4 && z + b < size; b++) {
+            if ((digit >> b) & 1) {
+                this->SetMine((z + b) % width, (z + b) / width, true);
+            }
+        }
+    }
+
+    return this->mine_count == mine_count;
+}
@@ -0,0 +1,56 @@
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#ifndef __MINE_LAYOUT_H__
+#define __MINE_LAYOUT_H__
+
+// small and fast seeded generator (splitmix64), the same seed gives the same boards on every platform
+class MineRandom {
+    public:
+        MineRandom(uint64_t seed = 0);
+
+        void Seed(uint64_t seed);
+        uint64_t Next();
+        // uniform integer in [0, n)
+        uint32_t NextBelow(uint32_t n);
+
+    private:
+        uint64_t state;
+};
+
+// mine layout of a board, one bit per grid in row major order
+class MineBoardLayout {
+    public:
+        MineBoardLayout();
+        ~MineBoardLayout();
+
+        int GetWidth() const { return this->width; }
+        int GetHeight() const { return this->height; }
+        int GetMineCount() const { return this->mine_count; }
+        const std::vector<uint64_t> &GetBits() const { return this->bits; }
+
+        void Resize(int width, int height);
+        void Clear();
+        bool IsSame(const MineBoardLayout &other) const;
+        bool HasMine(int x, int y) const;
+        void SetMine(int x, int y, bool mine);
+
+        // place mine_count mines uniformly at random
+        void Generate(int width, int height, int mine_count, MineRandom &random);
+
+        // 64 bit hash of size and mines, FNV-1a over splitmix64 mixed words, used to dedupe boards
+        uint64_t GetHash() const;
+
+        // text form "<width> <height> <mines> <hex>", hex digit k holds grids 4k to 4k+3 with the lowest bit first
+        std::string ToString() const;
+        bool FromString(const char *text);
+
+    private:
+        int width;
+        int height;
+        int mine_count;
+        std::vector<uint64_t> bits;
+};
+
+#endif
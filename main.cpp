@@ -1,31 +1,187 @@
 #include <iostream>
+#include <string>
+#include <cstdio>
 #include "sdl_headers.h"
 #include "ui.h"
 #include "game.h"
+#include "supply.h"
+#include "share.h"
+#include "script.h"
 
 int main(int argc, char** argv)
 {
+    // startup time is measured from here to the first presented frame
+    Uint64 start_counter = SDL_GetPerformanceCounter();
+    bool headless = false;
+    const char *script_path = NULL;
+    const char *dump_path = NULL;
+    const char *latency_path = NULL;
+    const char *share_name = NULL;
+    unsigned long long seed = 0;
+    bool seeded = false;
+    bool vsync = false, software_grid = false, hud = false, stats = false;
+    int level_w = 0, level_h = 0, level_m = 0;
+
+    // --headless runs without a display: --script <file> plays steps (see script.h), --dump <file.bmp> saves the last frame
+    // --seed <n> makes the boards, and so a headless run, the same every time
+    // --level <w>x<h>x<m> starts on a custom board, up to MINE_GAME_MAX_WIDTH x MINE_GAME_MAX_HEIGHT
+    // --vsync presents in step with the display, --software-grid draws the grid on the CPU (remote X sessions)
+    // --hud starts with the latency overlay (F3), --latency <file> writes the input to present histogram at exit
+    // --stats prints the time and draw calls of every frame
+    // --share <name> publishes the board for other processes, see share.h
+    // a value option given twice keeps the last value
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = (i + 1 < argc);
+
+        if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--script" && has_value) {
+            script_path = argv[++i];
+        } else if (arg == "--dump" && has_value) {
+            dump_path = argv[++i];
+        } else if (arg == "--seed" && has_value) {
+            if (std::sscanf(argv[++i], "%llu", &seed) != 1) {
+                std::cerr << "bad seed " << argv[i] << std::endl;
+                return -1;
+            }
+
+            seeded = true;
+        } else if (arg == "--level" && has_value) {
+            int w, h, m;
+
+            if (std::sscanf(argv[++i], "%dx%dx%d", &w, &h, &m) != 3 || w <= 0 || h <= 0 || m < 0 || m >= w * h) {
+                std::cerr << "unknown level " << argv[i] << std::endl;
+                return -1;
+            }
+
+            level_w = w;
+            level_h = h;
+            level_m = m;
+        } else if (arg == "--vsync") {
+            vsync = true;
+        } else if (arg == "--software-grid") {
+            software_grid = true;
+        } else if (arg == "--hud") {
+            hud = true;
+        } else if (arg == "--stats") {
+            stats = true;
+        } else if (arg == "--latency" && has_value) {
+            latency_path = argv[++i];
+        } else if (arg == "--share" && has_value) {
+            share_name = argv[++i];
+        } else {
+            std::cerr << "unknown argument " << arg << std::endl;
+            std::cerr << "mine [--headless] [--script <file>] [--dump <file.bmp>] [--seed <n>] [--level <w>x<h>x<m>] [--vsync]" << std::endl;
+            std::cerr << "     [--software-grid] [--hud] [--stats] [--latency <file>] [--share <name>]" << std::endl;
+            return -1;
+        }
+    }
+
+    if (headless) {
+        // NOTE: the software renderer reads back the same pixels everywhere, which golden frames need
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "offscreen");
+        SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+    }
+
     // Initialize SDL
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) < 0) {
-        std::cerr << "SDL_Init failed with error: " << SDL_GetError() << std::endl;
-        return -1;
+        // SDL before 2.0.22 has no offscreen driver, the dummy one draws as well
+        if (!headless) {
+            std::cerr << "SDL_Init failed with error: " << SDL_GetError() << std::endl;
+            return -1;
+        }
+
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+
+        if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) < 0) {
+            std::cerr << "SDL_Init failed with error: " << SDL_GetError() << std::endl;
+            return -1;
+        }
     }
 
     MineGameWindowUI *ui;
     MineGame *game;
+    MineBoardSupply *supply = NULL;
+    MineSharedBoard *share = NULL;
+    MineEventScript *script = NULL;
 
     // create game
     game = new MineGame();
+
+    if (seeded) {
+        // boards of the supply come from a clock seed, seeded boards are generated on the first click
+        game->SetSeed(seed);
+    } else {
+        // keep boards of the menu levels ready before the first click
+        supply = new MineBoardSupply();
+        supply->AddLevel(9, 9, 10);
+        supply->AddLevel(16, 16, 40);
+        supply->AddLevel(30, 16, 99);
+        supply->Start(SDL_GetPerformanceCounter());
+
+        game->SetBoardSupply(supply);
+    }
+
     game->SetExpert();
 
+    if (level_w > 0) {
+        game->SetCustom(level_w, level_h, level_m);
+    }
+
     // create UI, interact with game through UI
     ui = new MineGameWindowUI(game);
+    ui->SetStartCounter(start_counter);
+
+    if (headless) {
+        script = new MineEventScript();
+
+        if (script_path != NULL && script->Load(script_path) != 0) {
+            delete script;
+            delete ui;
+            delete game;
+            delete supply;
+            SDL_Quit();
+            return -1;
+        }
+
+        // a move log and a mine map per game would be most of the run
+        game->SetVerbose(false);
+
+        ui->SetHeadless(true);
+        ui->SetScript(script);
+        ui->SetDumpPath((dump_path != NULL) ? dump_path : "");
+    }
+
+    ui->SetVsync(vsync);
+    ui->SetSoftwareGrid(software_grid);
+    ui->SetHud(hud);
+    ui->SetStats(stats);
+    ui->SetLatencyPath((latency_path != NULL) ? latency_path : "");
+
     ui->CreateComponents();
+
+    if (share_name != NULL) {
+        share = new MineSharedBoard();
+
+        // room for the largest board SetCustom allows
+        if (share->Create(share_name, MINE_GAME_MAX_WIDTH, MINE_GAME_MAX_HEIGHT, 256) != 0) {
+            delete share;
+            share = NULL;
+        } else {
+            ui->SetSharedBoard(share);
+        }
+    }
+
     ui->ProcessEvents();
+    ui->SetSharedBoard(NULL);
     ui->DestroyComponents();
 
     delete ui;
     delete game;
+    delete supply;
+    delete share;
+    delete script;
 
     // Quit SDL subsystems
     SDL_Quit();
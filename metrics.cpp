@@ -0,0 +1,483 @@
+#include <algorithm>
+#include "metrics.h"
+
+MineBoardMetrics::MineBoardMetrics()
+{
+    this->bbbv = 0;
+    this->zini = 0;
+    this->openings = 0;
+    this->islands = 0;
+}
+
+MineBoardMetrics::~MineBoardMetrics()
+{
+
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+MineBoardAnalyzer::MineBoardAnalyzer()
+{
+    this->width = 0;
+    this->height = 0;
+    this->stride = 0;
+    this->row_words = 0;
+    this->stamp = 0;
+    this->step = 0;
+
+    for (int k = 0; k < 8; k++) {
+        this->offsets[k] = 0;
+    }
+}
+
+MineBoardAnalyzer::~MineBoardAnalyzer()
+{
+
+}
+
+void MineBoardAnalyzer::Analyze(const MineBoardLayout &layout, MineBoardMetrics &metrics, bool with_zini)
+{
+    if (this->width != layout.GetWidth() || this->height != layout.GetHeight()) {
+        this->Resize(layout.GetWidth(), layout.GetHeight());
+    }
+
+    this->CountNeighbors(layout);
+
+    metrics.islands = this->CountIslands();
+    metrics.openings = this->LabelOpenings();
+    metrics.bbbv = metrics.openings + metrics.islands;
+    metrics.zini = with_zini ? this->GreedyZini(metrics.openings) : 0;
+}
+
+void MineBoardAnalyzer::Resize(int width, int height)
+{
+    int s = width + 2;
+    int padded_size = (width + 2) * (height + 2);
+
+    this->width = width;
+    this->height = height;
+    this->stride = s;
+    this->row_words = (width + 63) / 64;
+
+    int offsets[8] = {-s - 1, -s, -s + 1, -1, 1, s - 1, s, s + 1};
+
+    for (int k = 0; k < 8; k++) {
+        this->offsets[k] = offsets[k];
+    }
+
+    this->number.assign(padded_size, -2);
+    this->zero_rows.assign((height + 2) * this->row_words, 0);
+    this->island_rows.assign((height + 2) * this->row_words, 0);
+    this->label.assign(padded_size, -1);
+    this->opening_next.assign(padded_size, -1);
+    this->island.assign(padded_size, 0);
+    this->opened.assign(padded_size, 0);
+    this->flagged.assign(padded_size, 0);
+    this->premium.assign(padded_size, 0);
+}
+
+void MineBoardAnalyzer::CountNeighbors(const MineBoardLayout &layout)
+{
+    const std::vector<uint64_t> &bits = layout.GetBits();
+    int s = this->stride;
+
+    for (size_t i = 0; i < this->number.size(); i++) {
+        this->number[i] = 0;
+    }
+
+    // every mine adds one to its 8 neighbors, sentinels absorb the writes outside the board
+    for (size_t w = 0; w < bits.size(); w++) {
+        uint64_t b = bits[w];
+
+        while (b != 0) {
+            int z = (int)(w * 64) + __builtin_ctzll(b);
+            int index = (z / this->width + 1) * s + (z % this->width + 1);
+
+            for (int k = 0; k < 8; k++) {
+                this->number[index + this->offsets[k]] += 1;
+            }
+
+            b &= b - 1;
+        }
+    }
+
+    for (size_t w = 0; w < bits.size(); w++) {
+        uint64_t b = bits[w];
+
+        while (b != 0) {
+            int z = (int)(w * 64) + __builtin_ctzll(b);
+
+            this->number[(z / this->width + 1) * s + (z % this->width + 1)] = -1;
+            b &= b - 1;
+        }
+    }
+
+    // restore the sentinel ring
+    for (int x = 0; x < s; x++) {
+        this->number[x] = -2;
+        this->number[(this->height + 1) * s + x] = -2;
+    }
+
+    for (int y = 1; y <= this->height; y++) {
+        this->number[y * s] = -2;
+        this->number[y * s + s - 1] = -2;
+    }
+}
+
+int MineBoardAnalyzer::CountIslands()
+{
+    int words = this->row_words;
+    int islands = 0;
+
+    // zero_rows: 0 grids, island_rows: numbers (islands once filtered); row r of the bitsets is board row r - 1
+    for (size_t i = 0; i < this->zero_rows.size(); i++) {
+        this->zero_rows[i] = 0;
+        this->island_rows[i] = 0;
+    }
+
+    for (int y = 0; y < this->height; y++) {
+        const int8_t *row = &this->number[(y + 1) * this->stride + 1];
+        uint64_t *zero = &this->zero_rows[(y + 1) * words];
+        uint64_t *numbers = &this->island_rows[(y + 1) * words];
+
+        for (int x = 0; x < this->width; x++) {
+            uint64_t bit = (uint64_t)1 << (x & 63);
+
+            if (row[x] == 0) {
+                zero[x >> 6] |= bit;
+            } else if (row[x] > 0) {
+                numbers[x >> 6] |= bit;
+            }
+        }
+    }
+
+    // dilate 0 grids horizontally in place, carrying bits across words
+    for (int r = 1; r <= this->height; r++) {
+        uint64_t *zero = &this->zero_rows[r * words];
+        uint64_t carry_left = 0;
+
+        for (int w = 0; w < words; w++) {
+            uint64_t z = zero[w];
+            uint64_t carry_right = (w + 1 < words) ? (zero[w + 1] << 63) : 0;
+
+            zero[w] = z | (z << 1) | carry_left | (z >> 1) | carry_right;
+            carry_left = z >> 63;
+        }
+    }
+
+    // a number is an island when no grid of the 3x3 block around it is a 0
+    for (int r = 1; r <= this->height; r++) {
+        const uint64_t *up = &this->zero_rows[(r - 1) * words];
+        const uint64_t *mid = &this->zero_rows[r * words];
+        const uint64_t *down = &this->zero_rows[(r + 1) * words];
+        uint64_t *numbers = &this->island_rows[r * words];
+
+        for (int w = 0; w < words; w++) {
+            numbers[w] &= ~(up[w] | mid[w] | down[w]);
+            islands += __builtin_popcountll(numbers[w]);
+        }
+    }
+
+    return islands;
+}
+
+int MineBoardAnalyzer::FindRoot(int index)
+{
+    // path halving
+    while (this->label[index] != index) {
+        this->label[index] = this->label[this->label[index]];
+        index = this->label[index];
+    }
+
+    return index;
+}
+
+int MineBoardAnalyzer::LabelOpenings()
+{
+    int openings = 0;
+
+    // union each 0 grid with the 0 neighbors visited before it (up-left, up, up-right, left)
+    for (int y = 1; y <= this->height; y++) {
+        for (int x = 1; x <= this->width; x++) {
+            int index = y * this->stride + x;
+
+            if (this->number[index] != 0) {
+                this->label[index] = -1;
+                continue;
+            }
+
+            this->label[index] = index;
+
+            for (int k = 0; k < 4; k++) {
+                int n = index + this->offsets[k];
+
+                if (this->number[n] == 0) {
+                    int a = this->FindRoot(n);
+                    int b = this->FindRoot(index);
+
+                    if (a != b) {
+                        this->label[a] = b;
+                    }
+                }
+            }
+        }
+    }
+
+    for (int y = 1; y <= this->height; y++) {
+        for (int x = 1; x <= this->width; x++) {
+            int index = y * this->stride + x;
+
+            if (this->number[index] == 0 && this->FindRoot(index) == index) {
+                openings++;
+            }
+        }
+    }
+
+    return openings;
+}
+
+int MineBoardAnalyzer::GreedyZini(int openings)
+{
+    int words = this->row_words;
+    int count = 0;
+    int clicks = 0;
+
+    // compact labels: opening_next first holds the root of every 0 grid, then the next 0 grid of the same opening
+    for (int y = 1; y <= this->height; y++) {
+        for (int x = 1; x <= this->width; x++) {
+            int index = y * this->stride + x;
+
+            this->opening_next[index] = (this->number[index] == 0) ? this->FindRoot(index) : -1;
+        }
+    }
+
+    this->opening_start.assign(openings, -1);
+
+    for (int y = 1; y <= this->height; y++) {
+        for (int x = 1; x <= this->width; x++) {
+            int index = y * this->stride + x;
+
+            if (this->number[index] == 0 && this->opening_next[index] == index) {
+                this->label[index] = count++;
+            }
+        }
+    }
+
+    for (int y = 1; y <= this->height; y++) {
+        for (int x = 1; x <= this->width; x++) {
+            int index = y * this->stride + x;
+
+            if (this->number[index] == 0) {
+                int l = this->label[this->opening_next[index]];
+
+                this->label[index] = l;
+                this->opening_next[index] = this->opening_start[l];
+                this->opening_start[l] = index;
+            }
+        }
+    }
+
+    // islands from the bitsets, reset the play state
+    for (int y = 1; y <= this->height; y++) {
+        const uint64_t *numbers = &this->island_rows[y * words];
+
+        for (int x = 1; x <= this->width; x++) {
+            int index = y * this->stride + x;
+
+            this->island[index] = (numbers[(x - 1) >> 6] >> ((x - 1) & 63)) & 1;
+            this->opened[index] = 0;
+            this->flagged[index] = 0;
+        }
+    }
+
+    this->opening_done.assign(openings, 0);
+    this->opening_stamp.assign(openings, 0);
+    this->stamp = 0;
+
+    for (int y = 1; y <= this->height; y++) {
+        for (int x = 1; x <= this->width; x++) {
+            int index = y * this->stride + x;
+
+            this->premium[index] = (this->number[index] > 0) ? this->Premium(index) : 0;
+        }
+    }
+
+    // heap of positive premiums, entries go stale when the premium changes and are dropped on pop
+    this->heap.clear();
+    this->refreshed.assign(this->number.size(), 0);
+    this->step = 0;
+
+    for (int y = 1; y <= this->height; y++) {
+        for (int x = 1; x <= this->width; x++) {
+            this->PushPremium(y * this->stride + x);
+        }
+    }
+
+    // greedily chord the number with the best premium (3BV solved minus clicks spent) while it pays off
+    while (!this->heap.empty()) {
+        std::pop_heap(this->heap.begin(), this->heap.end());
+        uint64_t top = this->heap.back();
+        this->heap.pop_back();
+
+        int best = (int)(0xFFFFFFFFu - (uint32_t)top);
+
+        if (this->premium[best] != (int)(top >> 32)) {
+            continue;
+        }
+
+        this->changed.clear();
+        clicks += this->Apply(best);
+        this->step += 1;
+
+        // a premium only depends on the 3x3 block around it, refresh the blocks around changed grids
+        for (size_t i = 0; i < this->changed.size(); i++) {
+            int c = this->changed[i];
+
+            this->UpdatePremium(c);
+
+            for (int k = 0; k < 8; k++) {
+                this->UpdatePremium(c + this->offsets[k]);
+            }
+        }
+    }
+
+    // everything left costs one click per 3BV
+    for (int l = 0; l < openings; l++) {
+        clicks += this->opening_done[l] ? 0 : 1;
+    }
+
+    for (int y = 1; y <= this->height; y++) {
+        for (int x = 1; x <= this->width; x++) {
+            int index = y * this->stride + x;
+
+            clicks += (this->island[index] && !this->opened[index]) ? 1 : 0;
+        }
+    }
+
+    return clicks;
+}
+
+void MineBoardAnalyzer::PushPremium(int index)
+{
+    // ordered by premium, then by the lower index like a row by row scan
+    if (this->premium[index] > 0) {
+        this->heap.push_back(((uint64_t)this->premium[index] << 32) | (0xFFFFFFFFu - (uint32_t)index));
+        std::push_heap(this->heap.begin(), this->heap.end());
+    }
+}
+
+void MineBoardAnalyzer::UpdatePremium(int index)
+{
+    // once per step, openings touch the same numbers many times
+    if (this->number[index] <= 0 || this->refreshed[index] == this->step) {
+        return;
+    }
+
+    this->refreshed[index] = this->step;
+
+    int p = this->Premium(index);
+
+    // an unchanged premium still has its entry
+    if (p != this->premium[index]) {
+        this->premium[index] = p;
+        this->PushPremium(index);
+    }
+}
+
+int MineBoardAnalyzer::Premium(int index)
+{
+    int solved = 0;
+    int cost = 1;
+
+    this->stamp += 1;
+
+    for (int k = 0; k < 8; k++) {
+        int n = index + this->offsets[k];
+        int v = this->number[n];
+
+        if (v == -1) {
+            cost += this->flagged[n] ? 0 : 1;
+        } else if (v >= 0 && !this->opened[n]) {
+            if (v == 0) {
+                int l = this->label[n];
+
+                if (this->opening_stamp[l] != this->stamp) {
+                    this->opening_stamp[l] = this->stamp;
+                    solved += 1;
+                }
+            } else {
+                solved += this->island[n];
+            }
+        }
+    }
+
+    // a closed number has to be opened first, which solves it only if it is an island
+    if (!this->opened[index]) {
+        cost += 1;
+        solved += this->island[index];
+    }
+
+    return solved - cost;
+}
+
+int MineBoardAnalyzer::Apply(int index)
+{
+    int clicks = 0;
+
+    if (!this->opened[index]) {
+        this->OpenGrid(index);
+        clicks += 1;
+    }
+
+    for (int k = 0; k < 8; k++) {
+        int n = index + this->offsets[k];
+
+        if (this->number[n] == -1 && !this->flagged[n]) {
+            this->flagged[n] = 1;
+            this->changed.push_back(n);
+            clicks += 1;
+        }
+    }
+
+    // chord
+    for (int k = 0; k < 8; k++) {
+        int n = index + this->offsets[k];
+
+        if (this->number[n] >= 0 && !this->opened[n]) {
+            this->OpenGrid(n);
+        }
+    }
+
+    return clicks + 1;
+}
+
+void MineBoardAnalyzer::OpenGrid(int index)
+{
+    if (this->number[index] != 0) {
+        this->opened[index] = 1;
+        this->changed.push_back(index);
+        return;
+    }
+
+    int l = this->label[index];
+
+    if (this->opening_done[l]) {
+        return;
+    }
+
+    this->opening_done[l] = 1;
+
+    // open every 0 grid of the opening and the numbers around them
+    for (int z = this->opening_start[l]; z >= 0; z = this->opening_next[z]) {
+        this->opened[z] = 1;
+        this->changed.push_back(z);
+
+        for (int k = 0; k < 8; k++) {
+            int n = z + this->offsets[k];
+
+            if (this->number[n] > 0 && !this->opened[n]) {
+                this->opened[n] = 1;
+                this->changed.push_back(n);
+            }
+        }
+    }
+}
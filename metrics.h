@@ -0,0 +1,83 @@
+#include <vector>
+#include <stdint.h>
+#include "layout.h"
+
+#ifndef __MINE_METRICS_H__
+#define __MINE_METRICS_H__
+
+class MineBoardMetrics {
+    public:
+        // minimum left clicks to clear the board without flags (Bechtel's Board Benchmark Value)
+        int bbbv;
+        // greedy ZiNi, clicks needed when flagging and chording are allowed
+        int zini;
+        // connected areas of 0 grids
+        int openings;
+        // numbers not touching any opening, each needs its own click
+        int islands;
+
+    public:
+        MineBoardMetrics();
+        ~MineBoardMetrics();
+};
+
+// computes metrics from a mine layout, scratch buffers are kept between boards
+// so analyzing many boards of the same size does not allocate
+class MineBoardAnalyzer {
+    public:
+        MineBoardAnalyzer();
+        ~MineBoardAnalyzer();
+
+        void Analyze(const MineBoardLayout &layout, MineBoardMetrics &metrics, bool with_zini = true);
+
+    private:
+        void Resize(int width, int height);
+        void CountNeighbors(const MineBoardLayout &layout);
+        int CountIslands();
+        int LabelOpenings();
+        int FindRoot(int index);
+        int GreedyZini(int openings);
+
+        int Premium(int index);
+        void PushPremium(int index);
+        void UpdatePremium(int index);
+        int Apply(int index);
+        void OpenGrid(int index);
+
+    private:
+        int width;
+        int height;
+        int stride;
+        int row_words;
+        int offsets[8];
+
+        // padded by a sentinel ring: -2 sentinel, -1 mine, 0 to 8 number
+        std::vector<int8_t> number;
+
+        // row aligned bitsets, one extra row above and below
+        std::vector<uint64_t> zero_rows;
+        std::vector<uint64_t> island_rows;
+
+        // openings: parent for union-find, then label of 0 grids
+        // 0 grids of opening l form a list starting at opening_start[l] and linked by opening_next
+        std::vector<int> label;
+        std::vector<int> opening_start;
+        std::vector<int> opening_next;
+
+        // greedy ZiNi state
+        std::vector<uint8_t> island;
+        std::vector<uint8_t> opened;
+        std::vector<uint8_t> flagged;
+        std::vector<uint8_t> opening_done;
+        std::vector<int> opening_stamp;
+        std::vector<int> premium;
+        // premium << 32 | ~index of numbers worth chording
+        std::vector<uint64_t> heap;
+        // step a number was last refreshed in
+        std::vector<int> refreshed;
+        std::vector<int> changed;
+        int stamp;
+        int step;
+};
+
+#endif
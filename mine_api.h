@@ -0,0 +1,122 @@
+#include <stdint.h>
+
+#ifndef __MINE_API_H__
+#define __MINE_API_H__
+
+/*
+ * C interface of the Minesweeper engine, built as a shared library (mine.dll / libmine.so)
+ *
+ * every function takes the handle returned by mine_create, handles are not thread safe,
+ * use one handle per thread or lock around calls
+ */
+
+/* NOTE: no dllimport on Windows, so the same declarations link against mine.dll or api.o directly */
+#if defined(_WIN32)
+#  if defined(MINE_API_BUILD)
+#    define MINE_API __declspec(dllexport)
+#  else
+#    define MINE_API
+#  endif
+#else
+#  define MINE_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* bumped when a function or struct changes incompatibly */
+#define MINE_API_VERSION 1
+
+/* visible grid states, same values as MineGameGrid::State */
+enum {
+    MINE_STATE_0 = 0,           /* open, 0 to 8 mines around */
+    MINE_STATE_8 = 8,
+    MINE_STATE_COVERED = 9,
+    MINE_STATE_FLAGGED = 10,
+    MINE_STATE_FLAGGED_WRONG = 11,
+    MINE_STATE_MINE_EXPLODE = 12,
+    MINE_STATE_MINE_OPEN = 13,
+    MINE_STATE_BORDER = 14      /* sentinel ring around the board */
+};
+
+/* game states, same values as MineGame::State */
+enum {
+    MINE_GAME_READY = 0,
+    MINE_GAME_RUNNING = 1,
+    MINE_GAME_WON = 2,
+    MINE_GAME_LOST = 3
+};
+
+/* moves and their outcomes, same values as MineGameMove::Op and MineGameMove::Outcome */
+enum {
+    MINE_MOVE_OPEN = 0,
+    MINE_MOVE_FLAG = 1,
+    MINE_MOVE_CHORD = 2
+};
+
+enum {
+    MINE_OUTCOME_CHANGED = 0,
+    MINE_OUTCOME_UNCHANGED = 1,
+    MINE_OUTCOME_INVALID = 2,
+    MINE_OUTCOME_LOST = 3,
+    MINE_OUTCOME_WON = 4,
+    MINE_OUTCOME_SKIPPED = 5
+};
+
+typedef struct mine_game mine_game_t;
+
+typedef struct mine_move {
+    int32_t op;
+    int32_t x;
+    int32_t y;
+} mine_move_t;
+
+typedef struct mine_cell {
+    int32_t x;
+    int32_t y;
+    int32_t state;
+} mine_cell_t;
+
+MINE_API int mine_api_version(void);
+
+/* returns NULL when width or height is not positive, mine_count is not in [0, width * height) or out of memory;
+ * the board is ready, mines are placed by the first open */
+MINE_API mine_game_t *mine_create(int width, int height, int mine_count);
+MINE_API void mine_destroy(mine_game_t *game);
+
+MINE_API void mine_seed(mine_game_t *game, uint64_t seed);
+MINE_API void mine_reset(mine_game_t *game);
+/* returns 0, or -1 with the game unchanged for a size mine_create rejects,
+ * or -1 with a 9 x 9 board of 10 mines when out of memory */
+MINE_API int mine_set_size(mine_game_t *game, int width, int height, int mine_count);
+
+/* one move, returns a MINE_OUTCOME_* */
+MINE_API int mine_open(mine_game_t *game, int x, int y);
+MINE_API int mine_flag(mine_game_t *game, int x, int y);
+MINE_API int mine_chord(mine_game_t *game, int x, int y);
+
+/* count moves in order, one MINE_OUTCOME_* each into outcomes, stops at the move that ends the game
+ * returns the number of moves applied */
+MINE_API int mine_apply(mine_game_t *game, const mine_move_t *moves, int count, int32_t *outcomes);
+
+/* grids changed since the last fetch, each once; cells must hold width * height entries
+ * returns the number of cells written, -1 when capacity is too small (nothing is cleared then) */
+MINE_API int mine_fetch_delta(mine_game_t *game, mine_cell_t *cells, int capacity);
+
+/* visible state of every grid, one MINE_STATE_* byte each, read in place without copying
+ * grid (x, y) is at state[y * stride + x]; valid until mine_set_size or mine_destroy, NULL when the board has no buffer */
+MINE_API const uint8_t *mine_state(const mine_game_t *game, int *stride);
+
+MINE_API int mine_width(const mine_game_t *game);
+MINE_API int mine_height(const mine_game_t *game);
+MINE_API int mine_mine_count(const mine_game_t *game);
+MINE_API int mine_flag_count(const mine_game_t *game);
+MINE_API int mine_remaining_count(const mine_game_t *game);
+MINE_API int mine_game_state(const mine_game_t *game);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
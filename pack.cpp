@@ -0,0 +1,223 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include "sdl_headers.h"
+
+// decodes images with SDL_image and writes them as a C++ source file of ARGB8888 pixels (see images.h),
+// so the game creates its textures without opening or decoding a file
+class PackCommand {
+    public:
+        PackCommand();
+        ~PackCommand();
+
+        int ParseArguments(int argc, char **argv);
+        int Run();
+        void ShowHelp();
+
+    private:
+        int WriteImage(FILE *file, int index, const std::string &path, int &width, int &height);
+        static std::string Quote(const std::string &text);
+
+    private:
+        // options
+        std::string output;
+        std::vector<std::string> paths;
+};
+
+////////////////////////////////////////////////////////////////////////////////////
+PackCommand::PackCommand()
+{
+
+}
+
+PackCommand::~PackCommand()
+{
+
+}
+
+int PackCommand::ParseArguments(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--help" || arg == "-h") {
+            return -1;
+        } else if (this->output.empty()) {
+            this->output = arg;
+        } else {
+            this->paths.push_back(arg);
+        }
+    }
+
+    if (this->output.empty() || this->paths.empty()) {
+        std::cerr << "mine-pack: an output file and at least one image are needed" << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+int PackCommand::Run()
+{
+    std::vector<int> widths(this->paths.size()), heights(this->paths.size());
+    std::string temp = this->output + ".tmp";
+    FILE *file;
+    long long pixels = 0;
+
+    file = fopen(temp.c_str(), "w");
+    if (file == NULL) {
+        std::cerr << "mine-pack: cannot write " << temp << std::endl;
+        return 1;
+    }
+
+    fprintf(file, "// generated by mine-pack, do not edit\n");
+    fprintf(file, "#include <cstring>\n");
+    fprintf(file, "#include \"images.h\"\n\n");
+
+    for (size_t i = 0; i < this->paths.size(); i++) {
+        if (this->WriteImage(file, (int)i, this->paths[i], widths[i], heights[i]) != 0) {
+            fclose(file);
+            remove(temp.c_str());
+            return 1;
+        }
+
+        pixels += (long long)widths[i] * heights[i];
+    }
+
+    fprintf(file, "const MineImage mine_images[] = {\n");
+
+    for (size_t i = 0; i < this->paths.size(); i++) {
+        fprintf(file, "    { %s, %d, %d, mine_image_%d },\n", Quote(this->paths[i]).c_str(), widths[i], heights[i], (int)i);
+    }
+
+    fprintf(file, "};\n\n");
+    fprintf(file, "const int mine_image_count = %d;\n\n", (int)this->paths.size());
+
+    fprintf(file, "const MineImage *MineFindImage(const char *path)\n");
+    fprintf(file, "{\n");
+    fprintf(file, "    for (int i = 0; i < mine_image_count; i++) {\n");
+    fprintf(file, "        if (std::strcmp(mine_images[i].path, path) == 0) {\n");
+    fprintf(file, "            return &mine_images[i];\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n\n");
+    fprintf(file, "    return NULL;\n");
+    fprintf(file, "}\n");
+
+    if (fclose(file) != 0) {
+        std::cerr << "mine-pack: cannot write " << temp << std::endl;
+        remove(temp.c_str());
+        return 1;
+    }
+
+    // replace the output only once it is complete, make must not see a half written file
+    remove(this->output.c_str());
+
+    if (rename(temp.c_str(), this->output.c_str()) != 0) {
+        std::cerr << "mine-pack: cannot rename " << temp << " to " << this->output << std::endl;
+        return 1;
+    }
+
+    fflush(stdout);
+    printf("# packed %d images, %lld pixels (%lld KB) into %s\n", (int)this->paths.size(), pixels, pixels * 4 / 1024, this->output.c_str());
+
+    return 0;
+}
+
+int PackCommand::WriteImage(FILE *file, int index, const std::string &path, int &width, int &height)
+{
+    SDL_Surface *loaded;
+    SDL_Surface *surface;
+
+    loaded = IMG_Load(path.c_str());
+    if (loaded == NULL) {
+        std::cerr << "mine-pack: IMG_Load(" << path << ") failed with error: " << SDL_GetError() << std::endl;
+        return -1;
+    }
+
+    // the format the game creates its textures in, a color key becomes alpha here
+    surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(loaded);
+
+    if (surface == NULL) {
+        std::cerr << "mine-pack: SDL_ConvertSurfaceFormat(" << path << ") failed with error: " << SDL_GetError() << std::endl;
+        return -1;
+    }
+
+    width = surface->w;
+    height = surface->h;
+
+    SDL_LockSurface(surface);
+
+    fprintf(file, "// %s, %d x %d\n", path.c_str(), width, height);
+    fprintf(file, "static const uint32_t mine_image_%d[] = {\n", index);
+
+    for (int y = 0; y < height; y++) {
+        // NOTE: rows can be padded, pitch is in bytes
+        const Uint32 *row = (const Uint32*)((const Uint8*)surface->pixels + y * surface->pitch);
+
+        for (int x = 0; x < width; x++) {
+            int column = (y * width + x) % 8;
+
+            fprintf(file, "%s0x%08X,%s", (column == 0) ? "    " : " ", (unsigned int)row[x], (column == 7) ? "\n" : "");
+        }
+    }
+
+    if ((width * height) % 8 != 0) {
+        fprintf(file, "\n");
+    }
+
+    fprintf(file, "};\n\n");
+
+    SDL_UnlockSurface(surface);
+    SDL_FreeSurface(surface);
+
+    return 0;
+}
+
+std::string PackCommand::Quote(const std::string &text)
+{
+    std::string quoted = "\"";
+
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '"' || text[i] == '\\') {
+            quoted += '\\';
+        }
+
+        quoted += text[i];
+    }
+
+    return quoted + "\"";
+}
+
+void PackCommand::ShowHelp()
+{
+    std::cout << "Bakes images into a C++ source file as decoded ARGB8888 pixels" << std::endl;
+    std::cout << std::endl;
+    std::cout << "mine-pack <output.cpp> <image>..." << std::endl;
+    std::cout << std::endl;
+    std::cout << "Images are looked up by MineFindImage (images.h) with the path exactly as given here." << std::endl;
+    std::cout << "Report lines start with #." << std::endl;
+}
+
+//////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+    PackCommand *command;
+    int ret;
+
+    command = new PackCommand();
+
+    if (command->ParseArguments(argc, argv) != 0) {
+        command->ShowHelp();
+        delete command;
+        return 1;
+    }
+
+    ret = command->Run();
+
+    delete command;
+
+    return ret;
+}
@@ -0,0 +1,124 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include "script.h"
+
+MineScriptStep::MineScriptStep()
+{
+    this->op = STEP_RESET;
+    this->x = 0;
+    this->y = 0;
+    this->count = 0;
+    this->modifier = MOD_NONE;
+}
+
+MineScriptStep::~MineScriptStep()
+{
+
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+MineEventScript::MineEventScript()
+{
+    this->position = 0;
+}
+
+MineEventScript::~MineEventScript()
+{
+
+}
+
+int MineEventScript::Load(const std::string &path)
+{
+    std::ifstream file(path.c_str());
+    std::string line;
+    int line_number = 0;
+
+    if (!file) {
+        std::cerr << "MineEventScript::Load(path=" << path << "): cannot open" << std::endl;
+        return -1;
+    }
+
+    this->steps.clear();
+    this->position = 0;
+
+    while (std::getline(file, line)) {
+        line_number += 1;
+
+        // comments and blank lines
+        size_t comment = line.find('#');
+
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+
+        std::istringstream stream(line);
+        std::string name;
+        MineScriptStep step;
+        bool valid = true;
+
+        if (!(stream >> name)) {
+            continue;
+        }
+
+        if (name == "click" || name == "flag" || name == "chord" || name == "move" || name == "wheel") {
+            step.op = (name == "click") ? MineScriptStep::STEP_CLICK :
+                      (name == "flag") ? MineScriptStep::STEP_FLAG :
+                      (name == "chord") ? MineScriptStep::STEP_CHORD :
+                      (name == "move") ? MineScriptStep::STEP_MOVE : MineScriptStep::STEP_WHEEL;
+            valid = (bool)(stream >> step.x >> step.y);
+
+            std::string key;
+
+            if (valid && step.op == MineScriptStep::STEP_WHEEL && (stream >> key)) {
+                step.modifier = (key == "ctrl") ? MineScriptStep::MOD_CTRL : MineScriptStep::MOD_SHIFT;
+                valid = (key == "ctrl" || key == "shift");
+            }
+        } else if (name == "reset") {
+            step.op = MineScriptStep::STEP_RESET;
+        } else if (name == "level") {
+            std::string level;
+            char x1 = 0, x2 = 0;
+
+            step.op = MineScriptStep::STEP_LEVEL;
+            valid = (bool)(stream >> level);
+
+            if (valid) {
+                std::istringstream size(level);
+
+                valid = (bool)(size >> step.x >> x1 >> step.y >> x2 >> step.count) && x1 == 'x' && x2 == 'x' &&
+                        step.x > 0 && step.y > 0 && step.count >= 0 && step.count < step.x * step.y;
+            }
+        } else if (name == "random") {
+            step.op = MineScriptStep::STEP_RANDOM;
+            valid = (bool)(stream >> step.count) && step.count >= 0;
+        } else {
+            valid = false;
+        }
+
+        if (!valid) {
+            std::cerr << "MineEventScript::Load(path=" << path << "): line " << line_number << " does not parse: " << line << std::endl;
+            return -1;
+        }
+
+        this->steps.push_back(step);
+    }
+
+    return 0;
+}
+
+bool MineEventScript::Next(MineScriptStep &step)
+{
+    if (this->position >= this->steps.size()) {
+        return false;
+    }
+
+    step = this->steps[this->position++];
+
+    return true;
+}
+
+int MineEventScript::GetStepCount() const
+{
+    return (int)this->steps.size();
+}
@@ -0,0 +1,67 @@
+#include <string>
+#include <vector>
+
+#ifndef __MINE_SCRIPT_H__
+#define __MINE_SCRIPT_H__
+
+// one line of a script, grids are board coordinates
+class MineScriptStep {
+    public:
+        enum Op {
+            STEP_CLICK = 0,     // left click on grid (x, y)
+            STEP_FLAG = 1,      // right click on grid (x, y)
+            STEP_CHORD = 2,     // left and right buttons together on grid (x, y)
+            STEP_MOVE = 3,      // pointer onto grid (x, y)
+            STEP_WHEEL = 4,     // wheel notches, x sideways and y up
+            STEP_RESET = 5,     // click on the face
+            STEP_LEVEL = 6,     // new board of x * y grids and count mines
+            STEP_RANDOM = 7     // count random clicks, flags and chords, a new game whenever one ends
+        };
+
+        // key held during a wheel step
+        enum Modifier {
+            MOD_NONE = 0,
+            MOD_CTRL = 1,       // zoom around the pointer
+            MOD_SHIFT = 2       // scroll sideways
+        };
+
+    public:
+        MineScriptStep();
+        ~MineScriptStep();
+
+        Op op;
+        int x;
+        int y;
+        int count;
+        Modifier modifier;
+};
+
+// steps the headless UI plays as synthetic SDL events, one step per frame (see MineGameWindowUI::SetScript)
+//
+// a text file, one step per line, # starts a comment:
+//   click <x> <y>
+//   flag <x> <y>
+//   chord <x> <y>
+//   move <x> <y>
+//   wheel <x> <y> [ctrl|shift]   notches at the grid of the last click or move
+//   reset
+//   level <w>x<h>x<m>
+//   random <count>
+class MineEventScript {
+    public:
+        MineEventScript();
+        ~MineEventScript();
+
+        // returns -1 with the line on stderr when a line does not parse
+        int Load(const std::string &path);
+
+        // false once every step was taken
+        bool Next(MineScriptStep &step);
+        int GetStepCount() const;
+
+    private:
+        std::vector<MineScriptStep> steps;
+        size_t position;
+};
+
+#endif
@@ -12,4 +12,10 @@
 #include <SDL_image.h>
 #endif
 
+// NOTE: pkg-config puts the SDL2 directory itself on the include path
+#ifdef __linux__
+#include <SDL.h>
+#include <SDL_image.h>
+#endif
+
 #endif
\ No newline at end of file
@@ -0,0 +1,404 @@
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include "share.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// the segment is read by other processes, the counters have to work across address spaces
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "shared counters need lock free atomics");
+
+MineShareSnapshot::MineShareSnapshot()
+{
+    this->width = 0;
+    this->height = 0;
+    this->mine_count = 0;
+    this->flag_count = 0;
+    this->remaining_count = 0;
+    this->game_state = 0;
+    this->change_count = 0;
+}
+
+MineShareSnapshot::~MineShareSnapshot()
+{
+
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+MineSharedBoard::MineSharedBoard()
+{
+    this->host = false;
+    this->size = 0;
+    this->header = NULL;
+    this->grids = NULL;
+    this->ring = NULL;
+    this->handle = NULL;
+    this->fd = -1;
+    this->published_change = -1;
+    this->published_width = 0;
+    this->published_height = 0;
+    this->published_state = -1;
+}
+
+MineSharedBoard::~MineSharedBoard()
+{
+    this->Close();
+}
+
+int MineSharedBoard::Create(const std::string &name, int max_width, int max_height, int ring_capacity)
+{
+    uint32_t capacity = 1;
+
+    if (max_width <= 0 || max_height <= 0 || ring_capacity <= 0) {
+        std::cerr << "MineSharedBoard::Create(name=" << name << "): invalid size" << std::endl;
+        return -1;
+    }
+
+    while ((int)capacity < ring_capacity) {
+        capacity <<= 1;
+    }
+
+    // header, grids, then the ring on a 64 byte boundary
+    size_t grid_offset = sizeof(MineShareHeader);
+    size_t ring_offset = (grid_offset + (size_t)max_width * max_height + 63) / 64 * 64;
+    size_t size = ring_offset + capacity * sizeof(MineShareCommand);
+
+    this->Close();
+
+    if (this->Map(name, size, true) != 0) {
+        return -1;
+    }
+
+    this->host = true;
+
+    // a fresh mapping is zero filled, so sequence, head and tail start at 0
+    this->header->version = MINE_SHARE_VERSION;
+    this->header->size = (uint32_t)size;
+    this->header->max_width = max_width;
+    this->header->max_height = max_height;
+    this->header->grid_offset = (uint32_t)grid_offset;
+    this->header->ring_offset = (uint32_t)ring_offset;
+    this->header->ring_capacity = capacity;
+
+    this->grids = (unsigned char*)this->header + grid_offset;
+    this->ring = (MineShareCommand*)((unsigned char*)this->header + ring_offset);
+
+    // magic last, a reader attaching in between sees an unfinished segment
+    std::atomic_thread_fence(std::memory_order_release);
+    this->header->magic = MINE_SHARE_MAGIC;
+
+    return 0;
+}
+
+int MineSharedBoard::Publish(const MineGame *game)
+{
+    int width = game->GetWidth();
+    int height = game->GetHeight();
+
+    if (this->header == NULL || !this->host) {
+        return -1;
+    }
+
+    // nothing visible changed
+    if (game->GetChangeCount() == this->published_change && width == this->published_width &&
+        height == this->published_height && game->GetGameState() == this->published_state) {
+        return 0;
+    }
+
+    if (width > (int)this->header->max_width || height > (int)this->header->max_height) {
+        std::cerr << "MineSharedBoard::Publish(width=" << width << ", height=" << height << "): board does not fit" << std::endl;
+        return -1;
+    }
+
+    MineGameView view = game->GetView();
+    uint32_t sequence = this->header->sequence.load(std::memory_order_relaxed);
+
+    // seqlock: odd while writing
+    this->header->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    this->header->width = width;
+    this->header->height = height;
+    this->header->mine_count = game->GetMineCount();
+    this->header->flag_count = game->GetFlagCount();
+    this->header->remaining_count = game->GetRemainingCount();
+    this->header->game_state = game->GetGameState();
+    this->header->change_count += 1;
+
+    for (int y = 0; y < height; y++) {
+        std::memcpy(this->grids + y * width, view.GetRow(y), width);
+    }
+
+    this->header->sequence.store(sequence + 2, std::memory_order_release);
+
+    this->published_change = game->GetChangeCount();
+    this->published_width = width;
+    this->published_height = height;
+    this->published_state = game->GetGameState();
+
+    return 0;
+}
+
+bool MineSharedBoard::TakeCommand(MineShareCommand &command)
+{
+    if (this->header == NULL) {
+        return false;
+    }
+
+    uint32_t tail = this->header->ring_tail.load(std::memory_order_relaxed);
+
+    if (tail == this->header->ring_head.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    command = this->ring[tail & (this->header->ring_capacity - 1)];
+    this->header->ring_tail.store(tail + 1, std::memory_order_release);
+
+    return true;
+}
+
+int MineSharedBoard::Attach(const std::string &name)
+{
+    this->Close();
+
+    // map the header first to learn the size
+    if (this->Map(name, sizeof(MineShareHeader), false) != 0) {
+        return -1;
+    }
+
+    // magic is stored last by Create, so the other fields are only read after it
+    uint32_t magic = this->header->magic;
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if (magic != MINE_SHARE_MAGIC || this->header->version != MINE_SHARE_VERSION) {
+        std::cerr << "MineSharedBoard::Attach(name=" << name << "): not a board segment or another version" << std::endl;
+        this->Close();
+        return -1;
+    }
+
+    size_t size = this->header->size;
+    size_t grid_offset = this->header->grid_offset;
+    size_t ring_offset = this->header->ring_offset;
+    size_t grid_size = (size_t)this->header->max_width * this->header->max_height;
+    size_t capacity = this->header->ring_capacity;
+
+    // the layout Create makes, so a bad header cannot map the segment short
+    if (size < sizeof(MineShareHeader) || grid_offset < sizeof(MineShareHeader) || ring_offset < grid_offset + grid_size ||
+        capacity == 0 || (capacity & (capacity - 1)) != 0 || ring_offset + capacity * sizeof(MineShareCommand) > size) {
+        std::cerr << "MineSharedBoard::Attach(name=" << name << "): inconsistent header" << std::endl;
+        this->Close();
+        return -1;
+    }
+
+    this->Close();
+
+    if (this->Map(name, size, false) != 0) {
+        return -1;
+    }
+
+    this->grids = (unsigned char*)this->header + grid_offset;
+    this->ring = (MineShareCommand*)((unsigned char*)this->header + ring_offset);
+
+    return 0;
+}
+
+void MineSharedBoard::Read(MineShareSnapshot &snapshot, unsigned char *grids)
+{
+    if (this->header == NULL) {
+        return;
+    }
+
+    while (true) {
+        uint32_t before = this->header->sequence.load(std::memory_order_acquire);
+
+        if (before & 1) {
+            continue;
+        }
+
+        snapshot.width = this->header->width;
+        snapshot.height = this->header->height;
+        snapshot.mine_count = this->header->mine_count;
+        snapshot.flag_count = this->header->flag_count;
+        snapshot.remaining_count = this->header->remaining_count;
+        snapshot.game_state = this->header->game_state;
+        snapshot.change_count = this->header->change_count;
+
+        // NOTE: a torn width is possible here, check it so the copy stays inside the segment
+        if (grids != NULL && snapshot.width >= 0 && snapshot.height >= 0 &&
+            snapshot.width <= (int)this->header->max_width && snapshot.height <= (int)this->header->max_height) {
+            std::memcpy(grids, this->grids, (size_t)snapshot.width * snapshot.height);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (this->header->sequence.load(std::memory_order_relaxed) == before) {
+            return;
+        }
+    }
+}
+
+bool MineSharedBoard::Send(const MineShareCommand &command)
+{
+    if (this->header == NULL) {
+        return false;
+    }
+
+    uint32_t head = this->header->ring_head.load(std::memory_order_relaxed);
+
+    if (head - this->header->ring_tail.load(std::memory_order_acquire) == this->header->ring_capacity) {
+        return false;
+    }
+
+    this->ring[head & (this->header->ring_capacity - 1)] = command;
+    this->header->ring_head.store(head + 1, std::memory_order_release);
+
+    return true;
+}
+
+int MineSharedBoard::GetMaxWidth() const
+{
+    return (this->header != NULL) ? (int)this->header->max_width : 0;
+}
+
+int MineSharedBoard::GetMaxHeight() const
+{
+    return (this->header != NULL) ? (int)this->header->max_height : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+
+int MineSharedBoard::Map(const std::string &name, size_t size, bool create)
+{
+    std::string path = "Local\\" + name;
+    HANDLE mapping;
+
+    if (create) {
+        mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD)size, path.c_str());
+    } else {
+        mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, path.c_str());
+    }
+
+    if (mapping == NULL) {
+        std::cerr << "MineSharedBoard: cannot " << (create ? "create " : "open ") << path << ", error " << GetLastError() << std::endl;
+        return -1;
+    }
+
+    void *view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+
+    if (view == NULL) {
+        std::cerr << "MineSharedBoard: cannot map " << path << ", error " << GetLastError() << std::endl;
+        CloseHandle(mapping);
+        return -1;
+    }
+
+    this->name = name;
+    this->size = size;
+    this->handle = mapping;
+    this->header = (MineShareHeader*)view;
+
+    return 0;
+}
+
+void MineSharedBoard::Close()
+{
+    // the mapping goes away with its last handle, there is no name to remove
+    if (this->header != NULL) {
+        UnmapViewOfFile(this->header);
+        CloseHandle((HANDLE)this->handle);
+    }
+
+    this->header = NULL;
+    this->grids = NULL;
+    this->ring = NULL;
+    this->handle = NULL;
+    this->host = false;
+    this->published_change = -1;
+}
+
+#else
+
+int MineSharedBoard::Map(const std::string &name, size_t size, bool create)
+{
+    std::string path = "/" + name;
+    int fd;
+
+    if (create) {
+        // a segment left over by a crashed host is replaced
+        shm_unlink(path.c_str());
+        fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    } else {
+        fd = shm_open(path.c_str(), O_RDWR, 0);
+    }
+
+    if (fd < 0) {
+        std::cerr << "MineSharedBoard: cannot " << (create ? "create " : "open ") << path << ": " << std::strerror(errno) << std::endl;
+        return -1;
+    }
+
+    if (create && ftruncate(fd, (off_t)size) != 0) {
+        std::cerr << "MineSharedBoard: cannot size " << path << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+        shm_unlink(path.c_str());
+        return -1;
+    }
+
+    // NOTE: a segment still being created can be shorter than asked, touching the missing part would fault
+    struct stat st;
+
+    if (!create && (fstat(fd, &st) != 0 || (size_t)st.st_size < size)) {
+        std::cerr << "MineSharedBoard: " << path << " is smaller than " << size << " bytes" << std::endl;
+        close(fd);
+        return -1;
+    }
+
+    void *view = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (view == MAP_FAILED) {
+        std::cerr << "MineSharedBoard: cannot map " << path << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+
+        if (create) {
+            shm_unlink(path.c_str());
+        }
+
+        return -1;
+    }
+
+    this->name = name;
+    this->size = size;
+    this->fd = fd;
+    this->header = (MineShareHeader*)view;
+
+    return 0;
+}
+
+void MineSharedBoard::Close()
+{
+    if (this->header != NULL) {
+        munmap(this->header, this->size);
+        close(this->fd);
+
+        if (this->host) {
+            shm_unlink(("/" + this->name).c_str());
+        }
+    }
+
+    this->header = NULL;
+    this->grids = NULL;
+    this->ring = NULL;
+    this->fd = -1;
+    this->host = false;
+    this->published_change = -1;
+}
+
+#endif
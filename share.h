@@ -0,0 +1,125 @@
+#include <atomic>
+#include <string>
+#include <stdint.h>
+#include "game.h"
+
+#ifndef __MINE_SHARE_H__
+#define __MINE_SHARE_H__
+
+#define MINE_SHARE_MAGIC 0x454E494D
+#define MINE_SHARE_VERSION 1
+
+// one command of the ring, op is a MineGameMove::Op or MINE_SHARE_RESET
+#define MINE_SHARE_RESET 3
+
+struct MineShareCommand {
+    int32_t op;
+    int32_t x;
+    int32_t y;
+};
+
+// start of the segment, every offset is from the start of the segment
+//
+// board: written by the host only, under the seqlock
+//   sequence is odd while the host writes, a reader copies what it needs and retries
+//   when sequence was odd or changed meanwhile, so reading never takes a syscall or a lock
+//   grid (x, y) is the byte at grid_offset + y * width + x, a MineGameGrid::State
+//   change_count counts publications, a reader polls it (or sequence) to see that something changed
+//
+// ring: ring_capacity commands at ring_offset, one client writes, the host reads
+//   ring_head counts commands pushed, ring_tail commands taken, both wrap at 2^32
+struct MineShareHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t max_width;
+    uint32_t max_height;
+    uint32_t grid_offset;
+    uint32_t ring_offset;
+    uint32_t ring_capacity;
+
+    std::atomic<uint32_t> sequence;
+    int32_t width;
+    int32_t height;
+    int32_t mine_count;
+    int32_t flag_count;
+    int32_t remaining_count;
+    int32_t game_state;
+    uint32_t reserved;
+    uint64_t change_count;
+
+    // head and tail on their own cache lines
+    char padding1[64];
+    std::atomic<uint32_t> ring_head;
+    char padding2[60];
+    std::atomic<uint32_t> ring_tail;
+    char padding3[60];
+};
+
+// counters of one consistent read
+class MineShareSnapshot {
+    public:
+        int width;
+        int height;
+        int mine_count;
+        int flag_count;
+        int remaining_count;
+        int game_state;
+        uint64_t change_count;
+
+    public:
+        MineShareSnapshot();
+        ~MineShareSnapshot();
+};
+
+// a named shared memory segment holding the visible board of one game and a command ring
+// (POSIX shm_open on OS X and Linux, a named file mapping on Windows)
+//
+// the host creates it and calls Publish after changes and TakeCommand to drain the ring,
+// readers in other processes Attach by name, Read the board and Send commands
+class MineSharedBoard {
+    public:
+        MineSharedBoard();
+        ~MineSharedBoard();
+
+        // host side, boards up to max_width x max_height, ring_capacity is rounded up to a power of 2
+        int Create(const std::string &name, int max_width, int max_height, int ring_capacity);
+        // copies the visible board when it changed since the last call, -1 when it does not fit
+        int Publish(const MineGame *game);
+        bool TakeCommand(MineShareCommand &command);
+
+        // reader side
+        int Attach(const std::string &name);
+        // grids must hold max_width * max_height bytes, packed by the current width,
+        // NULL reads the counters only, which is enough to wait for a change
+        void Read(MineShareSnapshot &snapshot, unsigned char *grids);
+        // false when the ring is full
+        bool Send(const MineShareCommand &command);
+
+        // unmaps, the host also removes the name
+        void Close();
+
+        int GetMaxWidth() const;
+        int GetMaxHeight() const;
+
+    private:
+        int Map(const std::string &name, size_t size, bool create);
+
+    private:
+        std::string name;
+        bool host;
+        size_t size;
+        MineShareHeader *header;
+        unsigned char *grids;
+        MineShareCommand *ring;
+        void *handle;
+        int fd;
+
+        // host side, to skip publishing an unchanged board
+        long long published_change;
+        int published_width;
+        int published_height;
+        int published_state;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#include <vector>
+#include <atomic>
+#include <stddef.h>
+
+#ifndef __MINE_SPSC_H__
+#define __MINE_SPSC_H__
+
+// bounded lock-free queue for exactly one producer thread and one consumer thread
+// slots are allocated once, so pushing and popping never allocate after the first round trip
+template <class T>
+class MineSpscQueue {
+    public:
+        MineSpscQueue(size_t capacity)
+        {
+            // one slot stays empty to tell full from empty
+            this->slots.resize(capacity + 1);
+            this->head = 0;
+            this->tail = 0;
+        }
+
+        ~MineSpscQueue()
+        {
+
+        }
+
+        // producer side
+        bool TryPush(const T &value)
+        {
+            size_t tail = this->tail.load(std::memory_order_relaxed);
+            size_t next = this->Next(tail);
+
+            if (next == this->head.load(std::memory_order_acquire)) {
+                return false;
+            }
+
+            this->slots[tail] = value;
+            this->tail.store(next, std::memory_order_release);
+
+            return true;
+        }
+
+        // consumer side
+        bool TryPop(T &value)
+        {
+            size_t head = this->head.load(std::memory_order_relaxed);
+
+            if (head == this->tail.load(std::memory_order_acquire)) {
+                return false;
+            }
+
+            value = this->slots[head];
+            this->head.store(this->Next(head), std::memory_order_release);
+
+            return true;
+        }
+
+        // approximate from either side
+        size_t GetSize() const
+        {
+            size_t head = this->head.load(std::memory_order_acquire);
+            size_t tail = this->tail.load(std::memory_order_acquire);
+
+            return (tail >= head) ? (tail - head) : (tail + this->slots.size() - head);
+        }
+
+        size_t GetCapacity() const { return this->slots.size() - 1; }
+
+    private:
+        size_t Next(size_t i) const { return (i + 1 == this->slots.size()) ? 0 : (i + 1); }
+
+    private:
+        std::vector<T> slots;
+
+        // head is written by the consumer only, tail by the producer only, kept on separate cache lines
+        std::atomic<size_t> head;
+        char padding[64];
+        std::atomic<size_t> tail;
+};
+
+#endif
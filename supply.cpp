@@ -0,0 +1,166 @@
+#include <iostream>
+#include <chrono>
+#include "supply.h"
+
+MineBoardSupplyLevel::MineBoardSupplyLevel(int depth)
+{
+    this->width = 0;
+    this->height = 0;
+    this->mine_count = 0;
+    this->min_bbbv = 0;
+    this->max_bbbv = -1;
+    this->queue = new MineSpscQueue<MineBoardLayout>(depth);
+}
+
+MineBoardSupplyLevel::~MineBoardSupplyLevel()
+{
+    delete this->queue;
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+MineBoardSupply::MineBoardSupply()
+{
+    this->seed = 0;
+    this->running = false;
+    this->miss_count = 0;
+}
+
+MineBoardSupply::~MineBoardSupply()
+{
+    this->Stop();
+
+    for (size_t i = 0; i < this->levels.size(); i++) {
+        delete this->levels[i];
+    }
+
+    this->levels.clear();
+}
+
+void MineBoardSupply::AddLevel(int width, int height, int mine_count, int min_bbbv, int max_bbbv, int depth)
+{
+    MineBoardSupplyLevel *level;
+
+    if (this->running) {
+        std::cerr << "MineBoardSupply::AddLevel(): levels can not be added after Start" << std::endl;
+        return;
+    }
+
+    level = new MineBoardSupplyLevel((depth <= 0) ? 1 : depth);
+    level->width = width;
+    level->height = height;
+    level->mine_count = mine_count;
+    level->min_bbbv = min_bbbv;
+    level->max_bbbv = max_bbbv;
+
+    this->levels.push_back(level);
+}
+
+void MineBoardSupply::Start(uint64_t seed)
+{
+    if (this->running) {
+        return;
+    }
+
+    this->seed = seed;
+    this->random.Seed(~seed);
+    this->running = true;
+    this->producer = std::thread(&MineBoardSupply::Producer, this);
+}
+
+void MineBoardSupply::Stop()
+{
+    if (!this->running) {
+        return;
+    }
+
+    this->running = false;
+    this->wake.notify_one();
+    this->producer.join();
+}
+
+bool MineBoardSupply::Take(int width, int height, int mine_count, MineBoardLayout &layout)
+{
+    MineBoardSupplyLevel *level = this->FindLevel(width, height, mine_count);
+
+    if (level == NULL) {
+        return false;
+    }
+
+    if (!level->queue->TryPop(layout)) {
+        this->Generate(level, this->random, this->sweep, layout, false);
+        this->miss_count += 1;
+        return true;
+    }
+
+    // NOTE: notify without the lock, a lost wake up only delays the refill until the producer's timeout
+    this->wake.notify_one();
+
+    return true;
+}
+
+int MineBoardSupply::GetReadyCount(int width, int height, int mine_count)
+{
+    MineBoardSupplyLevel *level = this->FindLevel(width, height, mine_count);
+
+    return (level == NULL) ? 0 : (int)level->queue->GetSize();
+}
+
+void MineBoardSupply::Producer()
+{
+    MineRandom random(this->seed);
+    MineBoardSweep sweep;
+    MineBoardLayout layout;
+
+    while (this->running) {
+        bool pushed = false;
+
+        // one board per level and round, so a slow targeted level does not starve the others
+        for (size_t i = 0; i < this->levels.size() && this->running; i++) {
+            MineBoardSupplyLevel *level = this->levels[i];
+
+            if (level->queue->GetSize() >= level->queue->GetCapacity()) {
+                continue;
+            }
+
+            this->Generate(level, random, sweep, layout, true);
+
+            if (this->running && level->queue->TryPush(layout)) {
+                pushed = true;
+            }
+        }
+
+        if (!pushed) {
+            std::unique_lock<std::mutex> lock(this->wake_lock);
+
+            this->wake.wait_for(lock, std::chrono::milliseconds(50));
+        }
+    }
+}
+
+void MineBoardSupply::Generate(MineBoardSupplyLevel *level, MineRandom &random, MineBoardSweep &sweep, MineBoardLayout &layout, bool producer)
+{
+    if (level->max_bbbv < 0) {
+        layout.Generate(level->width, level->height, level->mine_count, random);
+        return;
+    }
+
+    // the producer gives up when stopped, so a rare range does not hold up Stop
+    while (sweep.Run(level->width, level->height, level->mine_count, level->min_bbbv, level->max_bbbv, random, layout) < 0) {
+        if (producer && !this->running) {
+            return;
+        }
+    }
+}
+
+MineBoardSupplyLevel *MineBoardSupply::FindLevel(int width, int height, int mine_count)
+{
+    for (size_t i = 0; i < this->levels.size(); i++) {
+        MineBoardSupplyLevel *level = this->levels[i];
+
+        if (level->width == width && level->height == height && level->mine_count == mine_count) {
+            return level;
+        }
+    }
+
+    return NULL;
+}
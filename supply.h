@@ -0,0 +1,70 @@
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+#include "layout.h"
+#include "spsc.h"
+#include "generator.h"
+
+#ifndef __MINE_SUPPLY_H__
+#define __MINE_SUPPLY_H__
+
+class MineBoardSupplyLevel {
+    public:
+        int width;
+        int height;
+        int mine_count;
+        // 3BV range, max_bbbv < 0 means any board
+        int min_bbbv;
+        int max_bbbv;
+        MineSpscQueue<MineBoardLayout> *queue;
+
+    public:
+        MineBoardSupplyLevel(int depth);
+        ~MineBoardSupplyLevel();
+};
+
+// keeps a few ready layouts per difficulty, generated by a producer thread,
+// so the first click does not pay for generation
+class MineBoardSupply {
+    public:
+        MineBoardSupply();
+        ~MineBoardSupply();
+
+        // levels are fixed before Start, boards of other sizes are generated by the game itself
+        void AddLevel(int width, int height, int mine_count, int min_bbbv = 0, int max_bbbv = -1, int depth = 4);
+
+        void Start(uint64_t seed);
+        void Stop();
+
+        // called from the game thread only, returns false when this size is not one of the levels
+        // NOTE: when the queue ran dry the board is generated right here, on the caller's thread
+        bool Take(int width, int height, int mine_count, MineBoardLayout &layout);
+        int GetReadyCount(int width, int height, int mine_count);
+        long long GetMissCount() const { return this->miss_count; }
+
+    private:
+        void Producer();
+        void Generate(MineBoardSupplyLevel *level, MineRandom &random, MineBoardSweep &sweep, MineBoardLayout &layout, bool producer);
+        MineBoardSupplyLevel *FindLevel(int width, int height, int mine_count);
+
+    private:
+        std::vector<MineBoardSupplyLevel*> levels;
+        uint64_t seed;
+
+        std::thread producer;
+        std::atomic<bool> running;
+
+        // the producer sleeps here once every queue is full, Take wakes it up
+        std::mutex wake_lock;
+        std::condition_variable wake;
+
+        // used by Take on the game thread when a queue is empty
+        MineRandom random;
+        MineBoardSweep sweep;
+        long long miss_count;
+};
+
+#endif
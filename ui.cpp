@@ -1,8 +1,15 @@
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
 #include "ui.h"
 #include "game.h"
+#include "images.h"
 
 #define WINDOWS_EDGE_MARGIN 10
+// room left on the screen for the title bar, the menu bar and the borders
+#define WINDOWS_DECORATION_SIZE 80
 
 #define COUNTER_EDGE_MARGIN 2
 #define COUNTER_DIGIT_MARGIN 1
@@ -14,15 +21,84 @@
 
 #define MINE_GRID_EDGE_MARGIN 2
 #define MINE_GRID_MINE_SIZE 24
+// grids moved by one wheel notch or arrow key
+#define MINE_GRID_SCROLL_GRIDS 3
+// the window background as an ARGB8888 pixel
+#define MINE_GRID_BACKGROUND_PIXEL 0xFFC0C0C0
+
+// grid atlas: the 14 grid images in a 4 x 4 texture, either the images/png ones at their size (scaled when drawn)
+// or images/svg rasterized at the cell size of a zoom step (drawn 1:1)
+// NOTE: tiles sit edge to edge, fine with the default nearest scaling
+#define MINE_GRID_ATLAS_TILE_SIZE 89
+#define MINE_GRID_ATLAS_COLUMNS 4
+#define MINE_GRID_ATLAS_ROWS 4
+#define MINE_GRID_ATLAS_TILE_COUNT 14
+// key of the images/png atlas among the rasterized ones
+#define MINE_GRID_ATLAS_PNG 0
+// rasterized atlases are cached on disk as <pref path>grid-atlas-v<version>-<size>.bmp, bump it when images/svg changes
+#define MINE_GRID_ATLAS_CACHE_VERSION 1
+
+// how often the command ring of a shared board is checked
+#define MINE_SHARE_POLL_INTERVAL 10
+
+// events taken from the queue at once, and the frame rate when the display does not report one
+#define MINE_EVENT_BATCH_SIZE 256
+#define MINE_DEFAULT_REFRESH_RATE 60
+
+// more damaged rects than this are merged into their bounding box
+#define MINE_DAMAGE_RECT_LIMIT 16
+
+// seed of the random step of a headless script, fixed so runs compare
+#define MINE_SCRIPT_RANDOM_SEED 1
+
+// overlay text: 3 x 5 glyphs drawn as rects, each pixel MINE_HUD_SCALE wide
+#define MINE_HUD_SCALE 2
+#define MINE_HUD_MARGIN 4
+#define MINE_HUD_ADVANCE (4 * MINE_HUD_SCALE)
+#define MINE_HUD_LINE_HEIGHT (7 * MINE_HUD_SCALE)
+#define MINE_HUD_COLUMNS 12
+#define MINE_HUD_LINES 4
+
+// the characters the overlay prints, rows top down, # is a lit pixel
+static const struct {
+    char c;
+    const char *rows;
+} mine_hud_font[] = {
+    { '0', "###" "#.#" "#.#" "#.#" "###" },
+    { '1', ".#." "##." ".#." ".#." "###" },
+    { '2', "###" "..#" "###" "#.." "###" },
+    { '3', "###" "..#" "###" "..#" "###" },
+    { '4', "#.#" "#.#" "###" "..#" "..#" },
+    { '5', "###" "#.." "###" "..#" "###" },
+    { '6', "###" "#.." "###" "#.#" "###" },
+    { '7', "###" "..#" "..#" "..#" "..#" },
+    { '8', "###" "#.#" "###" "#.#" "###" },
+    { '9', "###" "#.#" "###" "..#" "###" },
+    { 'a', "..." ".##" "#.#" "#.#" ".##" },
+    { 'c', "..." ".##" "#.." "#.." ".##" },
+    { 'e', "..." "###" "###" "#.." "###" },
+    { 'f', ".##" "#.." "##." "#.." "#.." },
+    { 'l', "##." ".#." ".#." ".#." "###" },
+    { 'm', "..." "###" "###" "#.#" "#.#" },
+    { 'p', "..." "##." "#.#" "##." "#.." },
+    { 'r', "..." "#.#" "##." "#.." "#.." },
+    { 's', "..." ".##" "##." "..#" "##." },
+    { 'u', "..." "#.#" "#.#" "#.#" "###" },
+};
 
 ////////////////////////////////////////////////////////////////////////////////////
-MineGameTimer::MineGameTimer()
+MineGameTimer::MineGameTimer(MineTimerWheel *wheel)
 {
-    this->event_id = (Uint32)-1;
-    this->timer_id = 0;
+    this->wheel = wheel;
     this->interval = 0;
     this->tick_count = 0;
     this->start_tick = 0;
+
+    this->prev = NULL;
+    this->next = NULL;
+    this->slot = -1;
+    this->rounds = 0;
+    this->due = 0;
 }
 
 MineGameTimer::~MineGameTimer()
@@ -33,33 +109,17 @@ MineGameTimer::~MineGameTimer()
 
 int MineGameTimer::Add(Uint32 millisecond)
 {
-    if (this->event_id == (Uint32(-1))) {
-        Uint32 eid;
-
-        eid = SDL_RegisterEvents(1);
-        if (eid == (Uint32)(-1)) {
-            std::cerr << "SDL_RegisterEvents failed with error: " << SDL_GetError() << std::endl;
-            return -1;
-        }
-
-        std::cout << "Register event id = " << eid << std::endl;
-        this->event_id = eid;
-    }
-
     if (this->interval == 0) {
-        SDL_TimerID tid;
-
-        tid = SDL_AddTimer(millisecond, MineGameTimer::TimerCallback, this);
-        if (tid == 0) {
-            std::cerr << "SDL_AddTimer failed with error: " << SDL_GetError() << std::endl;
+        if (millisecond == 0) {
+            std::cerr << "MineGameTimer::Add: interval must not be 0" << std::endl;
             return -1;
         }
 
-        std::cout << "Add timer with id = " << tid << ", interval = " << millisecond << "ms" << std::endl;
-        this->timer_id = tid;
+        std::cout << "Add timer with interval = " << millisecond << "ms" << std::endl;
         this->interval = millisecond;
         this->tick_count = 0;
         this->start_tick = SDL_GetTicks64();
+        this->wheel->Schedule(this, millisecond);
     }
 
     return 0;
@@ -68,22 +128,16 @@ int MineGameTimer::Add(Uint32 millisecond)
 void MineGameTimer::Remove()
 {
     if (this->interval != 0) {
-        SDL_RemoveTimer(this->timer_id);
-        this->timer_id = 0;
+        this->wheel->Unlink(this);
         this->interval = 0;
         this->tick_count = 0;
         this->start_tick = 0;
     }
 }
 
-SDL_TimerID MineGameTimer::GetId() const
+bool MineGameTimer::IsActive() const
 {
-    return this->timer_id;
-}
-
-Uint32 MineGameTimer::GetEventId() const
-{
-    return this->event_id;
+    return this->interval != 0;
 }
 
 Uint32 MineGameTimer::GetInterval() const
@@ -101,323 +155,1889 @@ Uint64 MineGameTimer::GetStartTick() const
     return this->start_tick;
 }
 
-Uint32 MineGameTimer::TimerCallback(Uint32 interval, void *param)
+////////////////////////////////////////////////////////////////////////////////////
+MineTimerWheel::MineTimerWheel()
 {
-    SDL_Event event;
-    MineGameTimer *timer;
-
-    timer = (MineGameTimer*)param;
-    timer->tick_count += 1;
+    for (int i = 0; i <= MINE_TIMER_WHEEL_SLOTS; i++) {
+        this->slots[i] = NULL;
+    }
 
-    SDL_memset(&event, 0, sizeof(event)); /* or SDL_zero(event) */
-    event.type = timer->GetEventId();
-    event.user.code = 0;
-    event.user.data1 = timer;
-    event.user.data2 = 0;
+    this->current = SDL_GetTicks64();
+    this->active_count = 0;
+}
 
-    SDL_PushEvent(&event);
+MineTimerWheel::~MineTimerWheel()
+{
+    // timers still linked are left alone, they only point back at the wheel
+    for (int i = 0; i <= MINE_TIMER_WHEEL_SLOTS; i++) {
+        while (this->slots[i] != NULL) {
+            MineGameTimer *timer = this->slots[i];
 
-    return timer->GetInterval();
+            this->Unlink(timer);
+            timer->wheel = NULL;
+            timer->interval = 0;
+        }
+    }
 }
 
-
-////////////////////////////////////////////////////////////////////////////////////
-MineGameWindowUI::MineGameWindowUI(MineGame *game)
+int MineTimerWheel::GetTimeout(Uint64 now)
 {
-    this->window = NULL;
-    this->renderer = NULL;
-    this->window_texture = NULL;
-    this->window_texture_dirty = true;
+    Uint64 next = 0;
+    bool found = false;
 
-    this->mine_grid = NULL;
-    this->face_button = NULL;
-    this->mine_counter = NULL;
-    this->time_counter = NULL;
-    this->menu_bar = NULL;
+    if (this->active_count == 0) {
+        return -1;
+    }
 
-    this->winning_splash = NULL;
-    this->splash_timer = NULL;
+    if (this->slots[MINE_TIMER_WHEEL_SLOTS] != NULL) {
+        return 0;
+    }
 
-    this->count_down_timer = NULL;
+    // one look at every slot, a handful of timers does not justify keeping them sorted
+    for (int i = 0; i < MINE_TIMER_WHEEL_SLOTS; i++) {
+        for (MineGameTimer *timer = this->slots[i]; timer != NULL; timer = timer->next) {
+            if (!found || timer->due < next) {
+                next = timer->due;
+                found = true;
+            }
+        }
+    }
 
-    this->game = game;
-}
+    if (!found || next <= now) {
+        return 0;
+    }
 
-MineGameWindowUI::~MineGameWindowUI()
-{
-    this->DestroyComponents();
+    return (int)(next - now);
 }
 
-int MineGameWindowUI::CreateComponents()
+MineGameTimer *MineTimerWheel::TakeExpired(Uint64 now)
 {
-    this->CreateSDLWindow();
-
-    this->menu_bar = new MineGameMenuBar(this);
-    this->menu_bar->AttachMenu();
+    this->Advance(now);
 
-    this->time_counter = new CounterUI(this);
-    this->time_counter->LoadResources();
-    this->time_counter->SetCount(0);
+    MineGameTimer *timer = this->slots[MINE_TIMER_WHEEL_SLOTS];
 
-    this->mine_counter = new CounterUI(this);
-    this->mine_counter->LoadResources();
-    this->mine_counter->SetCount(this->game->GetMineCount());
+    if (timer == NULL) {
+        return NULL;
+    }
 
-    this->face_button = new FaceButtonUI(this);
-    this->face_button->LoadResources();
+    // the next tick counts from when this one was due, so a late loop does not make the timer drift
+    Uint64 next_due = timer->due + timer->interval;
 
-    this->mine_grid = new MineGridUI(this);
-    this->mine_grid->LoadResources();
-    this->mine_grid->SetGameSize(this->game->GetWidth(), this->game->GetHeight());
+    timer->tick_count += 1;
 
-    this->winning_splash = new SplashScreen(this);
-    this->winning_splash->LoadResources();
+    if (next_due <= this->current) {
+        // behind by a whole interval, the missed tick is due right away, like queued timer events were
+        this->Unlink(timer);
+        timer->due = next_due;
+        this->Link(timer, MINE_TIMER_WHEEL_SLOTS);
+    } else {
+        this->Schedule(timer, (Uint32)(next_due - this->current));
+    }
 
-    // splash timer
-    this->splash_timer = new MineGameTimer();
+    return timer;
+}
 
-    // timer
-    this->count_down_timer = new MineGameTimer();
+void MineTimerWheel::Schedule(MineGameTimer *timer, Uint32 delay)
+{
+    if (delay == 0) {
+        delay = 1;
+    }
 
-    this->ResizeWindow();
-    // show window 
-    //SDL_ShowWindow(this->window);
+    this->Unlink(timer);
 
-    return 0;
+    // slot (current + delay) comes around (delay - 1) / SLOTS times before it is due
+    timer->due = this->current + delay;
+    timer->rounds = (delay - 1) / MINE_TIMER_WHEEL_SLOTS;
+    this->Link(timer, (int)(timer->due % MINE_TIMER_WHEEL_SLOTS));
 }
 
-void MineGameWindowUI::DestroyComponents()
+void MineTimerWheel::Link(MineGameTimer *timer, int slot)
 {
-    if (this->count_down_timer != NULL) {
-        delete this->count_down_timer;
-        this->count_down_timer = NULL;
-    }
+    timer->slot = slot;
+    timer->prev = NULL;
+    timer->next = this->slots[slot];
 
-    if (this->splash_timer != NULL) {
-        delete this->splash_timer;
-        this->splash_timer = NULL;
+    if (timer->next != NULL) {
+        timer->next->prev = timer;
     }
 
-    if (this->winning_splash != NULL) {
-        delete this->winning_splash;
-        this->winning_splash = NULL;
-    }
+    this->slots[slot] = timer;
+    this->active_count += 1;
+}
 
-    if (this->mine_grid != NULL) {
-        delete this->mine_grid;
-        this->mine_grid = NULL;
+void MineTimerWheel::Unlink(MineGameTimer *timer)
+{
+    if (timer->slot < 0) {
+        return;
     }
 
-    if (this->face_button != NULL) {
-        delete this->face_button;
-        this->face_button = NULL;
+    if (timer->prev != NULL) {
+        timer->prev->next = timer->next;
+    } else {
+        this->slots[timer->slot] = timer->next;
     }
 
-    if (this->mine_counter != NULL) {
-        delete this->mine_counter;
-        this->mine_counter = NULL;
+    if (timer->next != NULL) {
+        timer->next->prev = timer->prev;
     }
 
-    if (this->time_counter != NULL) {
-        delete this->time_counter;
-        this->time_counter = NULL;
+    timer->prev = NULL;
+    timer->next = NULL;
+    timer->slot = -1;
+    this->active_count -= 1;
+}
+
+void MineTimerWheel::Advance(Uint64 now)
+{
+    // nothing to move, skip the idle time at once
+    if (this->active_count == 0) {
+        this->current = now;
+        return;
     }
 
-    if (this->menu_bar != NULL) {
-        delete this->menu_bar;
-        this->menu_bar = NULL;
+    while (this->current < now) {
+        this->current += 1;
+
+        MineGameTimer *timer = this->slots[this->current % MINE_TIMER_WHEEL_SLOTS];
+
+        while (timer != NULL) {
+            MineGameTimer *next = timer->next;
+
+            if (timer->rounds == 0) {
+                this->Unlink(timer);
+                this->Link(timer, MINE_TIMER_WHEEL_SLOTS);
+            } else {
+                timer->rounds -= 1;
+            }
+
+            timer = next;
+        }
     }
+}
 
-    this->DestroySDLWindow();
+////////////////////////////////////////////////////////////////////////////////////
+MineGameCommand::MineGameCommand()
+{
+    this->op = COMMAND_OPEN;
+    this->x = 0;
+    this->y = 0;
+    this->count = 0;
+    this->share = NULL;
 }
 
-int MineGameWindowUI::ProcessEvents()
+MineGameCommand::~MineGameCommand()
 {
-    // SYSWMEVENT is disabled by default
-    SDL_EventState(SDL_SYSWMEVENT, SDL_ENABLE);
 
-    while (true) {
-        SDL_Event e; 
+}
 
-        if (SDL_WaitEvent(&e) <= 0) {
-            std::cerr << "SDL_WaitEvent failed with error: " << SDL_GetError() << std::endl;
-            continue;
-        }
+MineGameDelta::MineGameDelta()
+{
+    this->kind = DELTA_GRID;
+    this->x = 0;
+    this->y = 0;
+    this->state = 0;
+    this->count = 0;
+}
 
-        if (e.type == SDL_QUIT) {
-            std::cout << "got quit event" << std::endl;
-            break;
-        }
+MineGameDelta::~MineGameDelta()
+{
 
-        this->DispatchEvent(&e);
-        this->RefreshWindow();
-    }
+}
 
-    return 0;
+////////////////////////////////////////////////////////////////////////////////////
+MineGameWorker::MineGameWorker(MineGame *game, Uint32 wake_event)
+{
+    this->game = game;
+    this->share = NULL;
+    this->wake_event = wake_event;
+    this->commands = new MineSpscQueue<MineGameCommand>(MINE_WORKER_COMMAND_QUEUE_SIZE);
+    this->deltas = new MineSpscQueue<MineGameDelta>(MINE_WORKER_DELTA_QUEUE_SIZE);
+    this->submit_count = 0;
+    this->running = false;
+    this->wake_pending = false;
 }
 
-int MineGameWindowUI::DispatchEvent(SDL_Event *base_event)
+MineGameWorker::~MineGameWorker()
 {
-    MineGame::State old_state = this->game->GetGameState();
-    int old_flag_count = this->game->GetFlagCount();
+    this->Stop();
 
-    // mouse motion
-    if (base_event->type == SDL_MOUSEMOTION) {
-        SDL_MouseMotionEvent *e = (SDL_MouseMotionEvent*)base_event;
+    delete this->commands;
+    delete this->deltas;
+}
 
-        //this->mine_counter->HandleMouseMotionEvent(e);
-        //this->time_counter->HandleMouseMotionEvent(e);
-        this->face_button->HandleMouseMotionEvent(e);
-        this->mine_grid->HandleMouseMotionEvent(e);
+void MineGameWorker::Start()
+{
+    if (this->running) {
+        return;
     }
-    // mouse click
-    else if (base_event->type == SDL_MOUSEBUTTONUP || base_event->type == SDL_MOUSEBUTTONDOWN) {
-        SDL_MouseButtonEvent *e = (SDL_MouseButtonEvent*)base_event;
 
-        //this->mine_counter->HandleMouseButtonEvent(e);
-        //this->time_counter->HandleMouseButtonEvent(e);
-        this->face_button->HandleMouseButtonEvent(e);
-        this->mine_grid->HandleMouseButtonEvent(e);
-    }
-    // SDL_SYSWMEVENT
-    else if (base_event->type == SDL_SYSWMEVENT) {
-        SDL_SysWMEvent *e = (SDL_SysWMEvent*)base_event;
+    this->running = true;
+    this->logic = std::thread(&MineGameWorker::Run, this);
+}
 
-        this->HandleSysWMEvent(e);
+void MineGameWorker::Stop()
+{
+    if (!this->running) {
+        return;
     }
-    // user defined events
-    else if (SDL_USEREVENT <= base_event->type && base_event->type < SDL_LASTEVENT) {
-        SDL_UserEvent *e = (SDL_UserEvent*)base_event;
 
-        this->HandleTimerEvent(e);
-    } 
+    {
+        std::lock_guard<std::mutex> lock(this->wake_lock);
+        this->running = false;
+    }
 
+    this->wake.notify_one();
+    this->logic.join();
+}
 
-    MineGame::State new_state = this->game->GetGameState();
-    
-    // ready -> running
-    if (old_state == MineGame::State::GAME_READY && new_state == MineGame::State::GAME_RUNNING) {
-        this->count_down_timer->Add(1000);
-    }
-    // running -> won
-    else if (old_state == MineGame::State::GAME_RUNNING && new_state == MineGame::State::GAME_WON) {
-        this->face_button->SetStatus(FaceButtonUI::STATUS_FACE_WIN);
-        this->count_down_timer->Remove();
-        this->ShowWinningSplash();
-    }
-    // running -> lost
-    else if (old_state == MineGame::State::GAME_RUNNING && new_state == MineGame::State::GAME_LOST) {
-        this->face_button->SetStatus(FaceButtonUI::STATUS_FACE_LOSE);
-        this->count_down_timer->Remove();
+void MineGameWorker::Submit(const MineGameCommand &command)
+{
+    // NOTE: only a flood of shared board moves fills the queue, the logic thread frees a slot per command
+    while (!this->commands->TryPush(command)) {
+        this->wake.notify_one();
+        std::this_thread::yield();
     }
 
-    // update flag count
-    int new_flag_count = this->game->GetFlagCount();
+    this->submit_count += 1;
 
-    if (old_flag_count != new_flag_count) {
-        this->mine_counter->SetCount(this->game->GetMineCount() - new_flag_count);
-        this->mine_counter->Redraw();
+    // the lock orders the push before the logic thread's check, so the wake up is never lost
+    {
+        std::lock_guard<std::mutex> lock(this->wake_lock);
     }
 
-    return 0;
+    this->wake.notify_one();
 }
 
-int MineGameWindowUI::HandleSysWMEvent(SDL_SysWMEvent *e)
+bool MineGameWorker::TakeDelta(MineGameDelta &delta)
 {
-    SDL_SysWMmsg *msg = e->msg;
+    return this->deltas->TryPop(delta);
+}
 
-    if (msg->msg.win.msg == WM_COMMAND) {
-        UINT id = LOWORD(msg->msg.win.wParam);
+void MineGameWorker::Rearm()
+{
+    this->wake_pending = false;
+}
 
-        std::cout << "check item = " << id << std::endl;
-        this->menu_bar->CheckItem(id);
+long long MineGameWorker::GetSubmitCount() const
+{
+    return this->submit_count;
+}
 
-        if (id == 0) {
-            this->game->SetBeginner();
-        } else if (id == 1) {
-            this->game->SetIntermediate();
-        } else if (id == 2) {
-            this->game->SetExpert();
+void MineGameWorker::Run()
+{
+    MineGameCommand command;
+
+    while (this->running) {
+        if (!this->commands->TryPop(command)) {
+            std::unique_lock<std::mutex> lock(this->wake_lock);
+
+            this->wake.wait(lock, [this]() { return !this->running || this->commands->GetSize() > 0; });
+            continue;
         }
 
-        this->GameReset();
-        this->ResizeWindow();
-    }
+        this->Execute(command);
 
-    return 0;
+        // a shared board reader only needs the latest state, publish once the queue is drained
+        if (this->share != NULL && this->commands->GetSize() == 0) {
+            this->share->Publish(this->game);
+        }
+
+        this->Wake();
+    }
 }
 
-int MineGameWindowUI::HandleTimerEvent(SDL_UserEvent *e)
+void MineGameWorker::Execute(const MineGameCommand &command)
 {
-    if (e->type == this->count_down_timer->GetEventId()) {
-        this->time_counter->IncreaseCount();
-        this->time_counter->Redraw();
-    } else if (e->type == this->splash_timer->GetEventId()) {
-        Uint64 elapse = SDL_GetTicks64() - this->splash_timer->GetStartTick();
+    MineGameDelta delta;
 
-        std::cout << "elapse = " << elapse << std::endl;
-        if (elapse < 3000) {
-            this->winning_splash->Update(elapse);
+    if (command.op == MineGameCommand::COMMAND_OPEN) {
+        bool first_click = (this->game->GetGameState() == MineGame::State::GAME_READY);
+        Uint64 start = SDL_GetPerformanceCounter();
+
+        this->game->Open(command.x, command.y);
+
+        // first click places the mines, report how long the user waited for it
+        if (first_click) {
+            Uint64 elapse = SDL_GetPerformanceCounter() - start;
+
+            std::cout << "MineGameWorker: first click took " << (elapse * 1000000 / SDL_GetPerformanceFrequency()) << "us" << std::endl;
+        }
+    } else if (command.op == MineGameCommand::COMMAND_FLAG) {
+        this->game->TouchFlag(command.x, command.y);
+    } else if (command.op == MineGameCommand::COMMAND_CHORD) {
+        this->game->OpenFast(command.x, command.y);
+    } else if (command.op == MineGameCommand::COMMAND_MOVE) {
+        MineGameMove move;
+
+        move.op = (MineGameMove::Op)command.count;
+        move.x = command.x;
+        move.y = command.y;
+
+        this->game->ApplyMove(move);
+    } else if (command.op == MineGameCommand::COMMAND_RESET || command.op == MineGameCommand::COMMAND_LEVEL) {
+        if (command.op == MineGameCommand::COMMAND_LEVEL) {
+            this->game->SetCustom(command.x, command.y, command.count);
         } else {
-            this->StopWinningSplash();
+            this->game->Reset();
+        }
+
+        // every grid is covered again, one delta says so
+        this->game->ClearDirtyGrids();
+
+        delta.kind = MineGameDelta::DELTA_BOARD;
+        delta.x = this->game->GetWidth();
+        delta.y = this->game->GetHeight();
+        delta.count = this->game->GetMineCount();
+        this->PushDelta(delta);
+    } else if (command.op == MineGameCommand::COMMAND_SHARE) {
+        this->share = command.share;
+
+        if (this->share != NULL) {
+            this->share->Publish(this->game);
         }
     }
 
-    return 0;
+    this->PushDirtyGrids();
+
+    delta.kind = MineGameDelta::DELTA_STATUS;
+    delta.x = 0;
+    delta.y = 0;
+    delta.state = (int)this->game->GetGameState();
+    delta.count = this->game->GetFlagCount();
+    this->PushDelta(delta);
 }
 
-SDL_Texture* MineGameWindowUI::LoadTextureFromFile(const char *path)
+void MineGameWorker::PushDelta(const MineGameDelta &delta)
 {
-    SDL_RWops *rw;
-    SDL_Surface *surface;
-    SDL_Texture *texture;
-
-    std::cout << "Loading " << path << "..." << std::endl;
-
-    rw = SDL_RWFromFile(path, "r");
-    if (rw == NULL) {
-        std::cerr << "SDL_RWFromFile failed with error: " << SDL_GetError() << std::endl;
-        return NULL;
-    }
+    // a cascade bigger than the queue waits for the render thread to drain it, a stop drops the rest
+    while (!this->deltas->TryPush(delta)) {
+        if (!this->running) {
+            return;
+        }
 
-    surface = IMG_Load_RW(rw, 0);
-    if (surface == NULL) {
-        std::cerr << "IMG_Load_RW failed with error: " << SDL_GetError() << std::endl;
-        SDL_RWclose(rw);
-        return NULL;
+        this->Wake();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
     }
+}
 
-    texture = SDL_CreateTextureFromSurface(this->renderer, surface);
-    if (texture == NULL) {
-        std::cerr << "SDL_CreateTextureFromSurface failed with error: " << SDL_GetError() << std::endl;
-        SDL_FreeSurface(surface);
-        SDL_RWclose(rw);
-        return NULL;
-    }
+void MineGameWorker::PushDirtyGrids()
+{
+    MineGameDelta delta;
 
-    SDL_SetTextureAlphaMod(texture, 255);
-    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    this->grids.clear();
+    this->game->GetDirtyGrids(this->grids);
+    this->game->ClearDirtyGrids();
 
-    SDL_FreeSurface(surface);
-    SDL_RWclose(rw);
+    delta.kind = MineGameDelta::DELTA_GRID;
 
-    return texture;
+    for (size_t i = 0; i < this->grids.size(); i++) {
+        delta.x = this->grids[i].x;
+        delta.y = this->grids[i].y;
+        delta.state = (int)this->grids[i].state;
+        this->PushDelta(delta);
+    }
 }
 
-SDL_Texture *MineGameWindowUI::CreateTexture(int width, int height)
+void MineGameWorker::Wake()
 {
-    SDL_Texture *texture;
+    SDL_Event e;
 
-    texture = SDL_CreateTexture(this->renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height);
-    //new_texture = SDL_CreateTexture(new_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, screen_width, screen_height);
-    if (texture == NULL) {
-        std::cerr << "SDL_CreateTexture failed with error: " << SDL_GetError() << std::endl;
-        return NULL;
+    if (this->wake_pending.exchange(true)) {
+        return;
     }
 
+    // SDL_PushEvent is thread safe, the event loop wakes up and drains the deltas
+    SDL_zero(e);
+    e.type = this->wake_event;
+
+    if (SDL_PushEvent(&e) < 0) {
+        std::cerr << "SDL_PushEvent failed with error: " << SDL_GetError() << std::endl;
+        this->wake_pending = false;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+MineLatencyHistogram::MineLatencyHistogram()
+{
+    this->Clear();
+}
+
+MineLatencyHistogram::~MineLatencyHistogram()
+{
+
+}
+
+void MineLatencyHistogram::Add(Uint64 us)
+{
+    this->counts[MineLatencyHistogram::GetBucket(us)] += 1;
+    this->count += 1;
+    this->max = std::max(this->max, us);
+}
+
+void MineLatencyHistogram::Clear()
+{
+    std::fill(this->counts, this->counts + MINE_LATENCY_BUCKETS, 0);
+    this->count = 0;
+    this->max = 0;
+}
+
+long long MineLatencyHistogram::GetCount() const
+{
+    return this->count;
+}
+
+Uint64 MineLatencyHistogram::GetMax() const
+{
+    return this->max;
+}
+
+Uint64 MineLatencyHistogram::GetPercentile(double p) const
+{
+    long long target = (long long)(p * this->count + 0.5), seen = 0;
+
+    if (this->count == 0) {
+        return 0;
+    }
+
+    target = std::max(1LL, std::min(target, this->count));
+
+    for (int i = 0; i < MINE_LATENCY_BUCKETS; i++) {
+        seen += this->counts[i];
+
+        if (seen >= target) {
+            // the bucket bound can be past every sample
+            return std::min(MineLatencyHistogram::GetBucketLow(i + 1) - 1, this->max);
+        }
+    }
+
+    return this->max;
+}
+
+int MineLatencyHistogram::Dump(const char *path) const
+{
+    FILE *file = fopen(path, "w");
+
+    if (file == NULL) {
+        std::cerr << "MineLatencyHistogram::Dump(path=" << path << "): cannot write" << std::endl;
+        return -1;
+    }
+
+    fprintf(file, "# input to present latency, %lld inputs, p50 %lluus p90 %lluus p99 %lluus p99.9 %lluus max %lluus\n", this->count,
+            (unsigned long long)this->GetPercentile(0.5), (unsigned long long)this->GetPercentile(0.9), (unsigned long long)this->GetPercentile(0.99),
+            (unsigned long long)this->GetPercentile(0.999), (unsigned long long)this->max);
+    fprintf(file, "# <low_us> <high_us> <count>\n");
+
+    for (int i = 0; i < MINE_LATENCY_BUCKETS; i++) {
+        if (this->counts[i] > 0) {
+            fprintf(file, "%llu %llu %lld\n", (unsigned long long)MineLatencyHistogram::GetBucketLow(i),
+                    (unsigned long long)(MineLatencyHistogram::GetBucketLow(i + 1) - 1), this->counts[i]);
+        }
+    }
+
+    if (fclose(file) != 0) {
+        std::cerr << "MineLatencyHistogram::Dump(path=" << path << "): cannot write" << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+int MineLatencyHistogram::GetBucket(Uint64 us)
+{
+    int e = 0;
+
+    if (us < MINE_LATENCY_EXACT_BUCKETS) {
+        return (int)us;
+    }
+
+    // e = floor(log2(us)), at least 4 here
+    while ((us >> (e + 1)) != 0) {
+        e++;
+    }
+
+    return MINE_LATENCY_EXACT_BUCKETS + (e - 4) * MINE_LATENCY_SUB_BUCKETS + (int)((us >> (e - 2)) & (MINE_LATENCY_SUB_BUCKETS - 1));
+}
+
+Uint64 MineLatencyHistogram::GetBucketLow(int bucket)
+{
+    if (bucket < MINE_LATENCY_EXACT_BUCKETS) {
+        return (Uint64)bucket;
+    }
+
+    int e = (bucket - MINE_LATENCY_EXACT_BUCKETS) / MINE_LATENCY_SUB_BUCKETS + 4;
+    int sub = (bucket - MINE_LATENCY_EXACT_BUCKETS) % MINE_LATENCY_SUB_BUCKETS;
+
+    // NOTE: the one past the last bucket wraps to 0, so its high bound is the largest Uint64
+    if (e >= 64) {
+        return 0;
+    }
+
+    return ((Uint64)1 << e) + ((Uint64)sub << (e - 2));
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+MineResourceManager::MineResourceManager(MineGameWindowUI *window)
+{
+    this->window = window;
+    this->request_count = 0;
+    this->next_entry = 0;
+    this->decode_start = 0;
+}
+
+MineResourceManager::~MineResourceManager()
+{
+    this->Release();
+}
+
+void MineResourceManager::Request(const char *path)
+{
+    this->request_count += 1;
+
+    if (this->Find(path) >= 0) {
+        return;
+    }
+
+    Entry entry;
+
+    entry.path = path;
+    entry.surface = NULL;
+    entry.texture = NULL;
+
+    this->index[entry.path] = (int)this->entries.size();
+    this->entries.push_back(entry);
+}
+
+void MineResourceManager::StartDecoding()
+{
+    int count = (int)std::thread::hardware_concurrency();
+
+    if (!this->workers.empty()) {
+        return;
+    }
+
+    if (count <= 0) {
+        count = 1;
+    }
+
+    if (count > (int)this->entries.size()) {
+        count = (int)this->entries.size();
+    }
+
+    this->next_entry = 0;
+    this->decode_start = SDL_GetPerformanceCounter();
+
+    // NOTE: entries must not grow until WaitDecoding, workers write into them by index
+    for (int i = 0; i < count; i++) {
+        this->workers.push_back(std::thread(&MineResourceManager::DecodeWorker, this));
+    }
+}
+
+void MineResourceManager::WaitDecoding()
+{
+    if (this->workers.empty()) {
+        return;
+    }
+
+    for (size_t i = 0; i < this->workers.size(); i++) {
+        this->workers[i].join();
+    }
+
+    Uint64 elapse = SDL_GetPerformanceCounter() - this->decode_start;
+    int failed = 0;
+
+    for (size_t i = 0; i < this->entries.size(); i++) {
+        if (this->entries[i].surface == NULL) {
+            std::cerr << "MineResourceManager: cannot load " << this->entries[i].path << ": " << this->entries[i].error << std::endl;
+            failed += 1;
+        }
+    }
+
+    std::cout << "MineResourceManager: decoded " << (this->entries.size() - failed) << " files for " << this->request_count << " requests on "
+              << this->workers.size() << " threads in " << (elapse * 1000000 / SDL_GetPerformanceFrequency()) << "us" << std::endl;
+
+    this->workers.clear();
+}
+
+SDL_Texture *MineResourceManager::GetTexture(const char *path)
+{
+    SDL_Surface *surface = this->GetSurface(path);
+    Entry &entry = this->entries[this->Find(path)];
+
+    if (entry.texture == NULL && surface != NULL) {
+        entry.texture = this->window->CreateTextureFromSurface(surface);
+    }
+
+    return entry.texture;
+}
+
+SDL_Surface *MineResourceManager::GetSurface(const char *path)
+{
+    this->WaitDecoding();
+
+    int i = this->Find(path);
+
+    // not requested, decode it right here
+    if (i < 0) {
+        this->Request(path);
+        i = this->Find(path);
+
+        Entry &entry = this->entries[i];
+
+        entry.surface = MineResourceManager::DecodeFile(path, entry.error);
+        if (entry.surface == NULL) {
+            std::cerr << "MineResourceManager: cannot load " << path << ": " << entry.error << std::endl;
+        }
+    }
+
+    return this->entries[i].surface;
+}
+
+void MineResourceManager::Release()
+{
+    this->WaitDecoding();
+
+    for (size_t i = 0; i < this->entries.size(); i++) {
+        if (this->entries[i].texture != NULL) {
+            SDL_DestroyTexture(this->entries[i].texture);
+        }
+
+        if (this->entries[i].surface != NULL) {
+            SDL_FreeSurface(this->entries[i].surface);
+        }
+    }
+
+    this->entries.clear();
+    this->index.clear();
+    this->request_count = 0;
+}
+
+SDL_Surface *MineResourceManager::DecodeFile(const char *path, std::string &error)
+{
+    SDL_RWops *rw;
+    SDL_Surface *surface;
+    const MineImage *image;
+
+    // images baked in by mine-pack need no file and no decoding, the surface points at the baked pixels
+    image = MineFindImage(path);
+    if (image != NULL) {
+        surface = SDL_CreateRGBSurfaceWithFormatFrom((void*)image->pixels, image->width, image->height, 32, image->width * 4, SDL_PIXELFORMAT_ARGB8888);
+        if (surface == NULL) {
+            error = std::string("SDL_CreateRGBSurfaceWithFormatFrom failed with error: ") + SDL_GetError();
+        }
+
+        return surface;
+    }
+
+    rw = SDL_RWFromFile(path, "r");
+    if (rw == NULL) {
+        error = std::string("SDL_RWFromFile failed with error: ") + SDL_GetError();
+        return NULL;
+    }
+
+    surface = IMG_Load_RW(rw, 0);
+    if (surface == NULL) {
+        error = std::string("IMG_Load_RW failed with error: ") + SDL_GetError();
+    }
+
+    SDL_RWclose(rw);
+
+    return surface;
+}
+
+int MineResourceManager::Find(const char *path)
+{
+    std::map<std::string, int>::const_iterator it = this->index.find(path);
+
+    return (it != this->index.end()) ? it->second : -1;
+}
+
+void MineResourceManager::DecodeWorker()
+{
+    while (true) {
+        int i = this->next_entry.fetch_add(1);
+
+        if (i >= (int)this->entries.size()) {
+            break;
+        }
+
+        // SDL keeps its error message per thread
+        this->entries[i].surface = MineResourceManager::DecodeFile(this->entries[i].path.c_str(), this->entries[i].error);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+MineGameWindowUI::MineGameWindowUI(MineGame *game)
+{
+    this->window = NULL;
+    this->renderer = NULL;
+    this->window_texture = NULL;
+    this->window_width = 0;
+    this->window_height = 0;
+    this->clipping = false;
+    this->retained_backbuffer = false;
+    this->accelerated = true;
+    this->software_grid = false;
+    this->vsync = false;
+    this->draw_call_count = 0;
+    this->damage_serial = 0;
+
+    this->worker = NULL;
+    this->wake_event = (Uint32)-1;
+    this->board_width = 0;
+    this->board_height = 0;
+    this->board_mine_count = 0;
+    this->board_flag_count = 0;
+    this->board_state = MineGame::State::GAME_READY;
+    this->board_commands = 0;
+
+    this->input_counter = 0;
+    this->input_command = 0;
+    this->hud = false;
+    this->stats = false;
+    this->last_frame_time = 0;
+    this->last_frame_grids = 0;
+    this->frame_grid_count = 0;
+
+    this->headless = false;
+    this->script = NULL;
+    this->script_random.Seed(MINE_SCRIPT_RANDOM_SEED);
+    this->random_left = 0;
+    this->script_pointer_x = -1;
+    this->script_pointer_y = -1;
+    this->script_modifier = false;
+
+    this->resources = NULL;
+
+    this->mine_grid = NULL;
+    this->face_button = NULL;
+    this->mine_counter = NULL;
+    this->time_counter = NULL;
+    this->menu_bar = NULL;
+
+    this->winning_splash = NULL;
+    this->timer_wheel = NULL;
+    this->splash_timer = NULL;
+
+    this->count_down_timer = NULL;
+
+    this->share = NULL;
+    this->share_timer = NULL;
+
+    this->start_counter = SDL_GetPerformanceCounter();
+    this->first_frame_presented = false;
+
+    this->game = game;
+}
+
+MineGameWindowUI::~MineGameWindowUI()
+{
+    this->DestroyComponents();
+}
+
+int MineGameWindowUI::CreateComponents()
+{
+    // components first, their images are decoded on worker threads while the window and renderer are created
+    this->time_counter = new CounterUI(this);
+    this->mine_counter = new CounterUI(this);
+    this->face_button = new FaceButtonUI(this);
+    this->mine_grid = new MineGridUI(this);
+    this->winning_splash = new SplashScreen(this);
+
+    this->resources = new MineResourceManager(this);
+    this->time_counter->RequestResources(this->resources);
+    this->mine_counter->RequestResources(this->resources);
+    this->face_button->RequestResources(this->resources);
+    this->mine_grid->RequestResources(this->resources);
+    this->winning_splash->RequestResources(this->resources);
+    this->resources->StartDecoding();
+
+    this->CreateSDLWindow();
+
+    // render targets are slow without a GPU, the grid is drawn on the CPU and streamed there
+    this->mine_grid->SetSoftware(this->software_grid || !this->accelerated);
+
+    // NOTE: no menu bar without a screen, the levels come from the script
+    if (!this->headless) {
+        this->menu_bar = new MineGameMenuBar(this);
+        this->menu_bar->AttachMenu();
+    }
+
+    // textures are created here, on the render thread, once decoding is done
+    this->time_counter->LoadResources();
+    this->time_counter->SetCount(0);
+
+    // the game is still ours here, the board starts as its copy and the logic thread takes it over below
+    this->SetBoard(this->game->GetWidth(), this->game->GetHeight(), this->game->GetMineCount());
+
+    this->mine_counter->LoadResources();
+    this->mine_counter->SetCount(this->board_mine_count);
+
+    this->face_button->LoadResources();
+
+    this->mine_grid->LoadResources();
+    this->SetMaxViewSize();
+    this->mine_grid->SetGameSize(this->board_width, this->board_height);
+
+    this->winning_splash->LoadResources();
+
+    // every timer below runs on the wheel, fired from ProcessEvents
+    this->timer_wheel = new MineTimerWheel();
+
+    // splash timer
+    this->splash_timer = new MineGameTimer(this->timer_wheel);
+
+    // timer
+    this->count_down_timer = new MineGameTimer(this->timer_wheel);
+
+    // shared board
+    this->share_timer = new MineGameTimer(this->timer_wheel);
+
+    // logic thread
+    this->wake_event = SDL_RegisterEvents(1);
+    this->worker = new MineGameWorker(this->game, this->wake_event);
+    this->worker->Start();
+
+    if (this->share != NULL) {
+        this->share_timer->Add(MINE_SHARE_POLL_INTERVAL);
+        this->SubmitCommand(MineGameCommand::COMMAND_SHARE, 0, 0, 0);
+    }
+
+    this->ResizeWindow();
+    // show window 
+    //SDL_ShowWindow(this->window);
+
+    return 0;
+}
+
+void MineGameWindowUI::DestroyComponents()
+{
+    // the game is back on this thread once the logic thread is joined
+    if (this->worker != NULL) {
+        delete this->worker;
+        this->worker = NULL;
+    }
+
+    if (this->share_timer != NULL) {
+        delete this->share_timer;
+        this->share_timer = NULL;
+    }
+
+    if (this->count_down_timer != NULL) {
+        delete this->count_down_timer;
+        this->count_down_timer = NULL;
+    }
+
+    if (this->splash_timer != NULL) {
+        delete this->splash_timer;
+        this->splash_timer = NULL;
+    }
+
+    if (this->timer_wheel != NULL) {
+        delete this->timer_wheel;
+        this->timer_wheel = NULL;
+    }
+
+    if (this->winning_splash != NULL) {
+        delete this->winning_splash;
+        this->winning_splash = NULL;
+    }
+
+    if (this->mine_grid != NULL) {
+        delete this->mine_grid;
+        this->mine_grid = NULL;
+    }
+
+    if (this->face_button != NULL) {
+        delete this->face_button;
+        this->face_button = NULL;
+    }
+
+    if (this->mine_counter != NULL) {
+        delete this->mine_counter;
+        this->mine_counter = NULL;
+    }
+
+    if (this->time_counter != NULL) {
+        delete this->time_counter;
+        this->time_counter = NULL;
+    }
+
+    if (this->menu_bar != NULL) {
+        delete this->menu_bar;
+        this->menu_bar = NULL;
+    }
+
+    // textures go before the renderer
+    if (this->resources != NULL) {
+        delete this->resources;
+        this->resources = NULL;
+    }
+
+    this->DestroySDLWindow();
+}
+
+int MineGameWindowUI::ProcessEvents()
+{
+    SDL_Event events[MINE_EVENT_BATCH_SIZE];
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 frame_interval = frequency / this->GetRefreshRate();
+    Uint64 last_present = 0;
+    Uint64 frame_work = 0;
+    bool quit = false;
+
+    // events and presents of the current second
+    Uint64 stats_start = SDL_GetPerformanceCounter();
+    int event_count = 0, coalesced_count = 0, present_count = 0;
+
+    // the whole run, reported at the end of a headless one
+    Uint64 run_start = stats_start;
+    long long run_event_count = 0;
+
+    // nothing to wait for without a display, every batch is a frame
+    if (this->headless) {
+        frame_interval = 0;
+    }
+
+    // SYSWMEVENT is disabled by default
+    SDL_EventState(SDL_SYSWMEVENT, SDL_ENABLE);
+
+    while (!quit) {
+        int count, timeout = -1;
+
+        // a headless run plays one step of its script per batch, then quits
+        if (this->headless && !this->PlayScriptStep()) {
+            SDL_Event e;
+
+            SDL_zero(e);
+            e.type = SDL_QUIT;
+            SDL_PushEvent(&e);
+        }
+
+        // a pending frame waits for its slot, otherwise sleep until the next event or timer
+        if (!this->damage_rects.empty()) {
+            Uint64 now = SDL_GetPerformanceCounter();
+            Uint64 due = last_present + frame_interval;
+
+            timeout = (now >= due) ? 0 : (int)((due - now) * 1000 / frequency) + 1;
+        }
+
+        int timer_timeout = this->timer_wheel->GetTimeout(SDL_GetTicks64());
+
+        if (timer_timeout >= 0 && (timeout < 0 || timer_timeout < timeout)) {
+            timeout = timer_timeout;
+        }
+
+        // NOTE: a headless step may push no event at all, and no display will wake the wait, so never block
+        if (this->headless) {
+            timeout = 0;
+        }
+
+        if (timeout < 0) {
+            count = SDL_WaitEvent(&events[0]);
+            if (count <= 0) {
+                std::cerr << "SDL_WaitEvent failed with error: " << SDL_GetError() << std::endl;
+                continue;
+            }
+        } else {
+            count = SDL_WaitEventTimeout(&events[0], timeout);
+        }
+
+        // then drain whatever else is queued, the wait above already pumped
+        if (count > 0) {
+            int more = SDL_PeepEvents(&events[1], MINE_EVENT_BATCH_SIZE - 1, SDL_GETEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT);
+
+            if (more > 0) {
+                count += more;
+            }
+        }
+
+        // the dequeue time of the whole batch
+        Uint64 start = SDL_GetPerformanceCounter();
+        int dispatched = MineGameWindowUI::CoalesceEvents(events, count);
+
+        event_count += count;
+        coalesced_count += count - dispatched;
+        run_event_count += count;
+
+        for (int i = 0; i < dispatched; i++) {
+            if (events[i].type == SDL_QUIT) {
+                std::cout << "got quit event" << std::endl;
+                quit = true;
+                break;
+            }
+
+            Uint64 serial = this->damage_serial;
+            long long submitted = this->worker->GetSubmitCount();
+            Uint32 type = events[i].type;
+
+            this->DispatchEvent(&events[i]);
+
+            // an input that changed the window or moved the game waits for the present showing it,
+            // a move is shown once the deltas of its command are applied
+            if (this->input_counter == 0 && (this->damage_serial != serial || this->worker->GetSubmitCount() != submitted) &&
+                (type == SDL_MOUSEBUTTONDOWN || type == SDL_MOUSEBUTTONUP || type == SDL_MOUSEWHEEL || type == SDL_KEYDOWN)) {
+                this->input_counter = start;
+                this->input_command = this->worker->GetSubmitCount();
+            }
+        }
+
+        // due timers, after the input that came before them
+        MineGameTimer *timer;
+        Uint64 ticks = SDL_GetTicks64();
+
+        while (!quit && (timer = this->timer_wheel->TakeExpired(ticks)) != NULL) {
+            this->DispatchTimer(timer);
+            dispatched += 1;
+        }
+
+        // whatever the logic thread finished so far, a long cascade is shown as it goes
+        if (!quit) {
+            this->ApplyGameDeltas();
+        }
+
+        // a command that changed nothing has nothing to present
+        if (this->input_counter != 0 && this->board_commands >= this->input_command && this->damage_rects.empty()) {
+            this->input_counter = 0;
+        }
+
+        Uint64 now = SDL_GetPerformanceCounter();
+
+        frame_work += now - start;
+
+        // at most one present per display frame, whatever the number of events
+        if (!this->damage_rects.empty() && !quit && now - last_present >= frame_interval) {
+            // NOTE: the overlay shows the frame before, it is part of the frame it is drawn in
+            if (this->hud) {
+                this->DrawHud();
+            }
+
+            this->RefreshWindow();
+
+            last_present = SDL_GetPerformanceCounter();
+            present_count += 1;
+
+            if (this->input_counter != 0 && this->board_commands >= this->input_command) {
+                this->latency.Add((last_present - this->input_counter) * 1000000 / frequency);
+                this->input_counter = 0;
+            }
+
+            // frame time: event handling and drawing since the last present, plus the present
+            frame_work += last_present - now;
+            this->last_frame_time = frame_work * 1000000 / frequency;
+            this->last_frame_grids = this->frame_grid_count;
+            this->frame_grid_count = 0;
+
+            if (this->headless) {
+                this->frame_times.push_back(frame_work * 1000000 / frequency);
+                this->frame_draw_calls.push_back(this->draw_call_count);
+            } else if (this->HasStats()) {
+                std::cout << "MineGameWindowUI: frame took " << (frame_work * 1000000 / frequency) << "us, " << this->draw_call_count << " draw calls" << std::endl;
+            }
+
+            frame_work = 0;
+            this->draw_call_count = 0;
+        }
+
+        if (now - stats_start >= frequency) {
+            if (event_count > 0 && this->HasStats()) {
+                std::cout << "MineGameWindowUI: " << event_count << " events/s (" << coalesced_count << " motion coalesced), "
+                          << present_count << " presents/s" << std::endl;
+            }
+
+            stats_start = now;
+            event_count = 0;
+            coalesced_count = 0;
+            present_count = 0;
+        }
+    }
+
+    if (this->headless) {
+        this->ReportRun(SDL_GetPerformanceCounter() - run_start, run_event_count);
+
+        if (!this->dump_path.empty()) {
+            this->DumpFrame(this->dump_path.c_str());
+        }
+    }
+
+    if (!this->latency_path.empty() && this->latency.Dump(this->latency_path.c_str()) == 0) {
+        std::cout << "MineGameWindowUI: " << this->latency.GetCount() << " input latencies written to " << this->latency_path << std::endl;
+    }
+
+    return 0;
+}
+
+int MineGameWindowUI::CoalesceEvents(SDL_Event *events, int count)
+{
+    int n = 0;
+
+    // a run of motion events becomes its last one, with the relative motion of the whole run
+    // so the start point (x - xrel, y - yrel) the components look at stays where the run started
+    for (int i = 0; i < count; i++) {
+        if (n > 0 && events[i].type == SDL_MOUSEMOTION && events[n - 1].type == SDL_MOUSEMOTION &&
+            events[i].motion.windowID == events[n - 1].motion.windowID && events[i].motion.which == events[n - 1].motion.which) {
+            int xrel = events[n - 1].motion.xrel + events[i].motion.xrel;
+            int yrel = events[n - 1].motion.yrel + events[i].motion.yrel;
+
+            events[n - 1] = events[i];
+            events[n - 1].motion.xrel = xrel;
+            events[n - 1].motion.yrel = yrel;
+        } else {
+            events[n] = events[i];
+            n += 1;
+        }
+    }
+
+    return n;
+}
+
+int MineGameWindowUI::GetRefreshRate()
+{
+    SDL_DisplayMode mode;
+    int display = SDL_GetWindowDisplayIndex(this->window);
+
+    if (display < 0 || SDL_GetCurrentDisplayMode(display, &mode) != 0 || mode.refresh_rate <= 0) {
+        return MINE_DEFAULT_REFRESH_RATE;
+    }
+
+    return mode.refresh_rate;
+}
+
+void MineGameWindowUI::SetVsync(bool vsync)
+{
+    this->vsync = vsync;
+}
+
+void MineGameWindowUI::SetSoftwareGrid(bool software)
+{
+    this->software_grid = software;
+}
+
+void MineGameWindowUI::SetHeadless(bool headless)
+{
+    this->headless = headless;
+}
+
+bool MineGameWindowUI::IsHeadless() const
+{
+    return this->headless;
+}
+
+void MineGameWindowUI::SetStats(bool stats)
+{
+    this->stats = stats;
+}
+
+bool MineGameWindowUI::HasStats() const
+{
+    return this->stats && !this->headless;
+}
+
+void MineGameWindowUI::SetScript(MineEventScript *script)
+{
+    this->script = script;
+}
+
+void MineGameWindowUI::SetDumpPath(const std::string &path)
+{
+    this->dump_path = path;
+}
+
+void MineGameWindowUI::SetHud(bool hud)
+{
+    this->hud = hud;
+}
+
+void MineGameWindowUI::SetLatencyPath(const std::string &path)
+{
+    this->latency_path = path;
+}
+
+void MineGameWindowUI::CountDrawnGrids(int count)
+{
+    this->frame_grid_count += count;
+}
+
+void MineGameWindowUI::SetStartCounter(Uint64 counter)
+{
+    this->start_counter = counter;
+}
+
+void MineGameWindowUI::SetSharedBoard(MineSharedBoard *share)
+{
+    this->share = share;
+
+    if (this->share_timer == NULL) {
+        return;
+    }
+
+    if (share != NULL) {
+        this->share_timer->Add(MINE_SHARE_POLL_INTERVAL);
+    } else {
+        this->share_timer->Remove();
+    }
+
+    // the logic thread publishes, it is the only one touching the game
+    this->SubmitCommand(MineGameCommand::COMMAND_SHARE, 0, 0, 0);
+}
+
+int MineGameWindowUI::DispatchEvent(SDL_Event *base_event)
+{
+    // mouse motion
+    if (base_event->type == SDL_MOUSEMOTION) {
+        SDL_MouseMotionEvent *e = (SDL_MouseMotionEvent*)base_event;
+
+        //this->mine_counter->HandleMouseMotionEvent(e);
+        //this->time_counter->HandleMouseMotionEvent(e);
+        this->face_button->HandleMouseMotionEvent(e);
+        this->mine_grid->HandleMouseMotionEvent(e);
+    }
+    // mouse click
+    else if (base_event->type == SDL_MOUSEBUTTONUP || base_event->type == SDL_MOUSEBUTTONDOWN) {
+        SDL_MouseButtonEvent *e = (SDL_MouseButtonEvent*)base_event;
+
+        //this->mine_counter->HandleMouseButtonEvent(e);
+        //this->time_counter->HandleMouseButtonEvent(e);
+        this->face_button->HandleMouseButtonEvent(e);
+        this->mine_grid->HandleMouseButtonEvent(e);
+    }
+    // wheel and keys move the view of the board
+    else if (base_event->type == SDL_MOUSEWHEEL) {
+        SDL_MouseWheelEvent *e = (SDL_MouseWheelEvent*)base_event;
+
+        this->mine_grid->HandleMouseWheelEvent(e);
+    }
+    else if (base_event->type == SDL_KEYDOWN) {
+        SDL_KeyboardEvent *e = (SDL_KeyboardEvent*)base_event;
+
+        if (e->keysym.sym == SDLK_F3) {
+            this->ToggleHud();
+        } else {
+            this->mine_grid->HandleKeyboardEvent(e);
+        }
+    }
+    // the system dropped the window contents
+    else if (base_event->type == SDL_WINDOWEVENT) {
+        SDL_WindowEvent *e = (SDL_WindowEvent*)base_event;
+
+        if (e->event == SDL_WINDOWEVENT_EXPOSED || e->event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+            this->DamageWindow(NULL);
+        }
+    }
+    // SDL_SYSWMEVENT
+    else if (base_event->type == SDL_SYSWMEVENT) {
+        SDL_SysWMEvent *e = (SDL_SysWMEvent*)base_event;
+
+        this->HandleSysWMEvent(e);
+    }
+    // deltas are waiting, they are drained after the batch
+    else if (base_event->type == this->wake_event) {
+        this->worker->Rearm();
+    }
+
+    return 0;
+}
+
+int MineGameWindowUI::DispatchTimer(MineGameTimer *timer)
+{
+    // share commands move the game like a click does, the status comes back with the deltas
+    this->HandleTimer(timer);
+
+    return 0;
+}
+
+void MineGameWindowUI::UpdateGameStatus(MineGame::State old_state, int old_flag_count)
+{
+    MineGame::State new_state = this->board_state;
+    
+    // ready -> running
+    if (old_state == MineGame::State::GAME_READY && new_state == MineGame::State::GAME_RUNNING) {
+        this->count_down_timer->Add(1000);
+    }
+    // running -> won
+    else if (old_state == MineGame::State::GAME_RUNNING && new_state == MineGame::State::GAME_WON) {
+        this->face_button->SetStatus(FaceButtonUI::STATUS_FACE_WIN);
+        this->count_down_timer->Remove();
+        this->ShowWinningSplash();
+    }
+    // running -> lost
+    else if (old_state == MineGame::State::GAME_RUNNING && new_state == MineGame::State::GAME_LOST) {
+        this->face_button->SetStatus(FaceButtonUI::STATUS_FACE_LOSE);
+        this->count_down_timer->Remove();
+    }
+
+    // update flag count
+    int new_flag_count = this->board_flag_count;
+
+    if (old_flag_count != new_flag_count) {
+        this->mine_counter->SetCount(this->board_mine_count - new_flag_count);
+        this->mine_counter->RedrawChanged();
+    }
+}
+
+int MineGameWindowUI::ApplyGameDeltas()
+{
+    MineGameDelta delta;
+    int count = 0;
+
+    while (this->worker->TakeDelta(delta)) {
+        count += 1;
+
+        if (delta.kind == MineGameDelta::DELTA_GRID) {
+            MineGameGrid grid;
+
+            this->board[(delta.y + 1) * (this->board_width + 2) + (delta.x + 1)] = (unsigned char)delta.state;
+
+            grid.x = delta.x;
+            grid.y = delta.y;
+            grid.state = (MineGameGrid::State)delta.state;
+            this->board_dirty.push_back(grid);
+        } else if (delta.kind == MineGameDelta::DELTA_BOARD) {
+            bool resized = (delta.x != this->board_width || delta.y != this->board_height);
+
+            this->SetBoard(delta.x, delta.y, delta.count);
+            this->ResetView();
+
+            if (resized) {
+                this->ResizeWindow();
+            }
+        } else if (delta.kind == MineGameDelta::DELTA_STATUS) {
+            MineGame::State old_state = this->board_state;
+            int old_flag_count = this->board_flag_count;
+
+            // grids of the command first, the status can show the splash over them
+            if (!this->board_dirty.empty()) {
+                this->mine_grid->RedrawDirtyGrids();
+            }
+
+            this->board_state = (MineGame::State)delta.state;
+            this->board_flag_count = delta.count;
+            this->board_commands += 1;
+
+            this->UpdateGameStatus(old_state, old_flag_count);
+        }
+    }
+
+    // part of a cascade still being made
+    if (!this->board_dirty.empty()) {
+        this->mine_grid->RedrawDirtyGrids();
+    }
+
+    return count;
+}
+
+void MineGameWindowUI::SyncGame()
+{
+    while (this->board_commands < this->worker->GetSubmitCount()) {
+        if (this->ApplyGameDeltas() == 0) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void MineGameWindowUI::SetBoard(int width, int height, int mine_count)
+{
+    int stride = width + 2;
+
+    // covered grids inside a sentinel ring, as MineGame keeps them
+    this->board.assign((size_t)stride * (height + 2), (unsigned char)MineGameGrid::STATE_BORDER);
+
+    for (int y = 0; y < height; y++) {
+        std::fill(this->board.begin() + (y + 1) * stride + 1, this->board.begin() + (y + 1) * stride + 1 + width, (unsigned char)MineGameGrid::STATE_COVERED);
+    }
+
+    this->board_width = width;
+    this->board_height = height;
+    this->board_mine_count = mine_count;
+    this->board_flag_count = 0;
+    this->board_state = MineGame::State::GAME_READY;
+    this->board_dirty.clear();
+}
+
+void MineGameWindowUI::SubmitCommand(MineGameCommand::Op op, int x, int y, int count)
+{
+    MineGameCommand command;
+
+    if (this->worker == NULL) {
+        return;
+    }
+
+    command.op = op;
+    command.x = x;
+    command.y = y;
+    command.count = count;
+    command.share = this->share;
+
+    this->worker->Submit(command);
+}
+
+int MineGameWindowUI::HandleSysWMEvent(SDL_SysWMEvent *e)
+{
+#ifdef __MINGW32__
+    SDL_SysWMmsg *msg = e->msg;
+
+    if (msg->msg.win.msg == WM_COMMAND) {
+        UINT id = LOWORD(msg->msg.win.wParam);
+
+        std::cout << "check item = " << id << std::endl;
+        this->menu_bar->CheckItem(id);
+
+        if (id == 0) {
+            this->GameSetLevel(9, 9, 10);
+        } else if (id == 1) {
+            this->GameSetLevel(16, 16, 40);
+        } else if (id == 2) {
+            this->GameSetLevel(30, 16, 99);
+        }
+    }
+#else
+    (void)e;
+#endif
+
+    return 0;
+}
+
+bool MineGameWindowUI::PlayScriptStep()
+{
+    MineScriptStep step;
+    int x, y;
+
+    // every step sees the board its previous steps made, so runs repeat
+    this->SyncGame();
+
+    // the wheel event of the previous step was handled, release its modifier
+    if (this->script_modifier) {
+        SDL_SetModState(KMOD_NONE);
+        this->script_modifier = false;
+    }
+
+    // a random step takes one frame per move
+    if (this->random_left > 0) {
+        this->random_left -= 1;
+        this->PlayRandomMove();
+        return true;
+    }
+
+    if (this->script == NULL || !this->script->Next(step)) {
+        return false;
+    }
+
+    if (step.op == MineScriptStep::STEP_CLICK || step.op == MineScriptStep::STEP_FLAG || step.op == MineScriptStep::STEP_CHORD) {
+        if (!this->mine_grid->GetGridPoint(step.x, step.y, x, y)) {
+            std::cerr << "MineGameWindowUI: script grid (" << step.x << ", " << step.y << ") is not on the board" << std::endl;
+            return true;
+        }
+
+        this->script_pointer_x = x;
+        this->script_pointer_y = y;
+
+        if (step.op == MineScriptStep::STEP_CLICK) {
+            this->PushMouseButton(SDL_MOUSEBUTTONDOWN, SDL_BUTTON_LEFT, x, y);
+            this->PushMouseButton(SDL_MOUSEBUTTONUP, SDL_BUTTON_LEFT, x, y);
+        } else if (step.op == MineScriptStep::STEP_FLAG) {
+            this->PushMouseButton(SDL_MOUSEBUTTONDOWN, SDL_BUTTON_RIGHT, x, y);
+            this->PushMouseButton(SDL_MOUSEBUTTONUP, SDL_BUTTON_RIGHT, x, y);
+        } else {
+            this->PushMouseButton(SDL_MOUSEBUTTONDOWN, SDL_BUTTON_LEFT, x, y);
+            this->PushMouseButton(SDL_MOUSEBUTTONDOWN, SDL_BUTTON_RIGHT, x, y);
+            this->PushMouseButton(SDL_MOUSEBUTTONUP, SDL_BUTTON_LEFT, x, y);
+            this->PushMouseButton(SDL_MOUSEBUTTONUP, SDL_BUTTON_RIGHT, x, y);
+        }
+    } else if (step.op == MineScriptStep::STEP_MOVE) {
+        if (this->mine_grid->GetGridPoint(step.x, step.y, x, y)) {
+            SDL_Event e;
+
+            SDL_zero(e);
+            e.type = SDL_MOUSEMOTION;
+            e.motion.windowID = SDL_GetWindowID(this->window);
+            e.motion.x = x;
+            e.motion.y = y;
+            SDL_PushEvent(&e);
+
+            this->script_pointer_x = x;
+            this->script_pointer_y = y;
+        }
+    } else if (step.op == MineScriptStep::STEP_WHEEL) {
+        SDL_Event e;
+
+        SDL_zero(e);
+        e.type = SDL_MOUSEWHEEL;
+        e.wheel.windowID = SDL_GetWindowID(this->window);
+        e.wheel.x = step.x;
+        e.wheel.y = step.y;
+#if SDL_VERSION_ATLEAST(2, 26, 0)
+        e.wheel.mouseX = this->script_pointer_x;
+        e.wheel.mouseY = this->script_pointer_y;
+#endif
+
+        // NOTE: pushed events carry no modifiers, the key state is set until the next step
+        if (step.modifier != MineScriptStep::MOD_NONE) {
+            SDL_SetModState((step.modifier == MineScriptStep::MOD_CTRL) ? KMOD_CTRL : KMOD_SHIFT);
+            this->script_modifier = true;
+        }
+
+        SDL_PushEvent(&e);
+    } else if (step.op == MineScriptStep::STEP_RESET) {
+        const SDL_Rect *rect = this->face_button->GetRect();
+
+        this->PushMouseButton(SDL_MOUSEBUTTONDOWN, SDL_BUTTON_LEFT, rect->x + rect->w / 2, rect->y + rect->h / 2);
+        this->PushMouseButton(SDL_MOUSEBUTTONUP, SDL_BUTTON_LEFT, rect->x + rect->w / 2, rect->y + rect->h / 2);
+    } else if (step.op == MineScriptStep::STEP_LEVEL) {
+        // what the menu does
+        this->GameSetLevel(step.x, step.y, step.count);
+    } else if (step.op == MineScriptStep::STEP_RANDOM) {
+        this->random_left = step.count;
+    }
+
+    return true;
+}
+
+void MineGameWindowUI::PlayRandomMove()
+{
+    MineGame::State state = this->board_state;
+    int x, y;
+
+    // a finished game is followed by a new one
+    if (state == MineGame::State::GAME_WON || state == MineGame::State::GAME_LOST) {
+        const SDL_Rect *rect = this->face_button->GetRect();
+
+        this->PushMouseButton(SDL_MOUSEBUTTONDOWN, SDL_BUTTON_LEFT, rect->x + rect->w / 2, rect->y + rect->h / 2);
+        this->PushMouseButton(SDL_MOUSEBUTTONUP, SDL_BUTTON_LEFT, rect->x + rect->w / 2, rect->y + rect->h / 2);
+        return;
+    }
+
+    int grid_x = (int)this->script_random.NextBelow((uint32_t)this->board_width);
+    int grid_y = (int)this->script_random.NextBelow((uint32_t)this->board_height);
+    MineGameGrid::State grid = this->GameGetView().GetGridState(grid_x, grid_y);
+
+    if (!this->mine_grid->GetGridPoint(grid_x, grid_y, x, y)) {
+        return;
+    }
+
+    // chord on numbers, otherwise mostly clicks and some flags
+    if (grid >= MineGameGrid::STATE_MINE_1 && grid <= MineGameGrid::STATE_MINE_8) {
+        this->PushMouseButton(SDL_MOUSEBUTTONDOWN, SDL_BUTTON_LEFT, x, y);
+        this->PushMouseButton(SDL_MOUSEBUTTONDOWN, SDL_BUTTON_RIGHT, x, y);
+        this->PushMouseButton(SDL_MOUSEBUTTONUP, SDL_BUTTON_LEFT, x, y);
+        this->PushMouseButton(SDL_MOUSEBUTTONUP, SDL_BUTTON_RIGHT, x, y);
+    } else if (this->script_random.NextBelow(4) == 0) {
+        this->PushMouseButton(SDL_MOUSEBUTTONDOWN, SDL_BUTTON_RIGHT, x, y);
+        this->PushMouseButton(SDL_MOUSEBUTTONUP, SDL_BUTTON_RIGHT, x, y);
+    } else {
+        this->PushMouseButton(SDL_MOUSEBUTTONDOWN, SDL_BUTTON_LEFT, x, y);
+        this->PushMouseButton(SDL_MOUSEBUTTONUP, SDL_BUTTON_LEFT, x, y);
+    }
+}
+
+void MineGameWindowUI::PushMouseButton(Uint32 type, Uint8 button, int x, int y)
+{
+    SDL_Event e;
+
+    SDL_zero(e);
+    e.type = type;
+    e.button.windowID = SDL_GetWindowID(this->window);
+    e.button.button = button;
+    e.button.state = (type == SDL_MOUSEBUTTONDOWN) ? SDL_PRESSED : SDL_RELEASED;
+    e.button.clicks = 1;
+    e.button.x = x;
+    e.button.y = y;
+
+    if (SDL_PushEvent(&e) < 0) {
+        std::cerr << "SDL_PushEvent failed with error: " << SDL_GetError() << std::endl;
+    }
+}
+
+void MineGameWindowUI::ReportRun(Uint64 elapse, long long event_count)
+{
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    double seconds = (double)elapse / frequency;
+    std::vector<Uint64> times = this->frame_times;
+    long long total_time = 0, total_calls = 0;
+    int max_calls = 0;
+
+    std::sort(times.begin(), times.end());
+
+    for (size_t i = 0; i < times.size(); i++) {
+        total_time += (long long)times[i];
+    }
+
+    for (size_t i = 0; i < this->frame_draw_calls.size(); i++) {
+        total_calls += this->frame_draw_calls[i];
+        max_calls = std::max(max_calls, this->frame_draw_calls[i]);
+    }
+
+    fflush(stdout);
+    printf("# headless run %lld events in %.3fs, %.0f events/s\n", event_count, seconds, (seconds > 0) ? event_count / seconds : 0.0);
+
+    if (times.empty()) {
+        printf("# no frames presented\n");
+        return;
+    }
+
+    printf("# %d frames, frame time avg %lldus p50 %lldus p99 %lldus max %lldus\n", (int)times.size(), total_time / (long long)times.size(),
+           (long long)times[times.size() / 2], (long long)times[times.size() * 99 / 100], (long long)times.back());
+    printf("# draw calls per frame avg %.1f max %d\n", (double)total_calls / times.size(), max_calls);
+    printf("# input to present latency of %lld inputs p50 %lluus p99 %lluus max %lluus\n", this->latency.GetCount(),
+           (unsigned long long)this->latency.GetPercentile(0.5), (unsigned long long)this->latency.GetPercentile(0.99),
+           (unsigned long long)this->latency.GetMax());
+    fflush(stdout);
+}
+
+int MineGameWindowUI::DumpFrame(const char *path)
+{
+    SDL_Surface *surface;
+
+    // the window texture is the frame as presented
+    surface = SDL_CreateRGBSurfaceWithFormat(0, this->window_width, this->window_height, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (surface == NULL) {
+        std::cerr << "SDL_CreateRGBSurfaceWithFormat failed with error: " << SDL_GetError() << std::endl;
+        return -1;
+    }
+
+    SDL_SetRenderTarget(this->renderer, this->window_texture);
+
+    if (SDL_RenderReadPixels(this->renderer, NULL, SDL_PIXELFORMAT_ARGB8888, surface->pixels, surface->pitch) != 0) {
+        std::cerr << "SDL_RenderReadPixels failed with error: " << SDL_GetError() << std::endl;
+        SDL_SetRenderTarget(this->renderer, NULL);
+        SDL_FreeSurface(surface);
+        return -1;
+    }
+
+    SDL_SetRenderTarget(this->renderer, NULL);
+
+    if (SDL_SaveBMP(surface, path) != 0) {
+        std::cerr << "SDL_SaveBMP(" << path << ") failed with error: " << SDL_GetError() << std::endl;
+        SDL_FreeSurface(surface);
+        return -1;
+    }
+
+    SDL_FreeSurface(surface);
+
+    fflush(stdout);
+    printf("# dumped %dx%d frame to %s\n", this->window_width, this->window_height, path);
+    fflush(stdout);
+
+    return 0;
+}
+
+void MineGameWindowUI::GetHudRect(SDL_Rect &rect)
+{
+    SDL_Rect window_rect;
+
+    rect.x = this->mine_grid->GetRect()->x + MINE_GRID_EDGE_MARGIN;
+    rect.y = this->mine_grid->GetRect()->y + MINE_GRID_EDGE_MARGIN;
+    rect.w = MINE_HUD_COLUMNS * MINE_HUD_ADVANCE + MINE_HUD_MARGIN * 2;
+    rect.h = MINE_HUD_LINES * MINE_HUD_LINE_HEIGHT + MINE_HUD_MARGIN * 2;
+
+    // a beginner board is narrower than the overlay
+    window_rect.x = 0;
+    window_rect.y = 0;
+    window_rect.w = this->window_width;
+    window_rect.h = this->window_height;
+    SDL_IntersectRect(&rect, &window_rect, &rect);
+}
+
+void MineGameWindowUI::DrawHud()
+{
+    SDL_Rect rect;
+    char line[32];
+    int x, y;
+
+    this->GetHudRect(rect);
+    x = rect.x + MINE_HUD_MARGIN;
+    y = rect.y + MINE_HUD_MARGIN;
+
+    // opaque, so nothing under it has to be redrawn first
+    SDL_SetRenderTarget(this->renderer, this->window_texture);
+    SDL_SetRenderDrawColor(this->renderer, 0x00, 0x00, 0x00, 0xFF);
+    SDL_RenderFillRect(this->renderer, &rect);
+    this->draw_call_count += 1;
+
+    SDL_SetRenderDrawColor(this->renderer, 0x00, 0xFF, 0x00, 0xFF);
+    SDL_RenderSetClipRect(this->renderer, &rect);
+
+    snprintf(line, sizeof(line), "frame %lluus", (unsigned long long)this->last_frame_time);
+    this->DrawHudText(x, y, line);
+    snprintf(line, sizeof(line), "p50 %lluus", (unsigned long long)this->latency.GetPercentile(0.5));
+    this->DrawHudText(x, y + MINE_HUD_LINE_HEIGHT, line);
+    snprintf(line, sizeof(line), "p99 %lluus", (unsigned long long)this->latency.GetPercentile(0.99));
+    this->DrawHudText(x, y + MINE_HUD_LINE_HEIGHT * 2, line);
+    snprintf(line, sizeof(line), "cells %d", this->last_frame_grids);
+    this->DrawHudText(x, y + MINE_HUD_LINE_HEIGHT * 3, line);
+
+    SDL_RenderSetClipRect(this->renderer, NULL);
+
+    this->DamageWindow(&rect);
+}
+
+void MineGameWindowUI::DrawHudText(int x, int y, const char *text)
+{
+    std::vector<SDL_Rect> rects;
+
+    for (int i = 0; text[i] != '\0'; i++) {
+        for (size_t j = 0; j < sizeof(mine_hud_font) / sizeof(mine_hud_font[0]); j++) {
+            if (mine_hud_font[j].c != text[i]) {
+                continue;
+            }
+
+            for (int k = 0; k < 15; k++) {
+                if (mine_hud_font[j].rows[k] == '#') {
+                    SDL_Rect pixel;
+
+                    pixel.x = x + i * MINE_HUD_ADVANCE + (k % 3) * MINE_HUD_SCALE;
+                    pixel.y = y + (k / 3) * MINE_HUD_SCALE;
+                    pixel.w = MINE_HUD_SCALE;
+                    pixel.h = MINE_HUD_SCALE;
+                    rects.push_back(pixel);
+                }
+            }
+        }
+    }
+
+    // one call for the line
+    if (!rects.empty()) {
+        SDL_RenderFillRects(this->renderer, rects.data(), (int)rects.size());
+        this->draw_call_count += 1;
+    }
+}
+
+void MineGameWindowUI::ToggleHud()
+{
+    SDL_Rect rect;
+
+    this->hud = !this->hud;
+
+    // the overlay is drawn with the next present, or the window under it comes back
+    if (this->hud) {
+        this->DamageWindow(NULL);
+    } else {
+        this->GetHudRect(rect);
+        this->RedrawArea(&rect);
+    }
+}
+
+int MineGameWindowUI::HandleTimer(MineGameTimer *timer)
+{
+    if (timer == this->count_down_timer) {
+        this->time_counter->IncreaseCount();
+        this->time_counter->RedrawChanged();
+    } else if (timer == this->splash_timer) {
+        Uint64 elapse = SDL_GetTicks64() - this->splash_timer->GetStartTick();
+
+        if (elapse < 3000) {
+            this->winning_splash->Update(elapse);
+        } else {
+            this->StopWinningSplash();
+        }
+    } else if (timer == this->share_timer && this->share != NULL) {
+        this->HandleShareCommands();
+    }
+
+    return 0;
+}
+
+int MineGameWindowUI::HandleShareCommands()
+{
+    MineShareCommand command;
+    int count = 0;
+
+    // moves go to the logic thread like clicks, what they change comes back with the deltas
+    while (this->share->TakeCommand(command)) {
+        if (command.op == MINE_SHARE_RESET) {
+            this->GameReset();
+        } else {
+            this->SubmitCommand(MineGameCommand::COMMAND_MOVE, command.x, command.y, (int)command.op);
+        }
+
+        count += 1;
+    }
+
+    return count;
+}
+
+SDL_Texture* MineGameWindowUI::LoadTextureFromFile(const char *path)
+{
+    SDL_Surface *surface;
+    SDL_Texture *texture;
+
+    surface = this->LoadSurfaceFromFile(path);
+    if (surface == NULL) {
+        return NULL;
+    }
+
+    texture = this->CreateTextureFromSurface(surface);
+    SDL_FreeSurface(surface);
+
+    return texture;
+}
+
+SDL_Surface *MineGameWindowUI::LoadSurfaceFromFile(const char *path)
+{
+    SDL_Surface *surface;
+    std::string error;
+
+    std::cout << "Loading " << path << "..." << std::endl;
+
+    surface = MineResourceManager::DecodeFile(path, error);
+    if (surface == NULL) {
+        std::cerr << error << std::endl;
+    }
+
+    return surface;
+}
+
+SDL_Texture *MineGameWindowUI::CreateTextureFromSurface(SDL_Surface *surface)
+{
+    SDL_Texture *texture;
+
+    texture = SDL_CreateTextureFromSurface(this->renderer, surface);
+    if (texture == NULL) {
+        std::cerr << "SDL_CreateTextureFromSurface failed with error: " << SDL_GetError() << std::endl;
+        return NULL;
+    }
+
+    SDL_SetTextureAlphaMod(texture, 255);
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
     return texture;
 }
 
+SDL_Texture *MineGameWindowUI::CreateTexture(int width, int height)
+{
+    SDL_Texture *texture;
+
+    texture = SDL_CreateTexture(this->renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height);
+    //new_texture = SDL_CreateTexture(new_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, screen_width, screen_height);
+    if (texture == NULL) {
+        std::cerr << "SDL_CreateTexture failed with error: " << SDL_GetError() << std::endl;
+        return NULL;
+    }
+
+    return texture;
+}
+
+SDL_Texture *MineGameWindowUI::CreateStreamingTexture(int width, int height)
+{
+    SDL_Texture *texture;
+
+    texture = SDL_CreateTexture(this->renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+    if (texture == NULL) {
+        std::cerr << "SDL_CreateTexture failed with error: " << SDL_GetError() << std::endl;
+        return NULL;
+    }
+
+    return texture;
+}
+
+SDL_Texture *MineGameWindowUI::GetTexture(const char *path)
+{
+    return this->resources->GetTexture(path);
+}
+
+SDL_Surface *MineGameWindowUI::GetSurface(const char *path)
+{
+    return this->resources->GetSurface(path);
+}
+
 SDL_Window *MineGameWindowUI::GetSDLWindow()
 {
     return this->window;
@@ -425,26 +2045,39 @@ SDL_Window *MineGameWindowUI::GetSDLWindow()
 
 void MineGameWindowUI::GameOpen(int x, int y)
 {
-    this->game->Open(x, y);
+    this->SubmitCommand(MineGameCommand::COMMAND_OPEN, x, y, 0);
 }
 
 void MineGameWindowUI::GameTouchFlag(int x, int y)
 {
-    this->game->TouchFlag(x, y);
+    this->SubmitCommand(MineGameCommand::COMMAND_FLAG, x, y, 0);
+}
+
+void MineGameWindowUI::GameChord(int x, int y)
+{
+    this->SubmitCommand(MineGameCommand::COMMAND_CHORD, x, y, 0);
 }
 
 void MineGameWindowUI::GameReset()
 {
-    this->game->Reset();
+    this->SubmitCommand(MineGameCommand::COMMAND_RESET, 0, 0, 0);
+}
+
+void MineGameWindowUI::GameSetLevel(int width, int height, int mine_count)
+{
+    this->SubmitCommand(MineGameCommand::COMMAND_LEVEL, width, height, mine_count);
+}
 
-    this->mine_grid->SetGameSize(this->game->GetWidth(), this->game->GetHeight());
+void MineGameWindowUI::ResetView()
+{
+    this->mine_grid->SetGameSize(this->board_width, this->board_height);
     this->mine_grid->Redraw();
 
     this->time_counter->SetCount(0);
-    this->time_counter->Redraw();
+    this->time_counter->RedrawChanged();
 
-    this->mine_counter->SetCount(this->game->GetFlagCount());
-    this->mine_counter->Redraw();
+    this->mine_counter->SetCount(this->board_mine_count);
+    this->mine_counter->RedrawChanged();
 
     this->count_down_timer->Remove();
 
@@ -453,8 +2086,13 @@ void MineGameWindowUI::GameReset()
 
 void MineGameWindowUI::GameGetDirtyGrids(std::vector<MineGameGrid> &grids)
 {
-    this->game->GetDirtyGrids(grids);
-    this->game->ClearDirtyGrids();
+    grids.insert(grids.end(), this->board_dirty.begin(), this->board_dirty.end());
+    this->board_dirty.clear();
+}
+
+MineGameView MineGameWindowUI::GameGetView()
+{
+    return MineGameView(this->board.data(), this->board_width, this->board_height, this->board_width + 2);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////
@@ -465,7 +2103,8 @@ int MineGameWindowUI::CreateSDLWindow()
     SDL_Renderer *new_renderer;
     SDL_Texture *new_texture;
 
-    new_window = SDL_CreateWindow("Minesweeper", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width, height, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    // NOTE: the offscreen driver only has a GL context with EGL, a headless window asks for none
+    new_window = SDL_CreateWindow("Minesweeper", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width, height, (this->headless ? 0 : SDL_WINDOW_OPENGL) | SDL_WINDOW_HIDDEN);
     //new_window = SDL_CreateWindow("Minesweeper", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width, height, SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN);
     if (new_window == NULL) {
         std::cerr << "SDL_CreateWindowAndRenderer failed with error: " << SDL_GetError() << std::endl;
@@ -474,7 +2113,7 @@ int MineGameWindowUI::CreateSDLWindow()
 
     //new_renderer = SDL_CreateRenderer(new_window, -1, SDL_RENDERER_TARGETTEXTURE | SDL_RENDERER_SOFTWARE);
     //new_renderer = SDL_CreateRenderer(new_window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE);
-    new_renderer = SDL_CreateRenderer(new_window, -1, SDL_RENDERER_TARGETTEXTURE);
+    new_renderer = SDL_CreateRenderer(new_window, -1, SDL_RENDERER_TARGETTEXTURE | (this->vsync ? SDL_RENDERER_PRESENTVSYNC : 0));
     if (new_renderer == NULL) {
         std::cerr << "SDL_CreateWindowAndRenderer failed with error: " << SDL_GetError() << std::endl;
         SDL_DestroyWindow(new_window);
@@ -484,6 +2123,15 @@ int MineGameWindowUI::CreateSDLWindow()
     this->window = new_window;
     this->renderer = new_renderer;
 
+    // the software renderer draws into the window surface, which keeps its pixels between presents
+    SDL_RendererInfo info;
+
+    if (SDL_GetRendererInfo(new_renderer, &info) == 0) {
+        this->retained_backbuffer = (std::string(info.name) == "software");
+        this->accelerated = (info.flags & SDL_RENDERER_ACCELERATED) != 0;
+        std::cout << "MineGameWindowUI: renderer " << info.name << (this->retained_backbuffer ? ", partial presents" : "") << std::endl;
+    }
+
     new_texture = this->CreateTexture(width, height);
     if (new_texture == NULL) {
         SDL_DestroyRenderer(new_renderer);
@@ -492,27 +2140,127 @@ int MineGameWindowUI::CreateSDLWindow()
     }
 
     this->window_texture = new_texture;
+    this->window_width = width;
+    this->window_height = height;
 
     return 0;
 }
 
 int MineGameWindowUI::RedrawWindow()
 {
+    return this->RedrawArea(NULL);
+}
+
+int MineGameWindowUI::RedrawArea(const SDL_Rect *area)
+{
+    if (this->window_texture == NULL) {
+        return -1;
+    }
+
+    this->SetWindowClip(area);
+
     // set background to gray
-    SDL_SetRenderTarget(this->renderer, this->window_texture);
-    SDL_RenderClear(this->renderer);
     SDL_SetRenderDrawColor(this->renderer, 0xC0, 0xC0, 0xC0, 0);
-    SDL_RenderFillRect(this->renderer, NULL);
+    SDL_RenderFillRect(this->renderer, area);
+    this->DamageWindow(area);
+    this->draw_call_count += 1;
 
-    // redraw components
+    // redraw components, only their part inside area
     this->mine_grid->Redraw();
     this->time_counter->Redraw();
     this->mine_counter->Redraw();
     this->face_button->Redraw();
 
+    this->SetWindowClip(NULL);
+
     return 0;
 }
 
+void MineGameWindowUI::SetWindowClip(const SDL_Rect *rect)
+{
+    this->clipping = (rect != NULL);
+
+    if (rect != NULL) {
+        this->clip_rect = *rect;
+    }
+
+    if (this->window_texture != NULL) {
+        SDL_SetRenderTarget(this->renderer, this->window_texture);
+        SDL_RenderSetClipRect(this->renderer, rect);
+    }
+}
+
+void MineGameWindowUI::DamageWindow(const SDL_Rect *rect)
+{
+    SDL_Rect window_rect, damage;
+
+    window_rect.x = 0;
+    window_rect.y = 0;
+    window_rect.w = this->window_width;
+    window_rect.h = this->window_height;
+
+    this->damage_serial += 1;
+
+    if (rect == NULL) {
+        damage = window_rect;
+    } else if (!SDL_IntersectRect(rect, &window_rect, &damage)) {
+        return;
+    }
+
+    // nothing is drawn outside the clip
+    if (this->clipping && !SDL_IntersectRect(&damage, &this->clip_rect, &damage)) {
+        return;
+    }
+
+    // merge with the rects it overlaps, so no pixel is copied twice
+    for (size_t i = 0; i < this->damage_rects.size(); ) {
+        if (SDL_HasIntersection(&this->damage_rects[i], &damage)) {
+            SDL_UnionRect(&this->damage_rects[i], &damage, &damage);
+            this->damage_rects.erase(this->damage_rects.begin() + i);
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+
+    this->damage_rects.push_back(damage);
+
+    // a copy per rect, past some number one bigger copy is cheaper
+    if (this->damage_rects.size() > MINE_DAMAGE_RECT_LIMIT) {
+        for (size_t i = 1; i < this->damage_rects.size(); i++) {
+            SDL_UnionRect(&this->damage_rects[0], &this->damage_rects[i], &this->damage_rects[0]);
+        }
+
+        this->damage_rects.resize(1);
+    }
+}
+
+void MineGameWindowUI::SetMaxViewSize()
+{
+    SDL_Rect bounds;
+    SDL_RendererInfo info;
+    int width, height;
+
+    if (SDL_GetDisplayUsableBounds(SDL_GetWindowDisplayIndex(this->window), &bounds) != 0) {
+        std::cerr << "SDL_GetDisplayUsableBounds failed with error: " << SDL_GetError() << std::endl;
+        return;
+    }
+
+    // the window around the grid view has to fit on the screen
+    width = bounds.w - WINDOWS_EDGE_MARGIN * 2 - MINE_GRID_EDGE_MARGIN * 2 - WINDOWS_DECORATION_SIZE;
+    height = bounds.h - this->mine_counter->GetHeight() - WINDOWS_EDGE_MARGIN * 3 - MINE_GRID_EDGE_MARGIN * 2 - WINDOWS_DECORATION_SIZE;
+
+    // and so has the window texture
+    if (SDL_GetRendererInfo(this->renderer, &info) == 0 && info.max_texture_width > 0 && info.max_texture_height > 0) {
+        width = std::min(width, info.max_texture_width - WINDOWS_EDGE_MARGIN * 2 - MINE_GRID_EDGE_MARGIN * 2);
+        height = std::min(height, info.max_texture_height - this->mine_counter->GetHeight() - WINDOWS_EDGE_MARGIN * 3 - MINE_GRID_EDGE_MARGIN * 2);
+    }
+
+    std::cout << "MineGameWindowUI: grid view up to " << width << "x" << height << std::endl;
+
+    this->mine_grid->SetMaxViewSize(width, height);
+}
+
 int MineGameWindowUI::ResizeWindow()
 {
     int total_width, total_height;
@@ -534,6 +2282,9 @@ int MineGameWindowUI::ResizeWindow()
         }
 
         this->window_texture = texture;
+        this->window_width = total_width;
+        this->window_height = total_height;
+        this->damage_rects.clear();
     }
 
     // resize window and move components to the correct location
@@ -569,20 +2320,73 @@ void MineGameWindowUI::DestroySDLWindow()
 }
 
 int MineGameWindowUI::UpdateWindowTexture(SDL_Texture *texture, const SDL_Rect *rect)
+{
+    return this->UpdateWindowTextureRect(texture, NULL, rect);
+}
+
+int MineGameWindowUI::UpdateWindowTextureRect(SDL_Texture *texture, const SDL_Rect *src, const SDL_Rect *dst)
 {
     if (this->window_texture != NULL) {
         SDL_SetRenderTarget(this->renderer, this->window_texture);
-        SDL_RenderCopy(this->renderer, texture, NULL, rect);
-        this->window_texture_dirty = true;
+        SDL_RenderSetClipRect(this->renderer, this->clipping ? &this->clip_rect : NULL);
+        SDL_RenderCopy(this->renderer, texture, src, dst);
+        this->DamageWindow(dst);
+        this->draw_call_count += 1;
+    }
+
+    return 0;
+}
+
+int MineGameWindowUI::ClearTexture(SDL_Texture *texture)
+{
+    // the window background
+    SDL_SetRenderTarget(this->renderer, texture);
+    SDL_SetRenderDrawColor(this->renderer, 0xC0, 0xC0, 0xC0, 0xFF);
+    SDL_RenderClear(this->renderer);
+    this->draw_call_count += 1;
+
+    return 0;
+}
+
+int MineGameWindowUI::UpdateTexture(SDL_Texture *updated_texture, SDL_Texture *texture, const SDL_Rect *rect)
+{
+    SDL_SetRenderTarget(this->renderer, updated_texture);
+    SDL_RenderCopy(this->renderer, texture, NULL, rect);
+    this->draw_call_count += 1;
+
+    return 0;
+}
+
+int MineGameWindowUI::UpdateTextureGeometry(SDL_Texture *updated_texture, SDL_Texture *texture, const std::vector<SDL_Vertex> &vertices, const std::vector<int> &indices)
+{
+    SDL_SetRenderTarget(this->renderer, updated_texture);
+    this->draw_call_count += 1;
+
+    if (SDL_RenderGeometry(this->renderer, texture, vertices.data(), (int)vertices.size(), indices.data(), (int)indices.size()) != 0) {
+        std::cerr << "SDL_RenderGeometry failed with error: " << SDL_GetError() << std::endl;
+        return -1;
     }
 
     return 0;
 }
 
-int MineGameWindowUI::UpdateTexture(SDL_Texture *updated_texture, SDL_Texture *texture, const SDL_Rect *rect)
-{
-    SDL_SetRenderTarget(this->renderer, updated_texture);
-    SDL_RenderCopy(this->renderer, texture, NULL, rect);
+int MineGameWindowUI::UpdateTexturePixels(SDL_Texture *texture, const SDL_Rect *rect, const Uint32 *pixels, int pitch)
+{
+    void *data;
+    int data_pitch;
+
+    // every locked pixel is written, the rest of the texture stays as it is
+    if (SDL_LockTexture(texture, rect, &data, &data_pitch) != 0) {
+        std::cerr << "SDL_LockTexture failed with error: " << SDL_GetError() << std::endl;
+        return -1;
+    }
+
+    for (int row = 0; row < rect->h; row++) {
+        std::memcpy((Uint8*)data + row * data_pitch, (const Uint8*)pixels + row * pitch, rect->w * sizeof(Uint32));
+    }
+
+    SDL_UnlockTexture(texture);
+    this->draw_call_count += 1;
 
     return 0;
 }
@@ -590,13 +2394,40 @@ int MineGameWindowUI::UpdateTexture(SDL_Texture *updated_texture, SDL_Texture *t
 int MineGameWindowUI::RefreshWindow()
 {
     // update texture to window
-    if (this->window_texture != NULL && this->window_texture_dirty) {
-        std::cout << "RefreshWindow" << std::endl;
+    if (this->window_texture != NULL && !this->damage_rects.empty()) {
+        long long pixels = 0;
 
         SDL_SetRenderTarget(this->renderer, NULL);
-        SDL_RenderCopy(this->renderer, this->window_texture, NULL, NULL);
+
+        if (this->retained_backbuffer) {
+            // the rest of the backbuffer still holds the last frame
+            for (size_t i = 0; i < this->damage_rects.size(); i++) {
+                const SDL_Rect &rect = this->damage_rects[i];
+
+                SDL_RenderCopy(this->renderer, this->window_texture, &rect, &rect);
+                pixels += (long long)rect.w * rect.h;
+                this->draw_call_count += 1;
+            }
+        } else {
+            // NOTE: the backbuffer of an accelerated renderer is undefined after a present, it takes the whole window
+            SDL_RenderCopy(this->renderer, this->window_texture, NULL, NULL);
+            pixels = (long long)this->window_width * this->window_height;
+            this->draw_call_count += 1;
+        }
+
         SDL_RenderPresent(this->renderer);
-        this->window_texture_dirty = false;
+
+        if (this->HasStats()) {
+            std::cout << "RefreshWindow: " << this->damage_rects.size() << " damaged rects, " << pixels << " pixels copied" << std::endl;
+        }
+        this->damage_rects.clear();
+
+        if (!this->first_frame_presented) {
+            Uint64 elapse = SDL_GetPerformanceCounter() - this->start_counter;
+
+            std::cout << "MineGameWindowUI: first frame presented " << (elapse * 1000 / SDL_GetPerformanceFrequency()) << "ms after start" << std::endl;
+            this->first_frame_presented = true;
+        }
     }
 
     return 0;
@@ -612,14 +2443,20 @@ void MineGameWindowUI::ShowWinningSplash()
 
 void MineGameWindowUI::StopWinningSplash()
 {
+    // not shown, nothing to uncover
+    if (!this->splash_timer->IsActive()) {
+        return;
+    }
+
     std::cout << "stop winning splash" << std::endl;
 
     this->winning_splash->Hide();
     this->splash_timer->Remove();
-    this->RedrawWindow();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////
+#define SPLASH_SCREEN_FILE "./images/splash-win.png"
+
 SplashScreen::SplashScreen(MineGameWindowUI *window)
 {
     this->window = window;
@@ -637,18 +2474,21 @@ void SplashScreen::SetLocation(int x, int y)
 
 }
 
+void SplashScreen::RequestResources(MineResourceManager *resources)
+{
+    resources->Request(SPLASH_SCREEN_FILE);
+}
+
 int SplashScreen::LoadResources()
 {
-    this->texture = this->window->LoadTextureFromFile("./images/splash-win.png");
+    this->texture = this->window->GetTexture(SPLASH_SCREEN_FILE);
     return 0;
 }
 
 void SplashScreen::ReleaseResources()
 {
-    if (this->texture != NULL) {
-        SDL_DestroyTexture(this->texture);
-        this->texture = NULL;
-    }
+    // owned by the resource manager
+    this->texture = NULL;
 }
 
 void SplashScreen::Show()
@@ -691,22 +2531,48 @@ void SplashScreen::Hide()
 
     this->alpha = 0;
 
+    // recomposite what the splash covered
     SDL_QueryTexture(this->texture, NULL, NULL, &rect.w, &rect.h);
     SDL_SetTextureAlphaMod(this->texture, alpha);
-    this->window->UpdateWindowTexture(this->texture, &rect);
+    this->window->RedrawArea(&rect);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////
+// digits 0 to 9, then the background
+#define COUNTER_FILE_COUNT 11
+
+static const char *counter_files[COUNTER_FILE_COUNT] = {
+    "./images/png/d0.png",
+    "./images/png/d1.png",
+    "./images/png/d2.png",
+    "./images/png/d3.png",
+    "./images/png/d4.png",
+    "./images/png/d5.png",
+    "./images/png/d6.png",
+    "./images/png/d7.png",
+    "./images/png/d8.png",
+    "./images/png/d9.png",
+    "./images/png/nums_background.png"
+};
+
 CounterUI::CounterUI(MineGameWindowUI *window)
 {
     this->window = window;
 
     this->digit = new SDL_Texture * [10];
+    this->background = NULL;
+
+    for (int i = 0; i < 10; i++) {
+        this->digit[i] = NULL;
+    }
 
     this->count = 0;
     this->digit1 = 0;
     this->digit2 = 0;
     this->digit3 = 0;
+    this->drawn_digit1 = -1;
+    this->drawn_digit2 = -1;
+    this->drawn_digit3 = -1;
 
     this->background_rect = new SDL_Rect();
     this->digit1_rect = new SDL_Rect();
@@ -791,10 +2657,15 @@ void CounterUI::SetCount(int c)
         this->digit1 = 0;
         this->digit2 = c / 10;
         this->digit3 = c % 10;
-    } else {
+    } else if (c < 1000) {
         this->digit1 = c / 100;
         this->digit2 = (c % 100) / 10;
         this->digit3 = c % 10;
+    } else {
+        // three digits, a large custom board has more mines
+        this->digit1 = 9;
+        this->digit2 = 9;
+        this->digit3 = 9;
     }
 
     //std::cout << "SetCount(" << this->count << ")" << std::endl;
@@ -812,178 +2683,570 @@ void CounterUI::IncreaseCount()
     this->SetCount(c + 1);
 }
 
+void CounterUI::RequestResources(MineResourceManager *resources)
+{
+    for (int i = 0; i < COUNTER_FILE_COUNT; i++) {
+        resources->Request(counter_files[i]);
+    }
+}
+
 int CounterUI::LoadResources()
 {
-    this->digit[0] = this->window->LoadTextureFromFile("./images/png/d0.png");
-    this->digit[1] = this->window->LoadTextureFromFile("./images/png/d1.png");
-    this->digit[2] = this->window->LoadTextureFromFile("./images/png/d2.png");
-    this->digit[3] = this->window->LoadTextureFromFile("./images/png/d3.png");
-    this->digit[4] = this->window->LoadTextureFromFile("./images/png/d4.png");
-    this->digit[5] = this->window->LoadTextureFromFile("./images/png/d5.png");
-    this->digit[6] = this->window->LoadTextureFromFile("./images/png/d6.png");
-    this->digit[7] = this->window->LoadTextureFromFile("./images/png/d7.png");
-    this->digit[8] = this->window->LoadTextureFromFile("./images/png/d8.png");
-    this->digit[9] = this->window->LoadTextureFromFile("./images/png/d9.png");
-    this->background = this->window->LoadTextureFromFile("./images/png/nums_background.png");
+    for (int i = 0; i < 10; i++) {
+        this->digit[i] = this->window->GetTexture(counter_files[i]);
+    }
+
+    this->background = this->window->GetTexture(counter_files[10]);
 
     return 0;
 }
 
 void CounterUI::ReleaseResources()
 {
+    // owned by the resource manager, shared by both counters
     for (int i = 0; i < 10; i++) {
-        if (this->digit[i] != NULL) {
-            SDL_DestroyTexture(this->digit[i]);
-            this->digit[i] = NULL;
+        this->digit[i] = NULL;
+    }
+
+    this->background = NULL;
+}
+
+int CounterUI::Redraw()
+{
+    this->window->UpdateWindowTexture(this->background, this->background_rect);
+    this->window->UpdateWindowTexture(this->digit[this->digit1], this->digit1_rect);
+    this->window->UpdateWindowTexture(this->digit[this->digit2], this->digit2_rect);
+    this->window->UpdateWindowTexture(this->digit[this->digit3], this->digit3_rect);
+
+    this->drawn_digit1 = this->digit1;
+    this->drawn_digit2 = this->digit2;
+    this->drawn_digit3 = this->digit3;
+
+    return 0;
+}
+
+int CounterUI::RedrawChanged()
+{
+    // a tick usually changes the last digit only
+    this->RedrawDigit(this->digit1_rect, this->digit1, this->drawn_digit1);
+    this->RedrawDigit(this->digit2_rect, this->digit2, this->drawn_digit2);
+    this->RedrawDigit(this->digit3_rect, this->digit3, this->drawn_digit3);
+
+    return 0;
+}
+
+void CounterUI::RedrawDigit(const SDL_Rect *rect, int digit, int &drawn_digit)
+{
+    if (digit == drawn_digit) {
+        return;
+    }
+
+    // the digit over its part of the background
+    this->window->SetWindowClip(rect);
+    this->window->UpdateWindowTexture(this->background, this->background_rect);
+    this->window->UpdateWindowTexture(this->digit[digit], rect);
+    this->window->SetWindowClip(NULL);
+
+    drawn_digit = digit;
+}
+
+int CounterUI::HandleMouseMotionEvent(SDL_MouseMotionEvent *event)
+{
+    // do nothing
+    return 0;
+}
+
+int CounterUI::HandleMouseButtonEvent(SDL_MouseButtonEvent *event)
+{
+    // do nothing
+    return 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////
+// one file per FaceButtonUI::Status, in status order
+#define FACE_BUTTON_FILE_COUNT 4
+
+static const char *face_button_files[FACE_BUTTON_FILE_COUNT] = {
+    "./images/png/face_pressed.png",
+    "./images/png/face_unpressed.png",
+    "./images/png/face_win.png",
+    "./images/png/face_lose.png"
+};
+
+FaceButtonUI::FaceButtonUI(MineGameWindowUI *window)
+{
+    this->window = window;
+
+    this->face_pressed = NULL;
+    this->face_unpressed = NULL;
+    this->face_win = NULL;
+    this->face_lose = NULL;
+
+    this->rect = new SDL_Rect();
+
+    this->rect->x = 0;
+    this->rect->y = 0;
+    this->rect->w = FACE_BUTTON_SIZE + FACE_BUTTON_EDGE_MARGIN * 2;
+    this->rect->h = FACE_BUTTON_SIZE + FACE_BUTTON_EDGE_MARGIN * 2;
+
+    this->current_status = FaceButtonUI::STATUS_FACE_UNPRESSED;
+}
+
+FaceButtonUI::~FaceButtonUI()
+{
+    this->ReleaseResources();
+
+    delete this->rect;
+}
+
+
+void FaceButtonUI::SetLocation(int x, int y)
+{
+    this->rect->x = x;
+    this->rect->y = y;
+}
+
+const SDL_Rect *FaceButtonUI::GetRect() const
+{
+    return this->rect;
+}
+
+int FaceButtonUI::GetWidth() const
+{
+    return this->GetRect()->w;
+}
+
+int FaceButtonUI::GetHeight() const
+{
+    return this->GetRect()->h;
+}
+
+void FaceButtonUI::SetStatus(FaceButtonUI::Status status)
+{
+    if (this->current_status != status) {
+        this->current_status = status;
+        this->Redraw();
+    }
+}
+
+FaceButtonUI::Status FaceButtonUI::GetStatus() const
+{
+    return this->current_status;
+}
+
+void FaceButtonUI::RequestResources(MineResourceManager *resources)
+{
+    for (int i = 0; i < FACE_BUTTON_FILE_COUNT; i++) {
+        resources->Request(face_button_files[i]);
+    }
+}
+
+int FaceButtonUI::LoadResources()
+{
+    this->face_pressed = this->window->GetTexture(face_button_files[STATUS_FACE_PRESSED]);
+    this->face_unpressed = this->window->GetTexture(face_button_files[STATUS_FACE_UNPRESSED]);
+    this->face_win = this->window->GetTexture(face_button_files[STATUS_FACE_WIN]);
+    this->face_lose = this->window->GetTexture(face_button_files[STATUS_FACE_LOSE]);
+
+    return 0;
+}
+
+void FaceButtonUI::ReleaseResources()
+{
+    // owned by the resource manager
+    this->face_pressed = NULL;
+    this->face_unpressed = NULL;
+    this->face_win = NULL;
+    this->face_lose = NULL;
+}
+
+int FaceButtonUI::Redraw()
+{
+    // pressed
+    if (this->current_status == STATUS_FACE_PRESSED) {
+        this->window->UpdateWindowTexture(this->face_pressed, this->GetRect());
+    }
+    // unpressed
+    else if (this->current_status == STATUS_FACE_UNPRESSED) {
+        this->window->UpdateWindowTexture(this->face_unpressed, this->GetRect());
+    }
+    // win
+    else if (this->current_status == STATUS_FACE_WIN) {
+        this->window->UpdateWindowTexture(this->face_win, this->GetRect());
+    }
+    // lose
+    else {
+        this->window->UpdateWindowTexture(this->face_lose, this->GetRect());
+    }
+
+    return 0;
+}
+
+int FaceButtonUI::HandleMouseMotionEvent(SDL_MouseMotionEvent *event)
+{
+    int x1, x2, y1, y2, last_x, last_y;
+    bool start_in, end_in;
+
+    x1 = this->GetRect()->x;
+    x2 = this->GetRect()->x + this->GetRect()->w;
+    y1 = this->GetRect()->y;
+    y2 = this->GetRect()->y + this->GetRect()->h;
+    last_x = event->x - event->xrel;
+    last_y = event->y - event->yrel;
+
+    start_in = (x1 <= last_x && last_x < x2 && y1 <= last_y && last_y < y2);
+    end_in = (x1 <= event->x && event->x < x2 && y1 <= event->y && event->y < y2);
+
+    // leaving component
+    if (start_in && !end_in) {
+        /*
+        std::cout << "SDL_MouseMotionEvent: ";
+        std::cout << "type = SDL_MOUSEMOTION";
+        std::cout << ", state = " << event->state;
+        std::cout << ", x = " << event->x << ", y = " << event->y;
+        std::cout << ", xrel = " << event->xrel << ", yrel = " << event->yrel;
+        std::cout << ", type = leaving" << std::endl;
+        */
+        // handle leaving with click button hold
+        if (this->GetStatus() == FaceButtonUI::STATUS_FACE_PRESSED) {
+            this->SetStatus(FaceButtonUI::STATUS_FACE_UNPRESSED);
+            this->window->GameReset();
         }
     }
+    // entering component
+    else if (!start_in && end_in) {
+        /*
+        std::cout << "SDL_MouseMotionEvent: ";
+        std::cout << "type = SDL_MOUSEMOTION";
+        std::cout << ", state = " << event->state;
+        std::cout << ", x = " << event->x << ", y = " << event->y;
+        std::cout << ", xrel = " << event->xrel << ", yrel = " << event->yrel;
+        std::cout << ", type = entering" << std::endl;
+        */
+    } else {
+        /*
+        std::cout << "SDL_MouseMotionEvent: ";
+        std::cout << "type = SDL_MOUSEMOTION";
+        std::cout << ", state = " << event->state;
+        std::cout << ", x = " << event->x << ", y = " << event->y;
+        std::cout << ", xrel = " << event->xrel << ", yrel = " << event->yrel;
+        std::cout << ", type = ???" << std::endl;
+        */
+    }
+
+    return 0;
+}
+
+int FaceButtonUI::HandleMouseButtonEvent(SDL_MouseButtonEvent *event)
+{
+    int x1, x2, y1, y2;
+
+    x1 = this->GetRect()->x;
+    x2 = this->GetRect()->x + this->GetRect()->w;
+    y1 = this->GetRect()->y;
+    y2 = this->GetRect()->y + this->GetRect()->h;
 
-    if (this->background != NULL) {
-        SDL_DestroyTexture(this->background);
-        this->background = NULL;
+    if (x1 <= event->x && event->x < x2 && y1 <= event->y && event->y < y2) {
+        /*
+        std::cout << "SDL_MouseButtonEvent: ";
+        std::cout << "type = " << (event->type == SDL_MOUSEBUTTONDOWN) ? "SDL_MOUSEBUTTONDOWN" : "SDL_MOUSEBUTTONUP";
+        std::cout << ", button = " << (int)event->button;
+        std::cout << ", state = " << (event->state == SDL_PRESSED) ? "SDL_PRESSED" : "SDL_RELEASED";
+        std::cout << ", clicks = " << (int)event->clicks << std::endl;
+        */
+        if (event->button == SDL_BUTTON_LEFT) {
+            if (event->type == SDL_MOUSEBUTTONDOWN) {
+                this->SetStatus(FaceButtonUI::STATUS_FACE_PRESSED);
+            } else if (event->type == SDL_MOUSEBUTTONUP) {
+                this->SetStatus(FaceButtonUI::STATUS_FACE_UNPRESSED);
+                this->window->GameReset();
+            }
+       }
     }
-}
-
-int CounterUI::Redraw()
-{
-    this->window->UpdateWindowTexture(this->background, this->background_rect);
-    this->window->UpdateWindowTexture(this->digit[this->digit1], this->digit1_rect);
-    this->window->UpdateWindowTexture(this->digit[this->digit2], this->digit2_rect);
-    this->window->UpdateWindowTexture(this->digit[this->digit3], this->digit3_rect);
 
     return 0;
 }
 
-int CounterUI::HandleMouseMotionEvent(SDL_MouseMotionEvent *event)
-{
-    // do nothing
-    return 0;
+////////////////////////////////////////////////////////////////////////////////////
+// one atlas tile per MineGameGrid::State, in state order
+static_assert(MineGameGrid::STATE_MINE_OPEN + 1 == MINE_GRID_ATLAS_TILE_COUNT, "one atlas tile per visible grid state");
+static_assert(MINE_GRID_ATLAS_TILE_COUNT <= MINE_GRID_ATLAS_COLUMNS * MINE_GRID_ATLAS_ROWS, "atlas too small");
+
+static const char *mine_grid_atlas_files[MINE_GRID_ATLAS_TILE_COUNT] = {
+    "./images/png/type0.png",
+    "./images/png/type1.png",
+    "./images/png/type2.png",
+    "./images/png/type3.png",
+    "./images/png/type4.png",
+    "./images/png/type5.png",
+    "./images/png/type6.png",
+    "./images/png/type7.png",
+    "./images/png/type8.png",
+    "./images/png/closed.png",
+    "./images/png/flag.png",
+    "./images/png/mine_wrong.png",
+    "./images/png/mine_red.png",
+    "./images/png/mine.png"
+};
+
+// the same images as vector art, in the same order
+static const char *mine_grid_svg_files[MINE_GRID_ATLAS_TILE_COUNT] = {
+    "./images/svg/type0.svg",
+    "./images/svg/type1.svg",
+    "./images/svg/type2.svg",
+    "./images/svg/type3.svg",
+    "./images/svg/type4.svg",
+    "./images/svg/type5.svg",
+    "./images/svg/type6.svg",
+    "./images/svg/type7.svg",
+    "./images/svg/type8.svg",
+    "./images/svg/closed.svg",
+    "./images/svg/flag.svg",
+    "./images/svg/mine_wrong.svg",
+    "./images/svg/mine_red.svg",
+    "./images/svg/mine.svg"
+};
+
+// the tile of state in an atlas of size x size tiles
+static constexpr SDL_Rect MineGridAtlasRect(int state, int size)
+{
+    return { (state % MINE_GRID_ATLAS_COLUMNS) * size, (state / MINE_GRID_ATLAS_COLUMNS) * size, size, size };
+}
+
+// pixels per grid of each zoom step, MINE_GRID_MINE_SIZE is the default
+static const int mine_grid_zoom_steps[] = { 4, 6, 8, 12, 16, 24, 32, 48, 64 };
+#define MINE_GRID_ZOOM_STEP_COUNT (int)(sizeof(mine_grid_zoom_steps) / sizeof(mine_grid_zoom_steps[0]))
+
+// the largest zoom step not above cell_size
+static int MineGridZoomStep(int cell_size)
+{
+    int step = 0;
+
+    while (step + 1 < MINE_GRID_ZOOM_STEP_COUNT && mine_grid_zoom_steps[step + 1] <= cell_size) {
+        step++;
+    }
+
+    return step;
 }
 
-int CounterUI::HandleMouseButtonEvent(SDL_MouseButtonEvent *event)
+MineGridUI::MineGridUI(MineGameWindowUI *window)
 {
-    // do nothing
-    return 0;
-}
+    this->window = window;
 
+    this->atlas = NULL;
 
-////////////////////////////////////////////////////////////////////////////////////
-FaceButtonUI::FaceButtonUI(MineGameWindowUI *window)
-{
-    this->window = window;
+    this->game_x = 9;
+    this->game_y = 9;
 
-    this->face_pressed = NULL;
-    this->face_unpressed = NULL;
-    this->face_win = NULL;
+    this->cell_size = MINE_GRID_MINE_SIZE;
+    this->view_x = 0;
+    this->view_y = 0;
+    this->view_width = this->game_x * this->cell_size;
+    this->view_height = this->game_y * this->cell_size;
+    this->max_view_width = MINE_GAME_MAX_WIDTH * MINE_GRID_MINE_SIZE;
+    this->max_view_height = MINE_GAME_MAX_HEIGHT * MINE_GRID_MINE_SIZE;
+    this->panning = false;
+    this->left_down = false;
+    this->right_down = false;
+    this->chording = false;
+    this->pointer_x = -1;
+    this->pointer_y = -1;
+
+    this->atlas_tile_size = 0;
+    this->svg_tiles = true;
+
+    this->software = false;
+    this->atlas_surface = NULL;
+    this->tiles_cell_size = 0;
+    this->pixels_dirty.x = 0;
+    this->pixels_dirty.y = 0;
+    this->pixels_dirty.w = 0;
+    this->pixels_dirty.h = 0;
 
     this->rect = new SDL_Rect();
-
     this->rect->x = 0;
     this->rect->y = 0;
-    this->rect->w = FACE_BUTTON_SIZE + FACE_BUTTON_EDGE_MARGIN * 2;
-    this->rect->h = FACE_BUTTON_SIZE + FACE_BUTTON_EDGE_MARGIN * 2;
+    this->rect->w = this->view_width + MINE_GRID_EDGE_MARGIN * 2;
+    this->rect->h = this->view_height + MINE_GRID_EDGE_MARGIN * 2;
 
-    this->current_status = FaceButtonUI::STATUS_FACE_UNPRESSED;
+    this->grid_texture = NULL;
 }
 
-FaceButtonUI::~FaceButtonUI()
+MineGridUI::~MineGridUI()
 {
     this->ReleaseResources();
 
     delete this->rect;
 }
 
-
-void FaceButtonUI::SetLocation(int x, int y)
+void MineGridUI::SetLocation(int x, int y)
 {
     this->rect->x = x;
     this->rect->y = y;
 }
 
-const SDL_Rect *FaceButtonUI::GetRect() const
+void MineGridUI::SetGameSize(int x, int y)
 {
-    return this->rect;
+    std::cout << "MineGridUI::SetGridSize(x=" << x << ", y=" << y << ")" << std::endl;
+
+    // a new level starts at the default zoom from the top left
+    if (this->game_x != x || this->game_y != y) {
+        this->game_x = x;
+        this->game_y = y;
+
+        this->cell_size = MINE_GRID_MINE_SIZE;
+        this->view_x = 0;
+        this->view_y = 0;
+    }
+
+    // the view is the board up to the limit, a larger board is scrolled
+    int width = std::min(this->game_x * this->cell_size, this->max_view_width);
+    int height = std::min(this->game_y * this->cell_size, this->max_view_height);
+
+    if (this->view_width != width || this->view_height != height) {
+        this->view_width = width;
+        this->view_height = height;
+
+        this->rect->w = this->view_width + MINE_GRID_EDGE_MARGIN * 2;
+        this->rect->h = this->view_height + MINE_GRID_EDGE_MARGIN * 2;
+
+        if (this->grid_texture != NULL) {
+            SDL_DestroyTexture(this->grid_texture);
+            this->grid_texture = NULL;
+        }
+    }
+
+    this->ScrollView(0, 0);
+
+    // set game size will always trigger redraw
+    this->InitTexture();
 }
 
-int FaceButtonUI::GetWidth() const
+void MineGridUI::SetSoftware(bool software)
 {
-    return this->GetRect()->w;
+    std::cout << "MineGridUI: " << (software ? "software" : "geometry") << " grid backend" << std::endl;
+
+    this->software = software;
 }
 
-int FaceButtonUI::GetHeight() const
+void MineGridUI::SetMaxViewSize(int width, int height)
 {
-    return this->GetRect()->h;
+    // at least one grid at the default zoom
+    this->max_view_width = std::max(width, MINE_GRID_MINE_SIZE);
+    this->max_view_height = std::max(height, MINE_GRID_MINE_SIZE);
 }
 
-void FaceButtonUI::SetStatus(FaceButtonUI::Status status)
+const SDL_Rect *MineGridUI::GetRect() const
 {
-    if (this->current_status != status) {
-        this->current_status = status;
-        this->Redraw();
-    }
+    return this->rect;
 }
 
-FaceButtonUI::Status FaceButtonUI::GetStatus() const
+int MineGridUI::GetWidth() const
 {
-    return this->current_status;
+    return this->GetRect()->w;
 }
 
-int FaceButtonUI::LoadResources()
+int MineGridUI::GetHeight() const
 {
-    this->face_pressed = this->window->LoadTextureFromFile("./images/png/face_pressed.png");
-    this->face_unpressed = this->window->LoadTextureFromFile("./images/png/face_unpressed.png");
-    this->face_win = this->window->LoadTextureFromFile("./images/png/face_win.png");
-    this->face_lose = this->window->LoadTextureFromFile("./images/png/face_lose.png");
+    return this->GetRect()->h;
+}
 
-    return 0;
+void MineGridUI::RequestResources(MineResourceManager *resources)
+{
+    for (int i = 0; i < MINE_GRID_ATLAS_TILE_COUNT; i++) {
+        resources->Request(mine_grid_atlas_files[i]);
+    }
 }
 
-void FaceButtonUI::ReleaseResources()
+int MineGridUI::LoadResources()
 {
-    if (this->face_pressed != NULL) {
-        SDL_DestroyTexture(this->face_pressed);
-        this->face_pressed = NULL;
+    SDL_Surface *surface;
+    char *pref_path;
+
+    // pack the grid images into one texture, so a redraw of any number of grids is one draw call
+    // NOTE: the images/png atlas stays as the fallback when images/svg cannot be rasterized
+    surface = this->CreateAtlasSurface(MINE_GRID_ATLAS_TILE_SIZE);
+    if (surface == NULL) {
+        return -1;
     }
 
-    if (this->face_unpressed != NULL) {
-        SDL_DestroyTexture(this->face_unpressed);
-        this->face_unpressed = NULL;
+    for (int i = 0; i < MINE_GRID_ATLAS_TILE_COUNT; i++) {
+        SDL_Surface *tile = this->window->GetSurface(mine_grid_atlas_files[i]);
+        SDL_Rect rect = MineGridAtlasRect(i, MINE_GRID_ATLAS_TILE_SIZE);
+
+        if (tile == NULL) {
+            continue;
+        }
+
+        // copy alpha as is instead of blending it onto the empty atlas
+        SDL_SetSurfaceBlendMode(tile, SDL_BLENDMODE_NONE);
+
+        if (SDL_BlitScaled(tile, NULL, surface, &rect) != 0) {
+            std::cerr << "SDL_BlitScaled failed with error: " << SDL_GetError() << std::endl;
+        }
     }
 
-    if (this->face_win != NULL) {
-        SDL_DestroyTexture(this->face_win);
-        this->face_win = NULL;
+    if (this->AddAtlas(MINE_GRID_ATLAS_PNG, surface) != 0) {
+        return -1;
     }
 
-    if (this->face_lose != NULL) {
-        SDL_DestroyTexture(this->face_lose);
-        this->face_lose = NULL;
+    // rasterized atlases are kept across runs, NULL when SDL has no writable place for them
+    pref_path = SDL_GetPrefPath("chubiei", "minesweeper");
+    if (pref_path != NULL) {
+        this->atlas_cache_path = pref_path;
+        SDL_free(pref_path);
     }
+
+    this->InitTexture();
+
+    return 0;
 }
 
-int FaceButtonUI::Redraw()
+void MineGridUI::ReleaseResources()
 {
-    // pressed
-    if (this->current_status == STATUS_FACE_PRESSED) {
-        this->window->UpdateWindowTexture(this->face_pressed, this->GetRect());
-    }
-    // unpressed
-    else if (this->current_status == STATUS_FACE_UNPRESSED) {
-        this->window->UpdateWindowTexture(this->face_unpressed, this->GetRect());
+    std::map<int, SDL_Texture*>::iterator texture;
+    std::map<int, SDL_Surface*>::iterator surface;
+
+    for (texture = this->atlas_textures.begin(); texture != this->atlas_textures.end(); ++texture) {
+        SDL_DestroyTexture(texture->second);
     }
-    // win
-    else if (this->current_status == STATUS_FACE_WIN) {
-        this->window->UpdateWindowTexture(this->face_win, this->GetRect());
+
+    for (surface = this->atlas_surfaces.begin(); surface != this->atlas_surfaces.end(); ++surface) {
+        SDL_FreeSurface(surface->second);
     }
-    // lose
-    else {
-        this->window->UpdateWindowTexture(this->face_lose, this->GetRect());
+
+    this->atlas_textures.clear();
+    this->atlas_surfaces.clear();
+    this->atlas = NULL;
+    this->atlas_surface = NULL;
+    this->atlas_tile_size = 0;
+
+    this->tiles.clear();
+    this->tiles_cell_size = 0;
+
+    if (this->grid_texture != NULL) {
+        SDL_DestroyTexture(this->grid_texture);
+        this->grid_texture = NULL;
     }
+}
+
+int MineGridUI::Redraw()
+{
+    SDL_Rect view_rect;
+
+    // the view inside the edge margin
+    view_rect.x = this->GetRect()->x + MINE_GRID_EDGE_MARGIN;
+    view_rect.y = this->GetRect()->y + MINE_GRID_EDGE_MARGIN;
+    view_rect.w = this->view_width;
+    view_rect.h = this->view_height;
+
+    this->window->UpdateWindowTexture(this->grid_texture, &view_rect);
 
     return 0;
 }
 
-int FaceButtonUI::HandleMouseMotionEvent(SDL_MouseMotionEvent *event)
+int MineGridUI::HandleMouseMotionEvent(SDL_MouseMotionEvent *event)
 {
     int x1, x2, y1, y2, last_x, last_y;
     bool start_in, end_in;
@@ -994,10 +3257,19 @@ int FaceButtonUI::HandleMouseMotionEvent(SDL_MouseMotionEvent *event)
     y2 = this->GetRect()->y + this->GetRect()->h;
     last_x = event->x - event->xrel;
     last_y = event->y - event->yrel;
+    this->pointer_x = event->x;
+    this->pointer_y = event->y;
 
     start_in = (x1 <= last_x && last_x < x2 && y1 <= last_y && last_y < y2);
     end_in = (x1 <= event->x && event->x < x2 && y1 <= event->y && event->y < y2);
 
+    // dragging with the middle button moves the board with the pointer
+    if (this->panning && (event->state & SDL_BUTTON_MMASK)) {
+        this->ScrollView(-event->xrel, -event->yrel);
+        this->InitTexture();
+        this->Redraw();
+    }
+
     // leaving component
     if (start_in && !end_in) {
         /*
@@ -1008,11 +3280,6 @@ int FaceButtonUI::HandleMouseMotionEvent(SDL_MouseMotionEvent *event)
         std::cout << ", xrel = " << event->xrel << ", yrel = " << event->yrel;
         std::cout << ", type = leaving" << std::endl;
         */
-        // handle leaving with click button hold
-        if (this->GetStatus() == FaceButtonUI::STATUS_FACE_PRESSED) {
-            this->SetStatus(FaceButtonUI::STATUS_FACE_UNPRESSED);
-            this->window->GameReset();
-        }
     }
     // entering component
     else if (!start_in && end_in) {
@@ -1038,7 +3305,7 @@ int FaceButtonUI::HandleMouseMotionEvent(SDL_MouseMotionEvent *event)
     return 0;
 }
 
-int FaceButtonUI::HandleMouseButtonEvent(SDL_MouseButtonEvent *event)
+int MineGridUI::HandleMouseButtonEvent(SDL_MouseButtonEvent *event)
 {
     int x1, x2, y1, y2;
 
@@ -1048,368 +3315,693 @@ int FaceButtonUI::HandleMouseButtonEvent(SDL_MouseButtonEvent *event)
     y2 = this->GetRect()->y + this->GetRect()->h;
 
     if (x1 <= event->x && event->x < x2 && y1 <= event->y && event->y < y2) {
-        /*
+/*
         std::cout << "SDL_MouseButtonEvent: ";
-        std::cout << "type = " << (event->type == SDL_MOUSEBUTTONDOWN) ? "SDL_MOUSEBUTTONDOWN" : "SDL_MOUSEBUTTONUP";
+        std::cout << "type = " << ((event->type == SDL_MOUSEBUTTONDOWN) ? "SDL_MOUSEBUTTONDOWN" : "SDL_MOUSEBUTTONUP");
         std::cout << ", button = " << (int)event->button;
         std::cout << ", state = " << (event->state == SDL_PRESSED) ? "SDL_PRESSED" : "SDL_RELEASED";
         std::cout << ", clicks = " << (int)event->clicks << std::endl;
-        */
-        if (event->button == SDL_BUTTON_LEFT) {
-            if (event->type == SDL_MOUSEBUTTONDOWN) {
-                this->SetStatus(FaceButtonUI::STATUS_FACE_PRESSED);
-            } else if (event->type == SDL_MOUSEBUTTONUP) {
-                this->SetStatus(FaceButtonUI::STATUS_FACE_UNPRESSED);
-                this->window->GameReset();
-            }
-       }
+*/
+        int index_x, index_y;
+        bool pressed = (event->type == SDL_MOUSEBUTTONDOWN);
+
+        if (event->button == SDL_BUTTON_MIDDLE) {
+            this->panning = pressed;
+        } else if (this->MapPoint(event->x, event->y, index_x, index_y)) {
+            // the first button up while both are down chords, the second one does nothing
+            bool other_down = (event->button == SDL_BUTTON_LEFT) ? this->right_down : this->left_down;
+
+            if (pressed) {
+                this->chording = false;
+            } else if (other_down) {
+                this->window->GameChord(index_x, index_y);
+                this->chording = true;
+            } else if (this->chording) {
+                this->chording = false;
+            } else if (event->button == SDL_BUTTON_LEFT) {
+                this->window->GameOpen(index_x, index_y);
+            } else if (event->button == SDL_BUTTON_RIGHT) {
+                this->window->GameTouchFlag(index_x, index_y);
+            }   
+        }
+    } else if (event->button == SDL_BUTTON_MIDDLE && event->type == SDL_MOUSEBUTTONUP) {
+        this->panning = false;
+    }
+
+    // buttons and pointer are tracked from the events, pushed events do not move SDL_GetMouseState
+    this->pointer_x = event->x;
+    this->pointer_y = event->y;
+
+    if (event->button == SDL_BUTTON_LEFT) {
+        this->left_down = (event->type == SDL_MOUSEBUTTONDOWN);
+    } else if (event->button == SDL_BUTTON_RIGHT) {
+        this->right_down = (event->type == SDL_MOUSEBUTTONDOWN);
+    }
+  
+    return 0;
+}
+
+int MineGridUI::HandleMouseWheelEvent(SDL_MouseWheelEvent *event)
+{
+    int x, y, dx, dy;
+
+#if SDL_VERSION_ATLEAST(2, 26, 0)
+    x = event->mouseX;
+    y = event->mouseY;
+#else
+    x = this->pointer_x;
+    y = this->pointer_y;
+#endif
+
+    x -= this->GetRect()->x + MINE_GRID_EDGE_MARGIN;
+    y -= this->GetRect()->y + MINE_GRID_EDGE_MARGIN;
+
+    if (x < 0 || x >= this->view_width || y < 0 || y >= this->view_height) {
+        return 0;
+    }
+
+    dx = event->x;
+    dy = event->y;
+
+    if (event->direction == SDL_MOUSEWHEEL_FLIPPED) {
+        dx = -dx;
+        dy = -dy;
+    }
+
+    if (SDL_GetModState() & KMOD_CTRL) {
+        // ctrl + wheel zooms around the pointer
+        int step = MineGridZoomStep(this->cell_size) + ((dy > 0) ? 1 : (dy < 0) ? -1 : 0);
+
+        step = std::max(0, std::min(step, MINE_GRID_ZOOM_STEP_COUNT - 1));
+        this->ZoomView(mine_grid_zoom_steps[step], x, y);
+    } else if (SDL_GetModState() & KMOD_SHIFT) {
+        // shift + wheel scrolls sideways
+        this->ScrollView(-dy * MINE_GRID_SCROLL_GRIDS * this->cell_size, 0);
+    } else {
+        this->ScrollView(dx * MINE_GRID_SCROLL_GRIDS * this->cell_size, -dy * MINE_GRID_SCROLL_GRIDS * this->cell_size);
+    }
+
+    this->InitTexture();
+    this->Redraw();
+
+    return 0;
+}
+
+int MineGridUI::HandleKeyboardEvent(SDL_KeyboardEvent *event)
+{
+    int scroll = MINE_GRID_SCROLL_GRIDS * this->cell_size;
+    int step = MineGridZoomStep(this->cell_size);
+
+    // arrows scroll, + and - zoom around the middle of the view, 0 goes back to the default zoom
+    switch (event->keysym.sym) {
+        case SDLK_LEFT:
+            this->ScrollView(-scroll, 0);
+            break;
+        case SDLK_RIGHT:
+            this->ScrollView(scroll, 0);
+            break;
+        case SDLK_UP:
+            this->ScrollView(0, -scroll);
+            break;
+        case SDLK_DOWN:
+            this->ScrollView(0, scroll);
+            break;
+        case SDLK_PLUS:
+        case SDLK_EQUALS:
+        case SDLK_KP_PLUS:
+            step = std::min(step + 1, MINE_GRID_ZOOM_STEP_COUNT - 1);
+            this->ZoomView(mine_grid_zoom_steps[step], this->view_width / 2, this->view_height / 2);
+            break;
+        case SDLK_MINUS:
+        case SDLK_KP_MINUS:
+            step = std::max(step - 1, 0);
+            this->ZoomView(mine_grid_zoom_steps[step], this->view_width / 2, this->view_height / 2);
+            break;
+        case SDLK_0:
+            this->ZoomView(MINE_GRID_MINE_SIZE, this->view_width / 2, this->view_height / 2);
+            break;
+        default:
+            return 0;
+    }
+
+    this->InitTexture();
+    this->Redraw();
+
+    return 0;
+}
+
+void MineGridUI::ScrollView(int dx, int dy)
+{
+    // NOTE: a board smaller than the view stays at the top left, the rest of the view is background
+    int max_x = this->game_x * this->cell_size - this->view_width;
+    int max_y = this->game_y * this->cell_size - this->view_height;
+
+    this->view_x = std::max(0, std::min(this->view_x + dx, max_x));
+    this->view_y = std::max(0, std::min(this->view_y + dy, max_y));
+}
+
+void MineGridUI::ZoomView(int cell_size, int x, int y)
+{
+    if (cell_size == this->cell_size) {
+        return;
+    }
+
+    // board point under (x, y), in grids
+    double board_x = (double)(this->view_x + x) / this->cell_size;
+    double board_y = (double)(this->view_y + y) / this->cell_size;
+
+    this->cell_size = cell_size;
+    this->view_x = (int)(board_x * cell_size) - x;
+    this->view_y = (int)(board_y * cell_size) - y;
+
+    this->ScrollView(0, 0);
+}
+
+void MineGridUI::GetVisibleRange(int &x1, int &y1, int &x2, int &y2) const
+{
+    x1 = this->view_x / this->cell_size;
+    y1 = this->view_y / this->cell_size;
+    x2 = std::min(this->game_x, (this->view_x + this->view_width + this->cell_size - 1) / this->cell_size);
+    y2 = std::min(this->game_y, (this->view_y + this->view_height + this->cell_size - 1) / this->cell_size);
+}
+
+bool MineGridUI::GetGridPoint(int x, int y, int &point_x, int &point_y)
+{
+    if (x < 0 || x >= this->game_x || y < 0 || y >= this->game_y) {
+        return false;
+    }
+
+    int left = x * this->cell_size - this->view_x;
+    int top = y * this->cell_size - this->view_y;
+    int dx = 0, dy = 0;
+
+    // scroll the least that shows the whole grid
+    if (left < 0) {
+        dx = left;
+    } else if (left + this->cell_size > this->view_width) {
+        dx = left + this->cell_size - this->view_width;
+    }
+
+    if (top < 0) {
+        dy = top;
+    } else if (top + this->cell_size > this->view_height) {
+        dy = top + this->cell_size - this->view_height;
+    }
+
+    if (dx != 0 || dy != 0) {
+        this->ScrollView(dx, dy);
+        this->InitTexture();
+        this->Redraw();
+    }
+
+    point_x = this->GetRect()->x + MINE_GRID_EDGE_MARGIN + x * this->cell_size - this->view_x + this->cell_size / 2;
+    point_y = this->GetRect()->y + MINE_GRID_EDGE_MARGIN + y * this->cell_size - this->view_y + this->cell_size / 2;
+
+    return true;
+}
+
+bool MineGridUI::MapPoint(int x, int y, int &index_x, int &index_y) const
+{
+    x -= this->GetRect()->x + MINE_GRID_EDGE_MARGIN;
+    y -= this->GetRect()->y + MINE_GRID_EDGE_MARGIN;
+
+    if (x < 0 || x >= this->view_width || y < 0 || y >= this->view_height) {
+        return false;
+    }
+
+    index_x = (this->view_x + x) / this->cell_size;
+    index_y = (this->view_y + y) / this->cell_size;
+
+    return (index_x < this->game_x && index_y < this->game_y);
+}
+
+int MineGridUI::InitTexture()
+{
+    // a zoom step seen before costs a lookup, a new one a rasterization or a read of the disk cache
+    if (this->cell_size != this->atlas_tile_size) {
+        this->SelectAtlas();
+    }
+
+    if (this->grid_texture == NULL) {
+        SDL_Texture *t;
+
+        // get grid_texture, the size of the view
+        if (this->software) {
+            t = this->window->CreateStreamingTexture(this->view_width, this->view_height);
+        } else {
+            t = this->window->CreateTexture(this->view_width, this->view_height);
+        }
+
+        if (t == NULL) {
+            return -1;
+        }
+
+        this->grid_texture = t;
     }
 
-    return 0;
-}
+    // draw the grids in the view straight from the game, the cost follows the view and not the board
+    MineGameView view = this->window->GameGetView();
+    int x1, y1, x2, y2;
 
-////////////////////////////////////////////////////////////////////////////////////
-MineGridUI::MineGridUI(MineGameWindowUI *window)
-{
-    this->window = window;
+    this->GetVisibleRange(x1, y1, x2, y2);
+    x2 = std::min(x2, view.GetWidth());
+    y2 = std::min(y2, view.GetHeight());
 
-    this->mine = new SDL_Texture * [9];
-    this->mine_covered = NULL;
-    this->mine_flagged = NULL;
-    this->mine_open_black = NULL;
-    this->mine_open_red = NULL;
+    // background around a board smaller than the view
+    if (this->software) {
+        this->pixels.assign((size_t)this->view_width * this->view_height, MINE_GRID_BACKGROUND_PIXEL);
+        this->pixels_dirty.x = 0;
+        this->pixels_dirty.y = 0;
+        this->pixels_dirty.w = this->view_width;
+        this->pixels_dirty.h = this->view_height;
+    } else {
+        this->window->ClearTexture(this->grid_texture);
+    }
 
-    this->game_x = 9;
-    this->game_y = 9;
+    for (int i = y1; i < y2; i++) {
+        for (int j = x1; j < x2; j++) {
+            this->AddGrid(j, i, view.GetGridState(j, i));
+        }
+    }
 
-    this->rect = new SDL_Rect();
-    this->rect->x = 0;
-    this->rect->y = 0;
-    this->rect->w = this->game_x * MINE_GRID_MINE_SIZE + MINE_GRID_EDGE_MARGIN * 2;
-    this->rect->h = this->game_y * MINE_GRID_MINE_SIZE + MINE_GRID_EDGE_MARGIN * 2;
+    this->window->CountDrawnGrids(std::max(0, x2 - x1) * std::max(0, y2 - y1));
 
-    this->grid_texture = NULL;
+    return this->DrawGrids();
 }
 
-MineGridUI::~MineGridUI()
+void MineGridUI::AddGrid(int x, int y, MineGameGrid::State state)
 {
-    this->ReleaseResources();
+    if (state < 0 || state >= MINE_GRID_ATLAS_TILE_COUNT) {
+        std::cerr << "MineGridUI::AddGrid: unknown grid state " << state << std::endl;
+        return;
+    }
 
-    delete [] this->mine;
-    delete this->rect;
-}
+    if (this->software) {
+        this->BlitTile(x, y, state);
+        return;
+    }
 
-void MineGridUI::SetLocation(int x, int y)
-{
-    this->rect->x = x;
-    this->rect->y = y;
+    SDL_Rect tile = MineGridAtlasRect(state, this->atlas_tile_size);
+    float atlas_width = (float)(this->atlas_tile_size * MINE_GRID_ATLAS_COLUMNS);
+    float atlas_height = (float)(this->atlas_tile_size * MINE_GRID_ATLAS_ROWS);
+    float x1 = (float)(x * this->cell_size - this->view_x);
+    float y1 = (float)(y * this->cell_size - this->view_y);
+    float x2 = x1 + this->cell_size;
+    float y2 = y1 + this->cell_size;
+    float u1 = (float)tile.x / atlas_width;
+    float v1 = (float)tile.y / atlas_height;
+    float u2 = (float)(tile.x + tile.w) / atlas_width;
+    float v2 = (float)(tile.y + tile.h) / atlas_height;
+    int base = (int)this->vertices.size();
+    SDL_Vertex vertex;
+
+    vertex.color.r = 255;
+    vertex.color.g = 255;
+    vertex.color.b = 255;
+    vertex.color.a = 255;
+
+    // corners: top left, top right, bottom left, bottom right
+    vertex.position.x = x1; vertex.position.y = y1; vertex.tex_coord.x = u1; vertex.tex_coord.y = v1;
+    this->vertices.push_back(vertex);
+    vertex.position.x = x2; vertex.position.y = y1; vertex.tex_coord.x = u2; vertex.tex_coord.y = v1;
+    this->vertices.push_back(vertex);
+    vertex.position.x = x1; vertex.position.y = y2; vertex.tex_coord.x = u1; vertex.tex_coord.y = v2;
+    this->vertices.push_back(vertex);
+    vertex.position.x = x2; vertex.position.y = y2; vertex.tex_coord.x = u2; vertex.tex_coord.y = v2;
+    this->vertices.push_back(vertex);
+
+    this->indices.push_back(base);
+    this->indices.push_back(base + 1);
+    this->indices.push_back(base + 2);
+    this->indices.push_back(base + 2);
+    this->indices.push_back(base + 1);
+    this->indices.push_back(base + 3);
 }
 
-void MineGridUI::SetGameSize(int x, int y)
+int MineGridUI::DrawGrids()
 {
-    std::cout << "MineGridUI::SetGridSize(x=" << x << ", y=" << y << ")" << std::endl;
-
-    if (this->game_x != x || this->game_y != y) {
-        this->game_x = x;
-        this->game_y = y;
+    int result = 0;
 
-        this->rect->w = this->game_x * MINE_GRID_MINE_SIZE + MINE_GRID_EDGE_MARGIN * 2;
-        this->rect->h = this->game_y * MINE_GRID_MINE_SIZE + MINE_GRID_EDGE_MARGIN * 2;
+    if (this->software) {
+        return this->UploadPixels();
+    }
 
-        if (this->grid_texture != NULL) {
-            SDL_DestroyTexture(this->grid_texture);
-            this->grid_texture = NULL;
-        }
+    if (!this->indices.empty() && this->atlas != NULL) {
+        result = this->window->UpdateTextureGeometry(this->grid_texture, this->atlas, this->vertices, this->indices);
     }
 
-    // set game size will always trigger redraw
-    this->InitTexture();
-}
+    // capacity is kept for the next batch
+    this->vertices.clear();
+    this->indices.clear();
 
-const SDL_Rect *MineGridUI::GetRect() const
-{
-    return this->rect;
+    return result;
 }
 
-int MineGridUI::GetWidth() const
+SDL_Surface *MineGridUI::CreateAtlasSurface(int size)
 {
-    return this->GetRect()->w;
-}
+    SDL_Surface *surface;
 
-int MineGridUI::GetHeight() const
-{
-    return this->GetRect()->h;
+    surface = SDL_CreateRGBSurfaceWithFormat(0, size * MINE_GRID_ATLAS_COLUMNS, size * MINE_GRID_ATLAS_ROWS, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (surface == NULL) {
+        std::cerr << "SDL_CreateRGBSurfaceWithFormat failed with error: " << SDL_GetError() << std::endl;
+    }
+
+    return surface;
 }
 
-int MineGridUI::LoadResources()
+int MineGridUI::AddAtlas(int size, SDL_Surface *surface)
 {
-    this->mine[0] = this->window->LoadTextureFromFile("./images/png/type0.png");
-    this->mine[1] = this->window->LoadTextureFromFile("./images/png/type1.png");
-    this->mine[2] = this->window->LoadTextureFromFile("./images/png/type2.png");
-    this->mine[3] = this->window->LoadTextureFromFile("./images/png/type3.png");
-    this->mine[4] = this->window->LoadTextureFromFile("./images/png/type4.png");
-    this->mine[5] = this->window->LoadTextureFromFile("./images/png/type5.png");
-    this->mine[6] = this->window->LoadTextureFromFile("./images/png/type6.png");
-    this->mine[7] = this->window->LoadTextureFromFile("./images/png/type7.png");
-    this->mine[8] = this->window->LoadTextureFromFile("./images/png/type8.png");
-    this->mine_covered = this->window->LoadTextureFromFile("./images/png/closed.png");
-    this->mine_flagged = this->window->LoadTextureFromFile("./images/png/flag.png");
-    this->mine_flagged_wrong = this->window->LoadTextureFromFile("./images/png/mine_wrong.png");
-    this->mine_open_black = this->window->LoadTextureFromFile("./images/png/mine.png");
-    this->mine_open_red = this->window->LoadTextureFromFile("./images/png/mine_red.png");
+    // the software backend scales its tiles from the surface, the GPU never sees the atlas
+    if (this->software) {
+        this->atlas_surfaces[size] = surface;
+        return 0;
+    }
 
-    this->InitTexture();
+    SDL_Texture *texture = this->window->CreateTextureFromSurface(surface);
+
+    SDL_FreeSurface(surface);
+
+    if (texture == NULL) {
+        return -1;
+    }
+
+    this->atlas_textures[size] = texture;
 
     return 0;
 }
 
-void MineGridUI::ReleaseResources()
+void MineGridUI::SelectAtlas()
 {
-    for (int i = 0; i < 9; i++) {
-        if (this->mine[i] != NULL) {
-            SDL_DestroyTexture(this->mine[i]);
-            this->mine[i] = NULL;
-        }
-    }
+    int size = this->cell_size;
+    bool known = this->software ? (this->atlas_surfaces.count(size) != 0) : (this->atlas_textures.count(size) != 0);
 
-    if (this->mine_covered != NULL) {
-        SDL_DestroyTexture(this->mine_covered);
-        this->mine_covered = NULL;
+    // nothing before LoadResources, the png atlas comes first
+    if (this->atlas_surfaces.count(MINE_GRID_ATLAS_PNG) == 0 && this->atlas_textures.count(MINE_GRID_ATLAS_PNG) == 0) {
+        return;
     }
 
-    if (this->mine_flagged != NULL) {
-        SDL_DestroyTexture(this->mine_flagged);
-        this->mine_flagged = NULL;
-    }
+    if (!known && this->svg_tiles) {
+        SDL_Surface *surface = this->LoadAtlas(size);
 
-    if (this->mine_flagged_wrong != NULL) {
-        SDL_DestroyTexture(this->mine_flagged_wrong);
-        this->mine_flagged_wrong = NULL;
+        // NOTE: one failure is enough, every zoom step would fail the same way
+        if (surface == NULL || this->AddAtlas(size, surface) != 0) {
+            this->svg_tiles = false;
+        } else {
+            known = true;
+        }
     }
 
-    if (this->mine_open_black != NULL) {
-        SDL_DestroyTexture(this->mine_open_black);
-        this->mine_open_black = NULL;
+    if (!known) {
+        size = MINE_GRID_ATLAS_PNG;
     }
 
-    if (this->mine_open_red != NULL) {
-        SDL_DestroyTexture(this->mine_open_red);
-        this->mine_open_red = NULL;
-    }
+    if (this->software) {
+        std::map<int, SDL_Surface*>::iterator it = this->atlas_surfaces.find(size);
 
-    if (this->grid_texture != NULL) {
-        SDL_DestroyTexture(this->grid_texture);
-        this->grid_texture = NULL;
-    }
-}
+        if (it == this->atlas_surfaces.end()) {
+            return;
+        }
 
-int MineGridUI::Redraw()
-{
-    this->window->UpdateWindowTexture(this->grid_texture, this->GetRect());
+        this->atlas_surface = it->second;
+        this->tiles_cell_size = 0;
+    } else {
+        std::map<int, SDL_Texture*>::iterator it = this->atlas_textures.find(size);
 
-    return 0;
+        if (it == this->atlas_textures.end()) {
+            return;
+        }
+
+        this->atlas = it->second;
+    }
+
+    // the png atlas is never the exact size, it is looked up again at the next zoom
+    this->atlas_tile_size = (size == MINE_GRID_ATLAS_PNG) ? MINE_GRID_ATLAS_TILE_SIZE : size;
 }
 
-int MineGridUI::HandleMouseMotionEvent(SDL_MouseMotionEvent *event)
+SDL_Surface *MineGridUI::LoadAtlas(int size)
 {
-    int x1, x2, y1, y2, last_x, last_y;
-    bool start_in, end_in;
+    Uint64 start = SDL_GetPerformanceCounter();
+    std::string path, temp;
+    SDL_Surface *surface = NULL;
+    bool cached = false;
 
-    x1 = this->GetRect()->x;
-    x2 = this->GetRect()->x + this->GetRect()->w;
-    y1 = this->GetRect()->y;
-    y2 = this->GetRect()->y + this->GetRect()->h;
-    last_x = event->x - event->xrel;
-    last_y = event->y - event->yrel;
+    if (!this->atlas_cache_path.empty()) {
+        path = this->atlas_cache_path + "grid-atlas-v" + std::to_string(MINE_GRID_ATLAS_CACHE_VERSION) + "-" + std::to_string(size) + ".bmp";
+        surface = SDL_LoadBMP(path.c_str());
+    }
 
-    start_in = (x1 <= last_x && last_x < x2 && y1 <= last_y && last_y < y2);
-    end_in = (x1 <= event->x && event->x < x2 && y1 <= event->y && event->y < y2);
+    // a cache file of another size or format is rasterized again
+    if (surface != NULL) {
+        SDL_Surface *converted = NULL;
 
-    // leaving component
-    if (start_in && !end_in) {
-        /*
-        std::cout << "SDL_MouseMotionEvent: ";
-        std::cout << "type = SDL_MOUSEMOTION";
-        std::cout << ", state = " << event->state;
-        std::cout << ", x = " << event->x << ", y = " << event->y;
-        std::cout << ", xrel = " << event->xrel << ", yrel = " << event->yrel;
-        std::cout << ", type = leaving" << std::endl;
-        */
+        if (surface->w == size * MINE_GRID_ATLAS_COLUMNS && surface->h == size * MINE_GRID_ATLAS_ROWS) {
+            converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+        }
+
+        SDL_FreeSurface(surface);
+        surface = converted;
+        cached = (surface != NULL);
     }
-    // entering component
-    else if (!start_in && end_in) {
-        /*
-        std::cout << "SDL_MouseMotionEvent: ";
-        std::cout << "type = SDL_MOUSEMOTION";
-        std::cout << ", state = " << event->state;
-        std::cout << ", x = " << event->x << ", y = " << event->y;
-        std::cout << ", xrel = " << event->xrel << ", yrel = " << event->yrel;
-        std::cout << ", type = entering" << std::endl;
-        */
-    } else {
-        /*
-        std::cout << "SDL_MouseMotionEvent: ";
-        std::cout << "type = SDL_MOUSEMOTION";
-        std::cout << ", state = " << event->state;
-        std::cout << ", x = " << event->x << ", y = " << event->y;
-        std::cout << ", xrel = " << event->xrel << ", yrel = " << event->yrel;
-        std::cout << ", type = ???" << std::endl;
-        */
+
+    if (surface == NULL) {
+        surface = this->RasterizeAtlas(size);
+        if (surface == NULL) {
+            return NULL;
+        }
+
+        // written next to it first, a reader never sees half a file
+        if (!path.empty()) {
+            temp = path + ".tmp";
+
+            if (SDL_SaveBMP(surface, temp.c_str()) != 0) {
+                std::cerr << "SDL_SaveBMP(" << temp << ") failed with error: " << SDL_GetError() << std::endl;
+            } else {
+                remove(path.c_str());
+
+                if (rename(temp.c_str(), path.c_str()) != 0) {
+                    std::cerr << "MineGridUI: cannot rename " << temp << " to " << path << std::endl;
+                    remove(temp.c_str());
+                }
+            }
+        }
     }
 
-    return 0;
+    Uint64 elapse = SDL_GetPerformanceCounter() - start;
+
+    std::cout << "MineGridUI: " << size << "px tiles " << (cached ? "read from the cache" : "rasterized") << " in "
+              << (elapse * 1000000 / SDL_GetPerformanceFrequency()) << "us" << std::endl;
+
+    return surface;
 }
 
-int MineGridUI::HandleMouseButtonEvent(SDL_MouseButtonEvent *event)
+SDL_Surface *MineGridUI::RasterizeAtlas(int size)
 {
-    int x1, x2, y1, y2;
+#if SDL_IMAGE_VERSION_ATLEAST(2, 6, 0)
+    SDL_Surface *surface = this->CreateAtlasSurface(size);
 
-    x1 = this->GetRect()->x;
-    x2 = this->GetRect()->x + this->GetRect()->w;
-    y1 = this->GetRect()->y;
-    y2 = this->GetRect()->y + this->GetRect()->h;
+    if (surface == NULL) {
+        return NULL;
+    }
 
-    if (x1 <= event->x && event->x < x2 && y1 <= event->y && event->y < y2) {
-/*
-        std::cout << "SDL_MouseButtonEvent: ";
-        std::cout << "type = " << ((event->type == SDL_MOUSEBUTTONDOWN) ? "SDL_MOUSEBUTTONDOWN" : "SDL_MOUSEBUTTONUP");
-        std::cout << ", button = " << (int)event->button;
-        std::cout << ", state = " << (event->state == SDL_PRESSED) ? "SDL_PRESSED" : "SDL_RELEASED";
-        std::cout << ", clicks = " << (int)event->clicks << std::endl;
-*/
-        if (event->x - x1 > MINE_GRID_EDGE_MARGIN && event->y - y1 > MINE_GRID_EDGE_MARGIN) {
-            int index_x = (event->x - x1) / MINE_GRID_MINE_SIZE;
-            int index_y = (event->y - y1) / MINE_GRID_MINE_SIZE;
+    for (int i = 0; i < MINE_GRID_ATLAS_TILE_COUNT; i++) {
+        SDL_RWops *rw = SDL_RWFromFile(mine_grid_svg_files[i], "rb");
+        SDL_Rect rect = MineGridAtlasRect(i, size);
+        SDL_Surface *tile = NULL;
 
-            if (event->button == SDL_BUTTON_LEFT && event->type == SDL_MOUSEBUTTONUP) {
-                this->window->GameOpen(index_x, index_y);
-            } else if (event->button == SDL_BUTTON_RIGHT && event->type == SDL_MOUSEBUTTONUP) {
-                this->window->GameTouchFlag(index_x, index_y);
-            }   
+        if (rw != NULL) {
+            tile = IMG_LoadSizedSVG_RW(rw, size, size);
+            SDL_RWclose(rw);
+        }
+
+        if (tile == NULL) {
+            std::cerr << "IMG_LoadSizedSVG_RW(" << mine_grid_svg_files[i] << ") failed with error: " << SDL_GetError() << std::endl;
+            SDL_FreeSurface(surface);
+            return NULL;
+        }
+
+        // copy alpha as is, a tile of another size (not square art) is fitted to the cell
+        SDL_SetSurfaceBlendMode(tile, SDL_BLENDMODE_NONE);
 
-            this->RedrawDirtyGrids();
+        if (SDL_BlitScaled(tile, NULL, surface, &rect) != 0) {
+            std::cerr << "SDL_BlitScaled failed with error: " << SDL_GetError() << std::endl;
         }
+
+        SDL_FreeSurface(tile);
     }
-  
-    return 0;
+
+    return surface;
+#else
+    std::cerr << "MineGridUI: SDL_image " << SDL_IMAGE_MAJOR_VERSION << "." << SDL_IMAGE_MINOR_VERSION << " cannot rasterize svg at a size, tiles are scaled" << std::endl;
+
+    return NULL;
+#endif
 }
 
-int MineGridUI::InitTexture()
+void MineGridUI::ScaleTiles()
 {
-    if (this->grid_texture == NULL) {
-        SDL_Texture *t;
-
-        // get grid_texture 
-        t = this->window->CreateTexture(this->GetWidth(), this->GetHeight());
-        if (t == NULL) {
-            return -1;
-        }
+    SDL_Surface *tile;
+    int cell = this->cell_size;
 
-        this->grid_texture = t;
+    tile = SDL_CreateRGBSurfaceWithFormat(0, cell, cell, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (tile == NULL) {
+        std::cerr << "SDL_CreateRGBSurfaceWithFormat failed with error: " << SDL_GetError() << std::endl;
+        return;
     }
 
-    // draw grid_texture with mines
-    for (int i = 0; i < this->game_y; i++) {
-        for (int j = 0; j < this->game_x; j++) {
-            SDL_Rect rect;
+    this->tiles.assign((size_t)MINE_GRID_ATLAS_TILE_COUNT * cell * cell, MINE_GRID_BACKGROUND_PIXEL);
+
+    // each tile blended onto the background once, so drawing one is a plain copy of its rows
+    SDL_SetSurfaceBlendMode(this->atlas_surface, SDL_BLENDMODE_BLEND);
+
+    for (int i = 0; i < MINE_GRID_ATLAS_TILE_COUNT; i++) {
+        SDL_Rect src = MineGridAtlasRect(i, this->atlas_tile_size);
+
+        SDL_FillRect(tile, NULL, MINE_GRID_BACKGROUND_PIXEL);
+
+        if (SDL_BlitScaled(this->atlas_surface, &src, tile, NULL) != 0) {
+            std::cerr << "SDL_BlitScaled failed with error: " << SDL_GetError() << std::endl;
+            continue;
+        }
 
-            rect.x = j * MINE_GRID_MINE_SIZE + 2;
-            rect.y = i * MINE_GRID_MINE_SIZE + 2;
-            rect.w = MINE_GRID_MINE_SIZE;
-            rect.h = MINE_GRID_MINE_SIZE;
+        SDL_LockSurface(tile);
 
-            this->window->UpdateTexture(this->grid_texture, this->mine_covered, &rect);
+        for (int y = 0; y < cell; y++) {
+            // NOTE: rows can be padded, pitch is in bytes
+            std::memcpy(&this->tiles[((size_t)i * cell + y) * cell], (const Uint8*)tile->pixels + y * tile->pitch, cell * sizeof(Uint32));
         }
+
+        SDL_UnlockSurface(tile);
     }
 
-    return 0;
+    SDL_FreeSurface(tile);
+
+    this->tiles_cell_size = cell;
 }
 
-int MineGridUI::RedrawDirtyGrids()
+void MineGridUI::BlitTile(int x, int y, MineGameGrid::State state)
 {
-    std::vector<MineGameGrid> grids;
+    if (this->atlas_surface == NULL) {
+        return;
+    }
 
-    this->window->GameGetDirtyGrids(grids);
+    if (this->tiles_cell_size != this->cell_size) {
+        this->ScaleTiles();
+    }
 
-    for (size_t i = 0; i < grids.size(); i++) {
-        SDL_Rect rect;
+    int cell = this->cell_size;
+    const Uint32 *tile = &this->tiles[(size_t)state * cell * cell];
 
-        rect.x = grids[i].x * MINE_GRID_MINE_SIZE + MINE_GRID_EDGE_MARGIN;
-        rect.y = grids[i].y * MINE_GRID_MINE_SIZE + MINE_GRID_EDGE_MARGIN;
-        rect.w = MINE_GRID_MINE_SIZE;
-        rect.h = MINE_GRID_MINE_SIZE;
+    // the tile in the view, cut at the view edges
+    int left = x * cell - this->view_x;
+    int top = y * cell - this->view_y;
+    int x1 = std::max(left, 0);
+    int y1 = std::max(top, 0);
+    int x2 = std::min(left + cell, this->view_width);
+    int y2 = std::min(top + cell, this->view_height);
 
-        std::cout << "MineGridUI: redraw grid with state = " << grids[i].state <<" at (" << grids[i].x << ", " << grids[i].y << ")" << std::endl;
+    if (x1 >= x2 || y1 >= y2) {
+        return;
+    }
 
-        switch (grids[i].state) {
-        case MineGameGrid::State::STATE_COVERED:
-            this->window->UpdateTexture(this->grid_texture, this->mine_covered, &rect);
-            break;
+    for (int row = y1; row < y2; row++) {
+        std::memcpy(&this->pixels[(size_t)row * this->view_width + x1], tile + (row - top) * cell + (x1 - left), (x2 - x1) * sizeof(Uint32));
+    }
 
-        case MineGameGrid::State::STATE_FLAGGED:
-            this->window->UpdateTexture(this->grid_texture, this->mine_flagged, &rect);
-            break;
+    SDL_Rect drawn;
 
-        case MineGameGrid::State::STATE_FLAGGED_WRONG:
-            this->window->UpdateTexture(this->grid_texture, this->mine_flagged_wrong, &rect);
-            break;
+    drawn.x = x1;
+    drawn.y = y1;
+    drawn.w = x2 - x1;
+    drawn.h = y2 - y1;
 
-        case MineGameGrid::State::STATE_MINE_EXPLODE:
-            this->window->UpdateTexture(this->grid_texture, this->mine_open_red, &rect);
-            break;
+    if (this->pixels_dirty.w == 0) {
+        this->pixels_dirty = drawn;
+    } else {
+        SDL_UnionRect(&this->pixels_dirty, &drawn, &this->pixels_dirty);
+    }
+}
 
-        case MineGameGrid::State::STATE_MINE_OPEN:
-            this->window->UpdateTexture(this->grid_texture, this->mine_open_black, &rect);
-            break;
+int MineGridUI::UploadPixels()
+{
+    const SDL_Rect &dirty = this->pixels_dirty;
+    int result;
 
-        case MineGameGrid::State::STATE_MINE_0:
-            this->window->UpdateTexture(this->grid_texture, this->mine[0], &rect);
-            break;
+    if (dirty.w == 0 || this->grid_texture == NULL) {
+        return 0;
+    }
 
-        case MineGameGrid::State::STATE_MINE_1:
-            this->window->UpdateTexture(this->grid_texture, this->mine[1], &rect);
-            break;
+    // only the part drawn since the last upload
+    result = this->window->UpdateTexturePixels(this->grid_texture, &dirty, &this->pixels[(size_t)dirty.y * this->view_width + dirty.x],
+                                               this->view_width * (int)sizeof(Uint32));
 
-        case MineGameGrid::State::STATE_MINE_2:
-            this->window->UpdateTexture(this->grid_texture, this->mine[2], &rect);
-            break;
+    this->pixels_dirty.w = 0;
+    this->pixels_dirty.h = 0;
 
-        case MineGameGrid::State::STATE_MINE_3:
-            this->window->UpdateTexture(this->grid_texture, this->mine[3], &rect);
-            break;
+    return result;
+}
 
-        case MineGameGrid::State::STATE_MINE_4:
-            this->window->UpdateTexture(this->grid_texture, this->mine[4], &rect);
-            break;
+int MineGridUI::RedrawDirtyGrids()
+{
+    std::vector<MineGameGrid> grids;
+    Uint64 start = SDL_GetPerformanceCounter();
+    int x1, y1, x2, y2, drawn = 0;
+    int min_x = 0, min_y = 0, max_x = -1, max_y = -1;
 
-        case MineGameGrid::State::STATE_MINE_5:
-            this->window->UpdateTexture(this->grid_texture, this->mine[5], &rect);
-            break;
+    // the whole delta of the last move (a cascade or an end of game reveal) is drawn in one call,
+    // grids out of the view are skipped, the view is drawn from the game when it moves
+    this->window->GameGetDirtyGrids(grids);
+    this->GetVisibleRange(x1, y1, x2, y2);
 
-        case MineGameGrid::State::STATE_MINE_6:
-            this->window->UpdateTexture(this->grid_texture, this->mine[6], &rect);
-            break;
+    for (size_t i = 0; i < grids.size(); i++) {
+        if (x1 <= grids[i].x && grids[i].x < x2 && y1 <= grids[i].y && grids[i].y < y2) {
+            this->AddGrid(grids[i].x, grids[i].y, grids[i].state);
+
+            min_x = (drawn == 0 || grids[i].x < min_x) ? grids[i].x : min_x;
+            min_y = (drawn == 0 || grids[i].y < min_y) ? grids[i].y : min_y;
+            max_x = (drawn == 0 || grids[i].x > max_x) ? grids[i].x : max_x;
+            max_y = (drawn == 0 || grids[i].y > max_y) ? grids[i].y : max_y;
+            drawn++;
+        }
+    }
 
-        case MineGameGrid::State::STATE_MINE_7:
-            this->window->UpdateTexture(this->grid_texture, this->mine[7], &rect);
-            break;
+    this->DrawGrids();
+    this->window->CountDrawnGrids(drawn);
 
-        case MineGameGrid::State::STATE_MINE_8:
-            this->window->UpdateTexture(this->grid_texture, this->mine[8], &rect);
-            break;
+    Uint64 elapse = SDL_GetPerformanceCounter() - start;
 
-        default:
-            std::cerr << "MineGridUI::RedrawDirtyGrids: unknown grid state " << grids[i].state << std::endl;
-            break;
-        }
+    if (this->window->HasStats()) {
+        std::cout << "MineGridUI: redraw " << drawn << " of " << grids.size() << " dirty grids in " << (elapse * 1000000 / SDL_GetPerformanceFrequency()) << "us" << std::endl;
     }
 
-    this->Redraw();
+    // only the box around the redrawn grids goes to the window, one flag is one grid
+    if (drawn > 0) {
+        SDL_Rect src, dst, view_rect;
+
+        view_rect.x = 0;
+        view_rect.y = 0;
+        view_rect.w = this->view_width;
+        view_rect.h = this->view_height;
+
+        src.x = min_x * this->cell_size - this->view_x;
+        src.y = min_y * this->cell_size - this->view_y;
+        src.w = (max_x - min_x + 1) * this->cell_size;
+        src.h = (max_y - min_y + 1) * this->cell_size;
+
+        if (SDL_IntersectRect(&src, &view_rect, &src)) {
+            dst = src;
+            dst.x += this->GetRect()->x + MINE_GRID_EDGE_MARGIN;
+            dst.y += this->GetRect()->y + MINE_GRID_EDGE_MARGIN;
+
+            this->window->UpdateWindowTextureRect(this->grid_texture, &src, &dst);
+        }
+    }
 
     return 0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////
+#ifdef __MINGW32__
+
 // FIXME: remove global
 static HMENU global_menubar;
 static HMENU global_menu;
@@ -1463,3 +4055,28 @@ void MineGameMenuBar::CheckItem(int id)
         }
     }
 }
+
+#else
+
+// the level menu is Win32 only
+MineGameMenuBar::MineGameMenuBar(MineGameWindowUI *window)
+{
+    this->window = window;
+}
+
+MineGameMenuBar::~MineGameMenuBar()
+{
+
+}
+
+int MineGameMenuBar::AttachMenu()
+{
+    return 0;
+}
+
+void MineGameMenuBar::CheckItem(int id)
+{
+
+}
+
+#endif
@@ -1,5 +1,16 @@
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include "sdl_headers.h"
 #include "game.h"
+#include "share.h"
+#include "spsc.h"
+#include "script.h"
+#include "layout.h"
 
 #ifndef __MINE_UI_H__
 #define __MINE_UI_H__
@@ -9,30 +20,246 @@ class FaceButtonUI;
 class MineGridUI;
 class SplashScreen;
 class MineGameMenuBar;
+class MineGameWindowUI;
 
+class MineTimerWheel;
+
+// a periodic timer of the UI loop, fired by MineTimerWheel::TakeExpired on the loop thread
 class MineGameTimer {
     public:
-        MineGameTimer();
+        MineGameTimer(MineTimerWheel *wheel);
         ~MineGameTimer();
 
+        // fires every millisecond ms until Remove, does nothing when already running
         int Add(Uint32 millisecond);
         void Remove();
 
-        SDL_TimerID GetId() const;
-        Uint32 GetEventId() const;
+        bool IsActive() const;
         Uint32 GetInterval() const;
         Uint32 GetTickCount() const;
         Uint64 GetStartTick() const;
 
     private:
-        static Uint32 TimerCallback(Uint32 interval, void *param);
+        friend class MineTimerWheel;
 
-    private:
+        MineTimerWheel *wheel;
         Uint32 interval;
-        SDL_TimerID timer_id;
-        Uint32 event_id;
         Uint32 tick_count;
         Uint64 start_tick;
+
+        // place in the wheel: list of slot (-1 when not scheduled), full turns left, and the tick it is due at
+        MineGameTimer *prev;
+        MineGameTimer *next;
+        int slot;
+        Uint32 rounds;
+        Uint64 due;
+};
+
+#define MINE_TIMER_WHEEL_SLOTS 256
+
+// hashed timer wheel of 1ms slots (SDL_GetTicks64), a timer further out than one turn waits for its rounds
+// adding and removing a timer is O(1), moving the wheel costs one slot per elapsed millisecond
+// everything runs on the loop thread, there are no SDL timers and no events pushed across threads
+class MineTimerWheel {
+    public:
+        MineTimerWheel();
+        ~MineTimerWheel();
+
+        // ms until the next timer is due, 0 when one is, -1 when none is active, so an idle loop can block
+        int GetTimeout(Uint64 now);
+        // moves the wheel to now and returns a due timer, already rescheduled for its next tick, NULL when none is due
+        MineGameTimer *TakeExpired(Uint64 now);
+
+    private:
+        friend class MineGameTimer;
+
+        void Schedule(MineGameTimer *timer, Uint32 delay);
+        void Link(MineGameTimer *timer, int slot);
+        void Unlink(MineGameTimer *timer);
+        void Advance(Uint64 now);
+
+    private:
+        // the last list holds due timers not taken yet
+        MineGameTimer *slots[MINE_TIMER_WHEEL_SLOTS + 1];
+        // the tick the wheel was moved to
+        Uint64 current;
+        int active_count;
+};
+
+// a request to the logic thread, see MineGameWorker
+class MineGameCommand {
+    public:
+        enum Op {
+            COMMAND_OPEN = 0,
+            COMMAND_FLAG = 1,
+            COMMAND_CHORD = 2,
+            // a MineGameMove of op count without logging, as a shared board sends them
+            COMMAND_MOVE = 3,
+            COMMAND_RESET = 4,
+            // new board of x * y grids and count mines
+            COMMAND_LEVEL = 5,
+            // publish to share after every command from now on, NULL to stop
+            COMMAND_SHARE = 6
+        };
+
+    public:
+        MineGameCommand();
+        ~MineGameCommand();
+
+        Op op;
+        int x;
+        int y;
+        int count;
+        MineSharedBoard *share;
+};
+
+// a change made by the logic thread, applied in order to the render thread's copy of the board
+class MineGameDelta {
+    public:
+        enum Kind {
+            // grid (x, y) is now state
+            DELTA_GRID = 0,
+            // a new or reset board of x * y grids and count mines, every grid covered
+            DELTA_BOARD = 1,
+            // the end of a command, the game is in state with count flags set
+            DELTA_STATUS = 2
+        };
+
+    public:
+        MineGameDelta();
+        ~MineGameDelta();
+
+        Kind kind;
+        int x;
+        int y;
+        int state;
+        int count;
+};
+
+#define MINE_WORKER_COMMAND_QUEUE_SIZE 1024
+#define MINE_WORKER_DELTA_QUEUE_SIZE 65536
+
+// runs MineGame on a logic thread, so a first click on a big board or a long cascade never stalls the event loop
+// commands go in and deltas come out through MineSpscQueue, every command ends with a DELTA_STATUS
+// an SDL event of type wake_event is posted once deltas are waiting, until the render thread calls Rearm
+class MineGameWorker {
+    public:
+        MineGameWorker(MineGame *game, Uint32 wake_event);
+        ~MineGameWorker();
+
+        // the game belongs to the logic thread between Start and Stop
+        void Start();
+        void Stop();
+
+        // render thread only
+        void Submit(const MineGameCommand &command);
+        bool TakeDelta(MineGameDelta &delta);
+        void Rearm();
+        long long GetSubmitCount() const;
+
+    private:
+        void Run();
+        void Execute(const MineGameCommand &command);
+        void PushDelta(const MineGameDelta &delta);
+        void PushDirtyGrids();
+        void Wake();
+
+    private:
+        MineGame *game;
+        MineSharedBoard *share;
+        Uint32 wake_event;
+        MineSpscQueue<MineGameCommand> *commands;
+        MineSpscQueue<MineGameDelta> *deltas;
+        long long submit_count;
+        // scratch of PushDirtyGrids
+        std::vector<MineGameGrid> grids;
+
+        std::thread logic;
+        std::atomic<bool> running;
+        std::atomic<bool> wake_pending;
+
+        // the logic thread sleeps here while no command is queued, Submit wakes it up
+        std::mutex wake_lock;
+        std::condition_variable wake;
+};
+
+// 4 sub-buckets per power of two from 16us, exact below, so a percentile is within 25% of the sample
+#define MINE_LATENCY_EXACT_BUCKETS 16
+#define MINE_LATENCY_SUB_BUCKETS 4
+#define MINE_LATENCY_BUCKETS (MINE_LATENCY_EXACT_BUCKETS + (64 - 4) * MINE_LATENCY_SUB_BUCKETS)
+
+// log-linear histogram of input to present latencies in microseconds, fixed size, no allocation per sample
+class MineLatencyHistogram {
+    public:
+        MineLatencyHistogram();
+        ~MineLatencyHistogram();
+
+        void Add(Uint64 us);
+        void Clear();
+
+        long long GetCount() const;
+        Uint64 GetMax() const;
+        // upper bound of the bucket holding the p-th fraction (0 to 1) of the samples, 0 when empty
+        Uint64 GetPercentile(double p) const;
+
+        // summary then one "<low_us> <high_us> <count>" line per non-empty bucket, returns -1 when path cannot be written
+        int Dump(const char *path) const;
+
+    private:
+        static int GetBucket(Uint64 us);
+        static Uint64 GetBucketLow(int bucket);
+
+    private:
+        long long counts[MINE_LATENCY_BUCKETS];
+        long long count;
+        Uint64 max;
+};
+
+// images of every component, each file decoded once on worker threads,
+// textures created on the render thread on first use and shared by every component asking for the file
+class MineResourceManager {
+    public:
+        MineResourceManager(MineGameWindowUI *window);
+        ~MineResourceManager();
+
+        // before StartDecoding, a file requested twice is decoded once
+        void Request(const char *path);
+        // decodes the requested files on worker threads, returns at once
+        void StartDecoding();
+        void WaitDecoding();
+
+        // render thread only, waits for the decoding, a file that was not requested is decoded here
+        // both are owned by the manager, valid until Release
+        SDL_Texture *GetTexture(const char *path);
+        SDL_Surface *GetSurface(const char *path);
+
+        void Release();
+
+        // decodes one file (baked images from images.h first), thread safe, error is set on NULL
+        static SDL_Surface *DecodeFile(const char *path, std::string &error);
+
+    private:
+        class Entry {
+            public:
+                std::string path;
+                SDL_Surface *surface;
+                SDL_Texture *texture;
+                std::string error;
+        };
+
+        int Find(const char *path);
+        void DecodeWorker();
+
+    private:
+        MineGameWindowUI *window;
+        std::vector<Entry> entries;
+        std::map<std::string, int> index;
+        int request_count;
+
+        // decoding
+        std::vector<std::thread> workers;
+        std::atomic<int> next_entry;
+        Uint64 decode_start;
 };
 
 class MineGameWindowUI {
@@ -44,38 +271,144 @@ class MineGameWindowUI {
         void DestroyComponents();
         int ProcessEvents();
 
+        // SDL_GetPerformanceCounter() at process start, the time to the first presented frame is logged from it
+        // (default: when the window UI is constructed)
+        void SetStartCounter(Uint64 counter);
+        // present in step with the display (SDL_RENDERER_PRESENTVSYNC), before CreateComponents
+        void SetVsync(bool vsync);
+        // draw the grid on the CPU even with an accelerated renderer, before CreateComponents
+        // (default: only when the renderer is not accelerated)
+        void SetSoftwareGrid(bool software);
+
+        // no menu bar, no frame pacing and no per frame stats, for SDL's offscreen or dummy video driver
+        // ProcessEvents plays script one step per frame, quits at its end and reports the run
+        void SetHeadless(bool headless);
+        bool IsHeadless() const;
+        // per frame and per second stats on stdout, off by default because the writes land inside the frame time
+        // they report (the HUD shows the same numbers), never in a headless run
+        void SetStats(bool stats);
+        bool HasStats() const;
+        void SetScript(MineEventScript *script);
+        // the last frame is saved there as a BMP at the end of a headless run, empty for none
+        void SetDumpPath(const std::string &path);
+
+        // overlay of the last frame time, input to present latency and grids redrawn, F3 toggles it
+        void SetHud(bool hud);
+        // the latency histogram is written there when ProcessEvents returns, empty for none
+        void SetLatencyPath(const std::string &path);
+        // grids drawn for the next present, reported by the grid
+        void CountDrawnGrids(int count);
+
+        // publish the board after every event and take moves from its command ring, NULL to stop
+        void SetSharedBoard(MineSharedBoard *share);
+
         // helper function for components
         SDL_Texture *LoadTextureFromFile(const char *path);
+        SDL_Surface *LoadSurfaceFromFile(const char *path);
+        SDL_Texture *CreateTextureFromSurface(SDL_Surface *surface);
+        // shared images, see MineResourceManager, never destroy them
+        SDL_Texture *GetTexture(const char *path);
+        SDL_Surface *GetSurface(const char *path);
         SDL_Texture *CreateTexture(int width, int height);
+        // for pixels written by the CPU, see SDL_LockTexture
+        SDL_Texture *CreateStreamingTexture(int width, int height);
         SDL_Window *GetSDLWindow();
+        // draws texture into the window and marks rect damaged for the next present
         int UpdateWindowTexture(SDL_Texture *texture, const SDL_Rect *rect);
+        // the same from the src part of texture
+        int UpdateWindowTextureRect(SDL_Texture *texture, const SDL_Rect *src, const SDL_Rect *dst);
+        // limits the window updates above to rect, NULL to draw anywhere again
+        void SetWindowClip(const SDL_Rect *rect);
+        // marks a part of the window for the next present, NULL for all of it
+        void DamageWindow(const SDL_Rect *rect);
+        // recomposites the background and every component inside area, NULL for the whole window
+        int RedrawArea(const SDL_Rect *area);
         int UpdateTexture(SDL_Texture *updated_texture, SDL_Texture *texture, const SDL_Rect *rect);
+        // fills texture with the window background
+        int ClearTexture(SDL_Texture *texture);
+        // draws every triangle of vertices / indices from texture onto updated_texture in one call
+        int UpdateTextureGeometry(SDL_Texture *updated_texture, SDL_Texture *texture, const std::vector<SDL_Vertex> &vertices, const std::vector<int> &indices);
+        // copies rect->w * rect->h ARGB8888 pixels, rows pitch bytes apart, into rect of a streaming texture
+        int UpdateTexturePixels(SDL_Texture *texture, const SDL_Rect *rect, const Uint32 *pixels, int pitch);
+        // moves go to the logic thread, what they change comes back through ApplyGameDeltas
         void GameOpen(int x, int y);
         void GameTouchFlag(int x, int y);
+        void GameChord(int x, int y);
         void GameReset();
+        void GameSetLevel(int width, int height, int mine_count);
+        // grids changed since the last call and the board as far as the deltas went, see board
         void GameGetDirtyGrids(std::vector<MineGameGrid> &grids);
+        MineGameView GameGetView();
 
     private:
         int CreateSDLWindow();
         void DestroySDLWindow();
 
+        // limits the grid view to what fits on the screen
+        void SetMaxViewSize();
         int ResizeWindow();
         int RedrawWindow();
         int RefreshWindow();
 
+        int GetRefreshRate();
+        // merges runs of mouse motion in place, returns the number of events left
+        static int CoalesceEvents(SDL_Event *events, int count);
+
         int DispatchEvent(SDL_Event *e);
+        int DispatchTimer(MineGameTimer *timer);
+        void UpdateGameStatus(MineGame::State old_state, int old_flag_count);
+
+        // drains the deltas of the logic thread into board and redraws what changed, returns the deltas applied
+        int ApplyGameDeltas();
+        // waits for every submitted command, for headless runs that must not race the logic thread
+        void SyncGame();
+        void SetBoard(int width, int height, int mine_count);
+        // the UI side of a new game: grid, counters, timer and splash
+        void ResetView();
+        void SubmitCommand(MineGameCommand::Op op, int x, int y, int count);
         int HandleSysWMEvent(SDL_SysWMEvent *e);
-        int HandleTimerEvent(SDL_UserEvent *e);
+        int HandleTimer(MineGameTimer *timer);
+        int HandleShareCommands();
+
+        // headless runs, false once the script is done
+        bool PlayScriptStep();
+        void PlayRandomMove();
+        void PushMouseButton(Uint32 type, Uint8 button, int x, int y);
+        void ReportRun(Uint64 elapse, long long event_count);
+        int DumpFrame(const char *path);
 
         void ShowWinningSplash();
         void StopWinningSplash();
 
+        // where the overlay goes, over the top left of the grid view
+        void GetHudRect(SDL_Rect &rect);
+        void DrawHud();
+        void DrawHudText(int x, int y, const char *text);
+        void ToggleHud();
+
     private:
         // GUI for window
         SDL_Window *window;
         SDL_Renderer *renderer;
         SDL_Texture *window_texture;
-        bool window_texture_dirty;
+        int window_width, window_height;
+        // parts of window_texture changed since the last present, in window coordinates, none overlapping
+        std::vector<SDL_Rect> damage_rects;
+        // clip of the window updates, see SetWindowClip
+        SDL_Rect clip_rect;
+        bool clipping;
+        // the backbuffer keeps its pixels between presents, only damaged parts are copied to it
+        bool retained_backbuffer;
+        bool accelerated;
+        bool software_grid;
+        // draw calls since the last present
+        int draw_call_count;
+        // DamageWindow calls, an input that changed this is waiting for a present
+        Uint64 damage_serial;
+        bool vsync;
+
+        // images shared by the components
+        MineResourceManager *resources;
 
         // components
         MineGridUI *mine_grid;
@@ -85,12 +418,58 @@ class MineGameWindowUI {
         SplashScreen *winning_splash;
         MineGameMenuBar *menu_bar;
 
+        // every timer of the window
+        MineTimerWheel *timer_wheel;
+
         // splash timer
         MineGameTimer *splash_timer;
 
         // count down timer
         MineGameTimer *count_down_timer;
 
+        // shared board and the timer polling its command ring
+        MineSharedBoard *share;
+        MineGameTimer *share_timer;
+
+        // startup time
+        Uint64 start_counter;
+        bool first_frame_presented;
+
+        // headless run: the script, the moves left of its random step, and the time and draw calls of each frame
+        bool headless;
+        MineEventScript *script;
+        MineRandom script_random;
+        int random_left;
+        // where the script put the pointer, and a ctrl or shift it holds for one wheel step
+        int script_pointer_x, script_pointer_y;
+        bool script_modifier;
+        std::string dump_path;
+        std::vector<Uint64> frame_times;
+        std::vector<int> frame_draw_calls;
+
+        // logic thread, and the render thread's copy of the board in the layout of MineGame::GetStateBuffer
+        MineGameWorker *worker;
+        Uint32 wake_event;
+        std::vector<unsigned char> board;
+        int board_width, board_height, board_mine_count, board_flag_count;
+        MineGame::State board_state;
+        std::vector<MineGameGrid> board_dirty;
+        // commands whose deltas are all applied
+        long long board_commands;
+
+        // latency: dequeue time of the oldest input not presented yet (0 for none), the command it waits for, and the samples
+        Uint64 input_counter;
+        long long input_command;
+        MineLatencyHistogram latency;
+        std::string latency_path;
+
+        // overlay, with the time and grids of the frame presented last and the grids of the next one
+        bool hud;
+        bool stats;
+        Uint64 last_frame_time;
+        int last_frame_grids;
+        int frame_grid_count;
+
         // game
         MineGame *game;
 };
@@ -102,6 +481,7 @@ class SplashScreen {
 
         void SetLocation(int x, int y);
 
+        void RequestResources(MineResourceManager *resources);
         int LoadResources();
         void ReleaseResources();
 
@@ -130,16 +510,22 @@ class CounterUI {
         int GetCount() const;
         void IncreaseCount();
 
+        void RequestResources(MineResourceManager *resources);
         int LoadResources();
         void ReleaseResources();
 
         int Redraw();
+        // redraws only the digits changed since the last draw
+        int RedrawChanged();
 
         // event handlers
         int HandleMouseMotionEvent(SDL_MouseMotionEvent *event);
         int HandleMouseButtonEvent(SDL_MouseButtonEvent *event);
         int HandleUserEvent(SDL_UserEvent *event);
 
+    private:
+        void RedrawDigit(const SDL_Rect *rect, int digit, int &drawn_digit);
+
     private:
         // owner window
         MineGameWindowUI *window;
@@ -159,6 +545,11 @@ class CounterUI {
         int digit1;
         int digit2;
         int digit3;
+
+        // digits in the window, -1 before the first draw
+        int drawn_digit1;
+        int drawn_digit2;
+        int drawn_digit3;
 };
 
 class FaceButtonUI {
@@ -182,6 +573,7 @@ class FaceButtonUI {
         void SetStatus(Status status);
         Status GetStatus() const;
 
+        void RequestResources(MineResourceManager *resources);
         int LoadResources();
         void ReleaseResources();
 
@@ -215,39 +607,107 @@ class MineGridUI {
 
         void SetLocation(int x, int y);
         void SetGameSize(int x, int y);
+        // largest view in pixels, a bigger board is scrolled inside it (taken at the next SetGameSize)
+        void SetMaxViewSize(int width, int height);
+        // draw into a CPU pixel buffer streamed to the texture instead of through a render target,
+        // before LoadResources
+        void SetSoftware(bool software);
         const SDL_Rect *GetRect() const;
         int GetWidth() const;
         int GetHeight() const;
 
+        void RequestResources(MineResourceManager *resources);
         int LoadResources();
         void ReleaseResources();
 
         int Redraw();
+        int RedrawDirtyGrids();
 
         // event handlers
         int HandleMouseMotionEvent(SDL_MouseMotionEvent *event);
         int HandleMouseButtonEvent(SDL_MouseButtonEvent *event);
+        int HandleMouseWheelEvent(SDL_MouseWheelEvent *event);
+        int HandleKeyboardEvent(SDL_KeyboardEvent *event);
 
     private:
         int InitTexture(); 
-        int RedrawDirtyGrids();
+
+        // scroll by (dx, dy) pixels, zoom to cell size keeping the board point under view pixel (x, y) in place
+        void ScrollView(int dx, int dy);
+        void ZoomView(int cell_size, int x, int y);
+        // grids [x1, x2) x [y1, y2) at least partly in the view
+        void GetVisibleRange(int &x1, int &y1, int &x2, int &y2) const;
+        // the grid under window point (x, y), false outside the board
+        bool MapPoint(int x, int y, int &index_x, int &index_y) const;
+
+    public:
+        // the window point in the middle of grid (x, y), scrolled into the view first, false outside the board
+        bool GetGridPoint(int x, int y, int &point_x, int &point_y);
+
+    private:
+
+        // queue grid (x, y) for the next DrawGrids, which draws the whole queue in one call
+        void AddGrid(int x, int y, MineGameGrid::State state);
+        int DrawGrids();
+
+        // atlases: an empty one of size x size tiles, one taken over by the cache (a texture unless software),
+        // the one of the current cell size made current, read from the disk cache or rasterized and cached
+        SDL_Surface *CreateAtlasSurface(int size);
+        int AddAtlas(int size, SDL_Surface *surface);
+        void SelectAtlas();
+        SDL_Surface *LoadAtlas(int size);
+        SDL_Surface *RasterizeAtlas(int size);
+
+        // software backend: tiles at the current zoom, one tile into pixels, the dirty part of pixels into grid_texture
+        void ScaleTiles();
+        void BlitTile(int x, int y, MineGameGrid::State state);
+        int UploadPixels();
 
     private:
         // owner window
         MineGameWindowUI *window;
 
-        // mines
-        SDL_Texture **mine;
-        SDL_Texture *mine_covered;
-        SDL_Texture *mine_flagged;
-        SDL_Texture *mine_flagged_wrong;
-        SDL_Texture *mine_open_black;
-        SDL_Texture *mine_open_red;
+        // every grid image in one texture of atlas_tile_size tiles, the tile of a state is MineGridAtlasRect(state, atlas_tile_size)
+        SDL_Texture *atlas;
+        int atlas_tile_size;
+        // every atlas made so far by tile size, MINE_GRID_ATLAS_PNG for the images/png one, owning atlas or atlas_surface
+        std::map<int, SDL_Texture*> atlas_textures;
+        std::map<int, SDL_Surface*> atlas_surfaces;
+        // directory of the disk cache with a trailing separator, empty for none; false once images/svg failed
+        std::string atlas_cache_path;
+        bool svg_tiles;
+
+        // queued grids, two triangles each
+        std::vector<SDL_Vertex> vertices;
+        std::vector<int> indices;
+
+        // software backend: the atlas kept on the CPU, its tiles scaled to tiles_cell_size and blended on the background,
+        // the view as ARGB8888 pixels, and the part of them not uploaded yet
+        bool software;
+        SDL_Surface *atlas_surface;
+        std::vector<Uint32> tiles;
+        int tiles_cell_size;
+        std::vector<Uint32> pixels;
+        SDL_Rect pixels_dirty;
 
         // grid size
         int game_x, game_y;
 
-        // component texture
+        // viewport: pixels per grid (zoom), top left of the view in board pixels, view size and its limit
+        int cell_size;
+        int view_x, view_y;
+        int view_width, view_height;
+        int max_view_width, max_view_height;
+        // middle button held, motion pans the view
+        bool panning;
+        // left and right buttons held, a chord was made with the buttons still held
+        bool left_down;
+        bool right_down;
+        bool chording;
+        // window point of the last motion or button event, the wheel hit test on SDL before 2.26
+        int pointer_x, pointer_y;
+
+        // component texture, the view only, not the whole board
         SDL_Texture *grid_texture;
 
         // component rect